@@ -0,0 +1,212 @@
+#ifndef _BATCHED_QMATRIX_H
+#define _BATCHED_QMATRIX_H
+
+#include "Kernels.hpp"
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include "ThreadPool.hpp"
+#include <stdint.h>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+
+/*
+	Batch of same-shape matrices in one contiguous buffer: matrix k starts at
+	data + k * stride and is row-major with leading dimension ld.
+
+	BatchDecomposeLU / BatchDet factor the whole batch in one call with partial
+	pivoting (P A = L U, L unit lower, U upper, both stored in place like LAPACK getrf).
+	The batch is split across the shared pool; for float and double each worker packs
+	BATCH_LANES matrices into a lane-interleaved scratch block and runs the dispatched
+	kernel that vectorizes across the matrices, which is what pays off at 16 x 16 to
+	64 x 64 where a single matrix is too small to fill the vector units.
+*/
+
+template<typename T>
+class QMatrixBatch {
+public:
+	// owned, zero-initialized storage
+	QMatrixBatch(uint64_t count, uint64_t n, uint64_t m)
+		: storage(SAFE_UINT(count * n * m), static_cast<T>(0)), ext(nullptr),
+		count(count), n(n), m(m), stride(n * m), ld(m) {}
+
+	// wraps a caller buffer, stride and ld default to the packed layout
+	QMatrixBatch(T* data, uint64_t count, uint64_t n, uint64_t m, uint64_t stride = 0, uint64_t ld = 0)
+		: ext(data), count(count), n(n), m(m), stride(stride ? stride : n * (ld ? ld : m)), ld(ld ? ld : m) {
+		if (n > 0 && (this->ld < m || this->stride < (n - 1) * this->ld + m)) {
+			merror("Batch stride or leading dimension too small for the matrix shape!", E_MAT_INVALID_DIMENSION);
+		}
+	}
+
+	uint64_t Count() const noexcept { return count; }
+	uint64_t GetN() const noexcept { return n; }
+	uint64_t GetM() const noexcept { return m; }
+	uint64_t Stride() const noexcept { return stride; }
+	uint64_t Ld() const noexcept { return ld; }
+
+	T* Data() noexcept { return ext ? ext : storage.data(); }
+	const T* Data() const noexcept { return ext ? ext : storage.data(); }
+
+	QMatrixView<T> operator[](uint64_t k) noexcept {
+		return QMatrixView<T>(Data() + SAFE_INT(k * stride), n, m, SAFE_INT(ld), 1);
+	}
+	QMatrixView<const T> operator[](uint64_t k) const noexcept {
+		return QMatrixView<const T>(Data() + SAFE_INT(k * stride), n, m, SAFE_INT(ld), 1);
+	}
+
+	QMatrix<T> Get(uint64_t k) const {
+		return QMatrix<T>((*this)[k]);
+	}
+
+	void Set(uint64_t k, const QMatrix<T>& a) {
+		if (a.GetN() != n || a.GetM() != m) {
+			merror("Matrix does not match the batch shape!", E_MAT_INVALID_DIMENSION);
+			return;
+		}
+		Copy<T>(a.View(), (*this)[k]);
+	}
+
+private:
+	std::vector<T> storage;
+	T* ext;
+	uint64_t count, n, m, stride, ld;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+void _lu_lane_group(QMatrixBatch<T>& a, uint64_t first, uint32_t* piv, typename QMatrix<T>::DetType* det) {
+	constexpr uint64_t W = BATCH_LANES;
+	uint64_t n = a.GetN();
+	uint64_t lanes = a.Count() - first < W ? a.Count() - first : W;
+
+	static thread_local std::vector<T> _tmp_block;
+	static thread_local std::vector<uint32_t> _tmp_piv;
+	_tmp_block.assign(SAFE_UINT(n * n * W), static_cast<T>(0));
+	_tmp_piv.resize(SAFE_UINT(n * W));
+	double _tmp_det[W];
+
+	// unused tail lanes stay identity so they factor without touching the real ones
+	for (uint64_t l = lanes; l < W; ++l) {
+		for (uint64_t i = 0; i < n; ++i) {
+			_tmp_block[(i * n + i) * W + l] = static_cast<T>(1);
+		}
+	}
+	for (uint64_t l = 0; l < lanes; ++l) {
+		QMatrixView<const T> v = a[first + l];
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t j = 0; j < n; ++j) {
+				_tmp_block[(i * n + j) * W + l] = v(i, j);
+			}
+		}
+	}
+
+	if constexpr (std::is_same_v<T, float>) {
+		Kernels().slu_batch(n, _tmp_block.data(), _tmp_piv.data(), _tmp_det);
+	}
+	else {
+		Kernels().dlu_batch(n, _tmp_block.data(), _tmp_piv.data(), _tmp_det);
+	}
+
+	for (uint64_t l = 0; l < lanes; ++l) {
+		QMatrixView<T> v = a[first + l];
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t j = 0; j < n; ++j) {
+				v(i, j) = _tmp_block[(i * n + j) * W + l];
+			}
+			piv[(first + l) * n + i] = _tmp_piv[i * W + l];
+		}
+		det[first + l] = _tmp_det[l];
+	}
+}
+
+/*
+	Factors every matrix of the batch in place, piv receives count * n row indices
+	(piv[k * n + i] was swapped with row i at step i) and the determinants are returned.
+*/
+template<typename T>
+std::vector<typename QMatrix<T>::DetType> BatchDecomposeLU(QMatrixBatch<T>& a, std::vector<uint32_t>& piv,
+	ThreadPool& pool = ThreadPool::Shared()) {
+
+	using D = typename QMatrix<T>::DetType;
+	static_assert(std::is_floating_point_v<T> || _is_complex<T>::value,
+		"Batched LU needs a floating point or complex element type");
+
+	if (a.GetN() != a.GetM()) {
+		merror("Cannot apply LU-decomposition to non-square matrix!", E_MAT_INVALID_DIMENSION);
+		return {};
+	}
+
+	uint64_t n = a.GetN();
+	std::vector<D> det(SAFE_UINT(a.Count()), static_cast<D>(1));
+	piv.resize(SAFE_UINT(a.Count() * n));
+	if (a.Count() == 0 || n == 0) {
+		return det;
+	}
+
+	// at least ~64k multiply-adds per chunk so tiny matrices don't drown in scheduling,
+	// grain counts matrices here and lane groups of BATCH_LANES matrices below
+	uint64_t _flops = n * n * n;
+	uint64_t grain = _flops >= 65536 ? 1 : 65536 / _flops;
+
+	if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+		uint64_t groups = (a.Count() + BATCH_LANES - 1) / BATCH_LANES;
+		pool.ParallelFor(0, groups, [&](uint64_t g) {
+			_lu_lane_group(a, g * BATCH_LANES, piv.data(), det.data());
+		}, grain > BATCH_LANES ? grain / BATCH_LANES : 1);
+	}
+	else {
+		pool.ParallelFor(0, a.Count(), [&](uint64_t k) {
+			det[k] = _lu_pivot_in_place(a[k], piv.data() + k * n);
+		}, grain);
+	}
+	return det;
+}
+
+// determinants only, the batch itself is left untouched
+template<typename T>
+std::vector<typename QMatrix<T>::DetType> BatchDet(const QMatrixBatch<T>& a, ThreadPool& pool = ThreadPool::Shared()) {
+	QMatrixBatch<T> _tmp_lu(a.Count(), a.GetN(), a.GetM());
+	for (uint64_t k = 0; k < a.Count(); ++k) {
+		Copy<T>(a[k], _tmp_lu[k]);
+	}
+	std::vector<uint32_t> piv;
+	return BatchDecomposeLU(_tmp_lu, piv, pool);
+}
+
+// {P, L, U} of one factored matrix with P A = L U
+template<typename T>
+std::array<QMatrix<T>, 3> BatchUnpackLU(const QMatrixBatch<T>& lu, const std::vector<uint32_t>& piv, uint64_t k) {
+	uint64_t n = lu.GetN();
+	std::vector<T> p(SAFE_UINT(n * n), static_cast<T>(0));
+	std::vector<T> l(SAFE_UINT(n * n), static_cast<T>(0));
+	std::vector<T> u(SAFE_UINT(n * n), static_cast<T>(0));
+
+	std::vector<uint64_t> perm(SAFE_UINT(n));
+	for (uint64_t i = 0; i < n; ++i) {
+		perm[i] = i;
+	}
+	for (uint64_t i = 0; i < n; ++i) {
+		std::swap(perm[i], perm[piv[k * n + i]]);
+	}
+
+	QMatrixView<const T> v = lu[k];
+	for (uint64_t i = 0; i < n; ++i) {
+		p[i * n + perm[i]] = static_cast<T>(1);
+		for (uint64_t j = 0; j < n; ++j) {
+			if (j < i) {
+				l[i * n + j] = v(i, j);
+			}
+			else {
+				u[i * n + j] = v(i, j);
+			}
+		}
+		l[i * n + i] = static_cast<T>(1);
+	}
+	return { QMatrix<T>(p.data(), n, n), QMatrix<T>(l.data(), n, n), QMatrix<T>(u.data(), n, n) };
+}
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef _COMPLEX_QMATRIX_H
+#define _COMPLEX_QMATRIX_H
+
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include <stdint.h>
+#include <complex>
+#include <vector>
+
+/*
+	Complex matrix in split storage: separate real and imaginary QMatrix<T>.
+
+	QMatrix<std::complex<T>> keeps interleaved {re, im} pairs and multiplies with the
+	4M complex kernels. The split form instead multiplies with the 3M scheme
+
+	  T1 = Ar Br,  T2 = Ai Bi,  T3 = (Ar + Ai)(Br + Bi)
+	  Re = T1 - T2,  Im = T3 - T1 - T2
+
+	which costs three real GEMMs (dispatched, fully vectorized) instead of four, at the
+	price of slightly weaker rounding on the imaginary part.
+*/
+
+template<typename T>
+class SplitComplexQMatrix {
+public:
+	SplitComplexQMatrix(QMatrix<T> re, QMatrix<T> im) : re(std::move(re)), im(std::move(im)) {
+		if (this->re.GetN() != this->im.GetN() || this->re.GetM() != this->im.GetM()) {
+			merror("Real and imaginary parts must have the same dimensions!", E_MAT_INVALID_DIMENSION);
+			this->im = this->re * static_cast<T>(0);
+		}
+	}
+
+	explicit SplitComplexQMatrix(const QMatrix<std::complex<T>>& a)
+		: re(_part(a, false)), im(_part(a, true)) {}
+
+	uint64_t GetN() const noexcept { return re.GetN(); }
+	uint64_t GetM() const noexcept { return re.GetM(); }
+	const QMatrix<T>& Re() const noexcept { return re; }
+	const QMatrix<T>& Im() const noexcept { return im; }
+
+	std::complex<T> GetItem(uint64_t i, uint64_t j) const {
+		return std::complex<T>(re.GetItem(i, j), im.GetItem(i, j));
+	}
+
+	QMatrix<std::complex<T>> ToQMatrix() const {
+		std::vector<std::complex<T>> _tmp_nums(SAFE_UINT(GetN() * GetM()));
+		QMatrixView<const T> vr = re.View();
+		QMatrixView<const T> vi = im.View();
+		for (uint64_t i = 0; i < GetN(); ++i) {
+			for (uint64_t j = 0; j < GetM(); ++j) {
+				_tmp_nums[i * GetM() + j] = std::complex<T>(vr(i, j), vi(i, j));
+			}
+		}
+		return QMatrix<std::complex<T>>(_tmp_nums.data(), GetN(), GetM());
+	}
+
+	SplitComplexQMatrix<T> Adjoint() const {
+		QMatrix<T> _tmp_im = im.Transpose();
+		_scale(_tmp_im, static_cast<T>(-1));
+		return SplitComplexQMatrix<T>(re.Transpose(), std::move(_tmp_im));
+	}
+
+	friend SplitComplexQMatrix<T> operator*(const SplitComplexQMatrix<T>& a, const SplitComplexQMatrix<T>& b) {
+		if (a.GetM() != b.GetN()) {
+			merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return a;
+		}
+
+		QMatrix<T> t1 = a.re * b.re;
+		QMatrix<T> t2 = a.im * b.im;
+
+		QMatrix<T> sa = a.re;
+		_acc(sa, a.im, static_cast<T>(1));
+		QMatrix<T> sb = b.re;
+		_acc(sb, b.im, static_cast<T>(1));
+		QMatrix<T> t3 = sa * sb;
+
+		// t3 becomes Im, t1 becomes Re
+		_acc(t3, t1, static_cast<T>(-1));
+		_acc(t3, t2, static_cast<T>(-1));
+		_acc(t1, t2, static_cast<T>(-1));
+		return SplitComplexQMatrix<T>(std::move(t1), std::move(t3));
+	}
+
+private:
+	QMatrix<T> re, im;
+
+	static QMatrix<T> _part(const QMatrix<std::complex<T>>& a, bool imag) {
+		std::vector<T> _tmp_nums(SAFE_UINT(a.GetN() * a.GetM()));
+		QMatrixView<const std::complex<T>> v = a.View();
+		for (uint64_t i = 0; i < a.GetN(); ++i) {
+			for (uint64_t j = 0; j < a.GetM(); ++j) {
+				_tmp_nums[i * a.GetM() + j] = imag ? v(i, j).imag() : v(i, j).real();
+			}
+		}
+		return QMatrix<T>(_tmp_nums.data(), a.GetN(), a.GetM());
+	}
+
+	// y += s * x over the whole contiguous storage
+	static void _acc(QMatrix<T>& y, const QMatrix<T>& x, T s) {
+		_axpy<T>(y.GetN() * y.GetM(), s, x.View().Data(), y.View().Data());
+	}
+
+	static void _scale(QMatrix<T>& y, T s) {
+		T* _tmp_data = y.View().Data();
+		for (uint64_t i = 0; i < y.GetN() * y.GetM(); ++i) {
+			_tmp_data[i] *= s;
+		}
+	}
+};
+
+#endif
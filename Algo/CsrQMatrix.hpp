@@ -0,0 +1,158 @@
+#ifndef _CSR_QMATRIX_H
+#define _CSR_QMATRIX_H
+
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include "ThreadPool.hpp"
+#include <stdint.h>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+/*
+	Sparse matrix in compressed sparse row form.
+
+	Row i holds the entries vals[row_ptr[i] .. row_ptr[i + 1]) in the columns
+	col_idx[...], sorted ascending and without duplicates. Multiply splits the rows
+	across the shared pool in chunks of about CSR_CHUNK_NNZ stored entries.
+*/
+
+#define CSR_CHUNK_NNZ 16384
+
+template<typename T>
+class CsrQMatrix {
+public:
+	CsrQMatrix(uint64_t n, uint64_t m) : n(n), m(m), row_ptr(SAFE_UINT(n + 1), 0) {}
+
+	// zeros of a are not stored
+	explicit CsrQMatrix(const QMatrix<T>& a) : CsrQMatrix(a.View()) {}
+	explicit CsrQMatrix(QMatrixView<const T> a) : n(a.GetN()), m(a.GetM()), row_ptr(SAFE_UINT(a.GetN() + 1), 0) {
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t j = 0; j < m; ++j) {
+				if (a(i, j) != static_cast<T>(0)) {
+					col_idx.push_back(j);
+					vals.push_back(a(i, j));
+				}
+			}
+			row_ptr[i + 1] = col_idx.size();
+		}
+	}
+
+	// entries given as (rows[k], cols[k], v[k]), repeated positions are summed
+	static CsrQMatrix<T> FromTriplets(uint64_t n, uint64_t m, const std::vector<uint64_t>& rows,
+		const std::vector<uint64_t>& cols, const std::vector<T>& v) {
+		CsrQMatrix<T> res(n, m);
+		if (rows.size() != cols.size() || rows.size() != v.size()) {
+			merror("Triplet arrays have different lengths!", E_MAT_INVALID_DIMENSION);
+			return res;
+		}
+		for (size_t k = 0; k < rows.size(); ++k) {
+			if (rows[k] >= n || cols[k] >= m) {
+				merror("Triplet index out of range!", E_MAT_INVALID_DIMENSION);
+				return CsrQMatrix<T>(n, m);
+			}
+			++res.row_ptr[rows[k] + 1];
+		}
+		std::partial_sum(res.row_ptr.begin(), res.row_ptr.end(), res.row_ptr.begin());
+
+		std::vector<uint64_t> _tmp_cols(rows.size());
+		std::vector<T> _tmp_vals(rows.size());
+		std::vector<uint64_t> _tmp_next(res.row_ptr.begin(), res.row_ptr.end() - 1);
+		for (size_t k = 0; k < rows.size(); ++k) {
+			uint64_t p = _tmp_next[rows[k]]++;
+			_tmp_cols[p] = cols[k];
+			_tmp_vals[p] = v[k];
+		}
+
+		// sort each row by column and merge duplicates
+		std::vector<uint64_t> _tmp_ptr = res.row_ptr;
+		std::vector<uint64_t> _tmp_order;
+		for (uint64_t i = 0; i < n; ++i) {
+			_tmp_order.resize(_tmp_ptr[i + 1] - _tmp_ptr[i]);
+			std::iota(_tmp_order.begin(), _tmp_order.end(), _tmp_ptr[i]);
+			std::sort(_tmp_order.begin(), _tmp_order.end(),
+				[&](uint64_t x, uint64_t y) { return _tmp_cols[x] < _tmp_cols[y]; });
+			for (uint64_t p : _tmp_order) {
+				if (res.col_idx.size() > res.row_ptr[i] && res.col_idx.back() == _tmp_cols[p]) {
+					res.vals.back() += _tmp_vals[p];
+				}
+				else {
+					res.col_idx.push_back(_tmp_cols[p]);
+					res.vals.push_back(_tmp_vals[p]);
+				}
+			}
+			res.row_ptr[i + 1] = res.col_idx.size();
+		}
+		return res;
+	}
+
+	uint64_t GetN() const noexcept { return n; }
+	uint64_t GetM() const noexcept { return m; }
+	uint64_t Nnz() const noexcept { return vals.size(); }
+
+	const std::vector<uint64_t>& RowPtr() const noexcept { return row_ptr; }
+	const std::vector<uint64_t>& ColIdx() const noexcept { return col_idx; }
+	const std::vector<T>& Values() const noexcept { return vals; }
+
+	// stored value at (i, j), zero when there is none
+	T GetItem(uint64_t i, uint64_t j) const {
+		if (i >= n || j >= m) {
+			merror("Index out of range!", E_MAT_INVALID_DIMENSION);
+			return static_cast<T>(0);
+		}
+		auto lo = col_idx.begin() + row_ptr[i];
+		auto hi = col_idx.begin() + row_ptr[i + 1];
+		auto it = std::lower_bound(lo, hi, j);
+		return it != hi && *it == j ? vals[it - col_idx.begin()] : static_cast<T>(0);
+	}
+
+	// y = A x, x has m and y n entries
+	void Multiply(const T* x, T* y) const {
+		std::vector<uint64_t> split = _row_chunks();
+		ThreadPool::Shared().ParallelFor(0, split.size() - 1, [&](uint64_t c) {
+			for (uint64_t i = split[c]; i < split[c + 1]; ++i) {
+				T acc = static_cast<T>(0);
+				for (uint64_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+					acc += vals[p] * x[col_idx[p]];
+				}
+				y[i] = acc;
+			}
+		});
+	}
+
+	QMatrix<T> ToQMatrix() const {
+		std::vector<T> _tmp_nums(SAFE_UINT(n * m), static_cast<T>(0));
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+				_tmp_nums[i * m + col_idx[p]] = vals[p];
+			}
+		}
+		return QMatrix<T>(_tmp_nums.data(), n, m);
+	}
+
+private:
+	// row boundaries of chunks holding about CSR_CHUNK_NNZ entries each
+	std::vector<uint64_t> _row_chunks() const {
+		std::vector<uint64_t> split{ 0 };
+		uint64_t acc = 0;
+		for (uint64_t i = 0; i < n; ++i) {
+			acc += row_ptr[i + 1] - row_ptr[i] + 1;
+			if (acc >= CSR_CHUNK_NNZ) {
+				split.push_back(i + 1);
+				acc = 0;
+			}
+		}
+		if (split.back() != n) {
+			split.push_back(n);
+		}
+		return split;
+	}
+
+	uint64_t n, m;
+	std::vector<uint64_t> row_ptr;
+	std::vector<uint64_t> col_idx;
+	std::vector<T> vals;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "Kernels.hpp"
+#include "MatrixError.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KALGEBRA_X86
+#endif
+
+#if defined(KALGEBRA_X86) && defined(_MSC_VER)
+static bool _cpuid_bit(int leaf, int subleaf, int reg, int bit) {
+	int regs[4] = { 0, 0, 0, 0 };
+	__cpuidex(regs, leaf, subleaf);
+	return (regs[reg] >> bit) & 1;
+}
+
+static bool _os_saves(unsigned long long mask) {
+	// the OS has to preserve the wide registers across context switches (XCR0)
+	if (!_cpuid_bit(1, 0, 2, 27)) {
+		return false;
+	}
+	return (_xgetbv(0) & mask) == mask;
+}
+#endif
+
+IsaLevel DetectIsa() noexcept {
+#if defined(KALGEBRA_X86) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+		&& __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")) {
+		return ISA_AVX512;
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) {
+		return ISA_AVX2;
+	}
+	if (__builtin_cpu_supports("sse4.2")) {
+		return ISA_SSE42;
+	}
+	return ISA_GENERIC;
+#elif defined(KALGEBRA_X86) && defined(_MSC_VER)
+	int regs[4] = { 0, 0, 0, 0 };
+	__cpuid(regs, 0);
+	int max_leaf = regs[0];
+
+	bool avx_os = _os_saves(0x6);
+	if (max_leaf >= 7 && _os_saves(0xE6) && _cpuid_bit(7, 0, 1, 16) && _cpuid_bit(7, 0, 1, 17)
+		&& _cpuid_bit(7, 0, 1, 30) && _cpuid_bit(7, 0, 1, 31)) {
+		return ISA_AVX512;
+	}
+	if (max_leaf >= 7 && avx_os && _cpuid_bit(7, 0, 1, 5) && _cpuid_bit(1, 0, 2, 12) && _cpuid_bit(1, 0, 2, 29)) {
+		return ISA_AVX2;
+	}
+	if (_cpuid_bit(1, 0, 2, 20)) {
+		return ISA_SSE42;
+	}
+	return ISA_GENERIC;
+#else
+	return ISA_GENERIC;
+#endif
+}
+
+const char* IsaName(IsaLevel isa) noexcept {
+	switch (isa) {
+	case ISA_SSE42: return "sse42";
+	case ISA_AVX2: return "avx2";
+	case ISA_AVX512: return "avx512";
+	default: return "generic";
+	}
+}
+
+static IsaLevel _isa_cap() {
+	const char* env = std::getenv("KALGEBRA_ISA");
+	if (env == nullptr) {
+		return ISA_AVX512;
+	}
+	for (uint32_t i = ISA_GENERIC; i <= ISA_AVX512; ++i) {
+		if (strcmp(env, IsaName(static_cast<IsaLevel>(i))) == 0) {
+			return static_cast<IsaLevel>(i);
+		}
+	}
+	merror("Unknown KALGEBRA_ISA value, ignoring it", WARN);
+	return ISA_AVX512;
+}
+
+static bool _has_vnni() {
+#if defined(KALGEBRA_X86) && (defined(__GNUC__) || defined(__clang__))
+	return __builtin_cpu_supports("avx512vnni");
+#elif defined(KALGEBRA_X86) && defined(_MSC_VER)
+	return _cpuid_bit(7, 0, 2, 11);
+#else
+	return false;
+#endif
+}
+
+static bool _has_bf16() {
+#if defined(KALGEBRA_X86) && (defined(__GNUC__) || defined(__clang__))
+	return __builtin_cpu_supports("avx512bf16");
+#elif defined(KALGEBRA_X86) && defined(_MSC_VER)
+	return _cpuid_bit(7, 1, 0, 5);
+#else
+	return false;
+#endif
+}
+
+static const KernelTable& _select_tier(IsaLevel isa) {
+	// only touch a table the CPU can run: even its static initialisation
+	// is compiled with that table's ISA flags
+#ifdef KALGEBRA_HAVE_AVX512
+	if (isa >= ISA_AVX512) {
+		return GetKernelsAVX512();
+	}
+#endif
+#ifdef KALGEBRA_HAVE_AVX2
+	if (isa >= ISA_AVX2) {
+		return GetKernelsAVX2();
+	}
+#endif
+#ifdef KALGEBRA_HAVE_SSE42
+	if (isa >= ISA_SSE42) {
+		return GetKernelsSSE42();
+	}
+#endif
+	return GetKernelsGeneric();
+}
+
+static KernelTable _select_kernels() {
+	IsaLevel isa = DetectIsa();
+	IsaLevel cap = _isa_cap();
+	if (cap < isa) {
+		isa = cap;
+	}
+
+	KernelTable table = _select_tier(isa);
+#ifdef KALGEBRA_HAVE_VNNI
+	if (isa >= ISA_AVX512 && _has_vnni()) {
+		PatchKernelsVNNI(table);
+	}
+#endif
+#ifdef KALGEBRA_HAVE_BF16
+	if (isa >= ISA_AVX512 && _has_bf16()) {
+		PatchKernelsBF16(table);
+	}
+#endif
+	return table;
+}
+
+const KernelTable& Kernels() noexcept {
+	static const KernelTable table = _select_kernels();
+	return table;
+}
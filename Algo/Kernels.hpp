@@ -0,0 +1,91 @@
+#ifndef _KERNELS_H
+#define _KERNELS_H
+
+#include <stdint.h>
+
+/*
+	Runtime dispatched numeric kernels.
+
+	Every kernel set is compiled in its own translation unit with the matching
+	ISA flags (KernelsGeneric.cpp, KernelsSSE42.cpp, KernelsAVX2.cpp, KernelsAVX512.cpp).
+	Kernels() picks the best set the running CPU supports on first use, so a single
+	binary runs on every node. Setting KALGEBRA_ISA=generic|sse42|avx2|avx512 caps the
+	selection (useful to compare paths on one machine).
+
+	All matrices are row-major with an explicit leading dimension. Complex kernels
+	(c = complex<float>, z = complex<double>) take interleaved {re, im} pairs, n counts
+	complex elements and conj_x uses conj(x) in place of x.
+
+	The AVX-512 set assumes the Skylake-SP baseline (F, BW, DQ, VL). On CPUs that also
+	have AVX512_VNNI or AVX512_BF16 the low-precision dot products of that set are
+	replaced by the ones in KernelsVNNI.cpp / KernelsBF16.cpp.
+*/
+
+enum IsaLevel : uint32_t {
+	ISA_GENERIC = 0,
+	ISA_SSE42 = 1,
+	ISA_AVX2 = 2,
+	ISA_AVX512 = 3
+};
+
+// matrices per lane group of the batched kernels, fixed so the layout is the same on every ISA
+constexpr uint64_t BATCH_LANES = 8;
+
+struct KernelTable {
+	IsaLevel isa;
+
+	// x . y
+	float (*sdot)(uint64_t n, const float* x, const float* y);
+	double (*ddot)(uint64_t n, const double* x, const double* y);
+
+	// y += a * x
+	void (*saxpy)(uint64_t n, float a, const float* x, float* y);
+	void (*daxpy)(uint64_t n, double a, const double* x, double* y);
+
+	// c[n x m] = a[n x p] * b[p x m]
+	void (*sgemm)(uint64_t n, uint64_t m, uint64_t p,
+		const float* a, uint64_t lda, const float* b, uint64_t ldb, float* c, uint64_t ldc);
+	void (*dgemm)(uint64_t n, uint64_t m, uint64_t p,
+		const double* a, uint64_t lda, const double* b, uint64_t ldb, double* c, uint64_t ldc);
+
+	// y += a * x, a points to one complex scalar
+	void (*caxpy)(uint64_t n, const float* a, const float* x, float* y, bool conj_x);
+	void (*zaxpy)(uint64_t n, const double* a, const double* x, double* y, bool conj_x);
+
+	// res = x . y (conj_x: x^H y)
+	void (*cdot)(uint64_t n, const float* x, const float* y, bool conj_x, float* res);
+	void (*zdot)(uint64_t n, const double* x, const double* y, bool conj_x, double* res);
+
+	// P A = L U in place for BATCH_LANES interleaved n x n matrices (see KernelsBatch.inl),
+	// piv[i * BATCH_LANES + l] is the row swapped with row i, det[l] the determinant
+	void (*slu_batch)(uint64_t n, float* a, uint32_t* piv, double* det);
+	void (*dlu_batch)(uint64_t n, double* a, uint32_t* piv, double* det);
+
+	// x . y accumulated wide: int8/int16 in int32, fp16/bf16 (raw bits) in fp32.
+	// The integer ones are exact while the sum fits in int32, which every input of
+	// n <= 131071 (int8) or n <= 1 (int16) guarantees; beyond that the result is the
+	// sum modulo 2^32, the same on every kernel set
+	int32_t (*dot_i8)(uint64_t n, const int8_t* x, const int8_t* y);
+	int32_t (*dot_i16)(uint64_t n, const int16_t* x, const int16_t* y);
+	float (*dot_f16)(uint64_t n, const uint16_t* x, const uint16_t* y);
+	float (*dot_bf16)(uint64_t n, const uint16_t* x, const uint16_t* y);
+
+	// content hash of bytes bytes at p (see KernelsHash.inl), equal on every kernel set
+	uint64_t (*hash64)(const void* p, uint64_t bytes, uint64_t seed);
+};
+
+IsaLevel DetectIsa() noexcept;
+const char* IsaName(IsaLevel isa) noexcept;
+const KernelTable& Kernels() noexcept;
+
+// per-ISA tables, only the ones enabled by the build are defined
+const KernelTable& GetKernelsGeneric() noexcept;
+const KernelTable& GetKernelsSSE42() noexcept;
+const KernelTable& GetKernelsAVX2() noexcept;
+const KernelTable& GetKernelsAVX512() noexcept;
+
+// AVX-512 extensions, patch their kernels into a copy of the AVX-512 table
+void PatchKernelsVNNI(KernelTable& table) noexcept;
+void PatchKernelsBF16(KernelTable& table) noexcept;
+
+#endif
@@ -0,0 +1,282 @@
+#include "Kernels.hpp"
+#include "LowPrecision.hpp"
+
+// compiled with -mavx2 -mfma -mf16c (/arch:AVX2 on MSVC)
+
+#include <immintrin.h>
+
+namespace {
+
+inline float HorizontalSum(__m256 v) {
+	__m128 lo = _mm256_castps256_ps128(v);
+	__m128 hi = _mm256_extractf128_ps(v, 1);
+	lo = _mm_add_ps(lo, hi);
+	lo = _mm_hadd_ps(lo, lo);
+	lo = _mm_hadd_ps(lo, lo);
+	return _mm_cvtss_f32(lo);
+}
+
+inline double HorizontalSum(__m256d v) {
+	__m128d lo = _mm256_castpd256_pd128(v);
+	__m128d hi = _mm256_extractf128_pd(v, 1);
+	lo = _mm_add_pd(lo, hi);
+	lo = _mm_hadd_pd(lo, lo);
+	return _mm_cvtsd_f64(lo);
+}
+
+inline int32_t HorizontalSum(__m256i v) {
+	__m128i lo = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	lo = _mm_hadd_epi32(lo, lo);
+	lo = _mm_hadd_epi32(lo, lo);
+	return _mm_cvtsi128_si32(lo);
+}
+
+float Dot(uint64_t n, const float* x, const float* y) {
+	__m256 acc0 = _mm256_setzero_ps();
+	__m256 acc1 = _mm256_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+		acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), acc1);
+	}
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+	}
+	float res = HorizontalSum(_mm256_add_ps(acc0, acc1));
+	for (; i < n; ++i) {
+		res += x[i] * y[i];
+	}
+	return res;
+}
+
+double Dot(uint64_t n, const double* x, const double* y) {
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+		acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+	}
+	for (; i + 4 <= n; i += 4) {
+		acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+	}
+	double res = HorizontalSum(_mm256_add_pd(acc0, acc1));
+	for (; i < n; ++i) {
+		res += x[i] * y[i];
+	}
+	return res;
+}
+
+void Axpy(uint64_t n, float a, const float* x, float* y) {
+	__m256 va = _mm256_set1_ps(a);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+void Axpy(uint64_t n, double a, const double* x, double* y) {
+	__m256d va = _mm256_set1_pd(a);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+// interleaved complex, 4M: a * x = ar * x -+ ai * swap(x) in one fmaddsub
+void ComplexAxpy(uint64_t n, const double* a, const double* x, double* y, bool conj_x) {
+	__m256d var = _mm256_set1_pd(a[0]);
+	__m256d vai = _mm256_set1_pd(a[1]);
+	__m256d flip = conj_x ? _mm256_set_pd(-0.0, 0.0, -0.0, 0.0) : _mm256_setzero_pd();
+	uint64_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m256d vx = _mm256_xor_pd(_mm256_loadu_pd(x + 2 * i), flip);
+		__m256d t = _mm256_mul_pd(vai, _mm256_permute_pd(vx, 0x5));
+		_mm256_storeu_pd(y + 2 * i, _mm256_add_pd(_mm256_loadu_pd(y + 2 * i), _mm256_fmaddsub_pd(var, vx, t)));
+	}
+	for (; i < n; ++i) {
+		double xr = x[2 * i];
+		double xi = conj_x ? -x[2 * i + 1] : x[2 * i + 1];
+		y[2 * i] += a[0] * xr - a[1] * xi;
+		y[2 * i + 1] += a[0] * xi + a[1] * xr;
+	}
+}
+
+void ComplexAxpy(uint64_t n, const float* a, const float* x, float* y, bool conj_x) {
+	__m256 var = _mm256_set1_ps(a[0]);
+	__m256 vai = _mm256_set1_ps(a[1]);
+	__m256 flip = conj_x ? _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f) : _mm256_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256 vx = _mm256_xor_ps(_mm256_loadu_ps(x + 2 * i), flip);
+		__m256 t = _mm256_mul_ps(vai, _mm256_permute_ps(vx, 0xB1));
+		_mm256_storeu_ps(y + 2 * i, _mm256_add_ps(_mm256_loadu_ps(y + 2 * i), _mm256_fmaddsub_ps(var, vx, t)));
+	}
+	for (; i < n; ++i) {
+		float xr = x[2 * i];
+		float xi = conj_x ? -x[2 * i + 1] : x[2 * i + 1];
+		y[2 * i] += a[0] * xr - a[1] * xi;
+		y[2 * i + 1] += a[0] * xi + a[1] * xr;
+	}
+}
+
+// accumulates x * y and x * swap(y) lane-wise, the even/odd lanes give the four real products
+void ComplexDot(uint64_t n, const double* x, const double* y, bool conj_x, double* res) {
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	uint64_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m256d vx = _mm256_loadu_pd(x + 2 * i);
+		__m256d vy = _mm256_loadu_pd(y + 2 * i);
+		acc0 = _mm256_fmadd_pd(vx, vy, acc0);
+		acc1 = _mm256_fmadd_pd(vx, _mm256_permute_pd(vy, 0x5), acc1);
+	}
+	double l0[4], l1[4];
+	_mm256_storeu_pd(l0, acc0);
+	_mm256_storeu_pd(l1, acc1);
+	double rr = l0[0] + l0[2], ii = l0[1] + l0[3];
+	double ri = l1[0] + l1[2], ir = l1[1] + l1[3];
+	for (; i < n; ++i) {
+		rr += x[2 * i] * y[2 * i];
+		ii += x[2 * i + 1] * y[2 * i + 1];
+		ri += x[2 * i] * y[2 * i + 1];
+		ir += x[2 * i + 1] * y[2 * i];
+	}
+	res[0] = conj_x ? rr + ii : rr - ii;
+	res[1] = conj_x ? ri - ir : ri + ir;
+}
+
+void ComplexDot(uint64_t n, const float* x, const float* y, bool conj_x, float* res) {
+	__m256 acc0 = _mm256_setzero_ps();
+	__m256 acc1 = _mm256_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256 vx = _mm256_loadu_ps(x + 2 * i);
+		__m256 vy = _mm256_loadu_ps(y + 2 * i);
+		acc0 = _mm256_fmadd_ps(vx, vy, acc0);
+		acc1 = _mm256_fmadd_ps(vx, _mm256_permute_ps(vy, 0xB1), acc1);
+	}
+	float l0[8], l1[8];
+	_mm256_storeu_ps(l0, acc0);
+	_mm256_storeu_ps(l1, acc1);
+	float rr = 0, ii = 0, ri = 0, ir = 0;
+	for (int k = 0; k < 8; k += 2) {
+		rr += l0[k];
+		ii += l0[k + 1];
+		ri += l1[k];
+		ir += l1[k + 1];
+	}
+	for (; i < n; ++i) {
+		rr += x[2 * i] * y[2 * i];
+		ii += x[2 * i + 1] * y[2 * i + 1];
+		ri += x[2 * i] * y[2 * i + 1];
+		ir += x[2 * i + 1] * y[2 * i];
+	}
+	res[0] = conj_x ? rr + ii : rr - ii;
+	res[1] = conj_x ? ri - ir : ri + ir;
+}
+
+// int8 widened to int16 and multiplied pairwise into int32 (vpmaddwd)
+int32_t DotI8(uint64_t n, const int8_t* x, const int8_t* y) {
+	__m256i acc = _mm256_setzero_si256();
+	uint64_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m256i vx = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+		__m256i vy = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)));
+		acc = _mm256_add_epi32(acc, _mm256_madd_epi16(vx, vy));
+	}
+	uint32_t res = static_cast<uint32_t>(HorizontalSum(acc));
+	for (; i < n; ++i) {
+		res += static_cast<uint32_t>(static_cast<int32_t>(x[i]) * static_cast<int32_t>(y[i]));
+	}
+	return static_cast<int32_t>(res);
+}
+
+int32_t DotI16(uint64_t n, const int16_t* x, const int16_t* y) {
+	__m256i acc0 = _mm256_setzero_si256();
+	__m256i acc1 = _mm256_setzero_si256();
+	uint64_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i))));
+		acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i + 16)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i + 16))));
+	}
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)),
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i))));
+	}
+	uint32_t res = static_cast<uint32_t>(HorizontalSum(_mm256_add_epi32(acc0, acc1)));
+	for (; i < n; ++i) {
+		res += static_cast<uint32_t>(static_cast<int32_t>(x[i]) * static_cast<int32_t>(y[i]));
+	}
+	return static_cast<int32_t>(res);
+}
+
+// F16C conversion, fp32 fma
+float DotF16(uint64_t n, const uint16_t* x, const uint16_t* y) {
+	__m256 acc0 = _mm256_setzero_ps();
+	__m256 acc1 = _mm256_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i))),
+			_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i))), acc0);
+		acc1 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i + 8))),
+			_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i + 8))), acc1);
+	}
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i))),
+			_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i))), acc0);
+	}
+	float res = HorizontalSum(_mm256_add_ps(acc0, acc1));
+	for (; i < n; ++i) {
+		res += HalfToFloat(x[i]) * HalfToFloat(y[i]);
+	}
+	return res;
+}
+
+// bf16 is the top half of an fp32, widening is a 16 bit shift
+inline __m256 LoadBF16(const uint16_t* p) {
+	__m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+	return _mm256_castsi256_ps(_mm256_slli_epi32(v, 16));
+}
+
+float DotBF16(uint64_t n, const uint16_t* x, const uint16_t* y) {
+	__m256 acc0 = _mm256_setzero_ps();
+	__m256 acc1 = _mm256_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm256_fmadd_ps(LoadBF16(x + i), LoadBF16(y + i), acc0);
+		acc1 = _mm256_fmadd_ps(LoadBF16(x + i + 8), LoadBF16(y + i + 8), acc1);
+	}
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm256_fmadd_ps(LoadBF16(x + i), LoadBF16(y + i), acc0);
+	}
+	float res = HorizontalSum(_mm256_add_ps(acc0, acc1));
+	for (; i < n; ++i) {
+		res += BFloat16ToFloat(x[i]) * BFloat16ToFloat(y[i]);
+	}
+	return res;
+}
+
+#include "KernelsGemm.inl"
+#include "KernelsBatch.inl"
+#include "KernelsHash.inl"
+
+}
+
+const KernelTable& GetKernelsAVX2() noexcept {
+	static const KernelTable table = { ISA_AVX2, Sdot, Ddot, Saxpy, Daxpy, Sgemm, Dgemm,
+		Caxpy, Zaxpy, Cdot, Zdot, SluBatch, DluBatch,
+		DotI8, DotI16, DotF16, DotBF16, Hash64 };
+	return table;
+}
@@ -0,0 +1,268 @@
+#include "Kernels.hpp"
+#include "LowPrecision.hpp"
+
+// compiled with -mavx512f -mavx512bw -mavx512dq -mavx512vl (/arch:AVX512 on MSVC)
+
+// GCC 12 reports its own self-initialized _mm512_undefined_* temporaries as
+// uninitialized wherever an intrinsic using them is inlined; the diagnostics
+// point into the intrinsic headers, so only those are silenced
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// lane sum modulo 2^32, _mm512_reduce_add_epi32 ends in a plain int addition that may overflow
+inline uint32_t WrappingSum(__m512i v) {
+	__m256i s = _mm256_add_epi32(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+	__m128i t = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+	t = _mm_add_epi32(t, _mm_shuffle_epi32(t, 0x4E));
+	t = _mm_add_epi32(t, _mm_shuffle_epi32(t, 0xB1));
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(t));
+}
+
+float Dot(uint64_t n, const float* x, const float* y) {
+	__m512 acc0 = _mm512_setzero_ps();
+	__m512 acc1 = _mm512_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc0);
+		acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), acc1);
+	}
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc0);
+	}
+	if (i < n) {
+		__mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+		acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail, x + i), _mm512_maskz_loadu_ps(tail, y + i), acc1);
+	}
+	return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+double Dot(uint64_t n, const double* x, const double* y) {
+	__m512d acc0 = _mm512_setzero_pd();
+	__m512d acc1 = _mm512_setzero_pd();
+	uint64_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+		acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), acc1);
+	}
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+	}
+	if (i < n) {
+		__mmask8 tail = static_cast<__mmask8>((1u << (n - i)) - 1);
+		acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(tail, x + i), _mm512_maskz_loadu_pd(tail, y + i), acc1);
+	}
+	return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+}
+
+void Axpy(uint64_t n, float a, const float* x, float* y) {
+	__m512 va = _mm512_set1_ps(a);
+	uint64_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+	}
+	if (i < n) {
+		__mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+		__m512 vy = _mm512_maskz_loadu_ps(tail, y + i);
+		_mm512_mask_storeu_ps(y + i, tail, _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(tail, x + i), vy));
+	}
+}
+
+void Axpy(uint64_t n, double a, const double* x, double* y) {
+	__m512d va = _mm512_set1_pd(a);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+	}
+	if (i < n) {
+		__mmask8 tail = static_cast<__mmask8>((1u << (n - i)) - 1);
+		__m512d vy = _mm512_maskz_loadu_pd(tail, y + i);
+		_mm512_mask_storeu_pd(y + i, tail, _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(tail, x + i), vy));
+	}
+}
+
+inline __m512d FlipImag(__m512d v, bool conj) {
+	if (!conj) {
+		return v;
+	}
+	__m512i mask = _mm512_set_epi64(INT64_MIN, 0, INT64_MIN, 0, INT64_MIN, 0, INT64_MIN, 0);
+	return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(v), mask));
+}
+
+inline __m512 FlipImag(__m512 v, bool conj) {
+	if (!conj) {
+		return v;
+	}
+	__m512i mask = _mm512_set1_epi64(static_cast<int64_t>(0x8000000000000000ull));
+	return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(v), mask));
+}
+
+// interleaved complex, 4M: a * x = ar * x -+ ai * swap(x) in one fmaddsub, masked tail
+void ComplexAxpy(uint64_t n, const double* a, const double* x, double* y, bool conj_x) {
+	__m512d var = _mm512_set1_pd(a[0]);
+	__m512d vai = _mm512_set1_pd(a[1]);
+	uint64_t i = 0;
+	for (; i < n; i += 4) {
+		uint64_t left = 2 * (n - i);
+		__mmask8 k = left >= 8 ? static_cast<__mmask8>(0xFF) : static_cast<__mmask8>((1u << left) - 1);
+		__m512d vx = FlipImag(_mm512_maskz_loadu_pd(k, x + 2 * i), conj_x);
+		__m512d t = _mm512_mul_pd(vai, _mm512_permute_pd(vx, 0x55));
+		__m512d vy = _mm512_add_pd(_mm512_maskz_loadu_pd(k, y + 2 * i), _mm512_fmaddsub_pd(var, vx, t));
+		_mm512_mask_storeu_pd(y + 2 * i, k, vy);
+	}
+}
+
+void ComplexAxpy(uint64_t n, const float* a, const float* x, float* y, bool conj_x) {
+	__m512 var = _mm512_set1_ps(a[0]);
+	__m512 vai = _mm512_set1_ps(a[1]);
+	uint64_t i = 0;
+	for (; i < n; i += 8) {
+		uint64_t left = 2 * (n - i);
+		__mmask16 k = left >= 16 ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << left) - 1);
+		__m512 vx = FlipImag(_mm512_maskz_loadu_ps(k, x + 2 * i), conj_x);
+		__m512 t = _mm512_mul_ps(vai, _mm512_permute_ps(vx, 0xB1));
+		__m512 vy = _mm512_add_ps(_mm512_maskz_loadu_ps(k, y + 2 * i), _mm512_fmaddsub_ps(var, vx, t));
+		_mm512_mask_storeu_ps(y + 2 * i, k, vy);
+	}
+}
+
+// accumulates x * y and x * swap(y) lane-wise, the even/odd lanes give the four real products
+void ComplexDot(uint64_t n, const double* x, const double* y, bool conj_x, double* res) {
+	__m512d acc0 = _mm512_setzero_pd();
+	__m512d acc1 = _mm512_setzero_pd();
+	for (uint64_t i = 0; i < n; i += 4) {
+		uint64_t left = 2 * (n - i);
+		__mmask8 k = left >= 8 ? static_cast<__mmask8>(0xFF) : static_cast<__mmask8>((1u << left) - 1);
+		__m512d vx = _mm512_maskz_loadu_pd(k, x + 2 * i);
+		__m512d vy = _mm512_maskz_loadu_pd(k, y + 2 * i);
+		acc0 = _mm512_fmadd_pd(vx, vy, acc0);
+		acc1 = _mm512_fmadd_pd(vx, _mm512_permute_pd(vy, 0x55), acc1);
+	}
+	__mmask8 even = 0x55;
+	__mmask8 odd = 0xAA;
+	double rr = _mm512_mask_reduce_add_pd(even, acc0), ii = _mm512_mask_reduce_add_pd(odd, acc0);
+	double ri = _mm512_mask_reduce_add_pd(even, acc1), ir = _mm512_mask_reduce_add_pd(odd, acc1);
+	res[0] = conj_x ? rr + ii : rr - ii;
+	res[1] = conj_x ? ri - ir : ri + ir;
+}
+
+void ComplexDot(uint64_t n, const float* x, const float* y, bool conj_x, float* res) {
+	__m512 acc0 = _mm512_setzero_ps();
+	__m512 acc1 = _mm512_setzero_ps();
+	for (uint64_t i = 0; i < n; i += 8) {
+		uint64_t left = 2 * (n - i);
+		__mmask16 k = left >= 16 ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1u << left) - 1);
+		__m512 vx = _mm512_maskz_loadu_ps(k, x + 2 * i);
+		__m512 vy = _mm512_maskz_loadu_ps(k, y + 2 * i);
+		acc0 = _mm512_fmadd_ps(vx, vy, acc0);
+		acc1 = _mm512_fmadd_ps(vx, _mm512_permute_ps(vy, 0xB1), acc1);
+	}
+	__mmask16 even = 0x5555;
+	__mmask16 odd = 0xAAAA;
+	float rr = _mm512_mask_reduce_add_ps(even, acc0), ii = _mm512_mask_reduce_add_ps(odd, acc0);
+	float ri = _mm512_mask_reduce_add_ps(even, acc1), ir = _mm512_mask_reduce_add_ps(odd, acc1);
+	res[0] = conj_x ? rr + ii : rr - ii;
+	res[1] = conj_x ? ri - ir : ri + ir;
+}
+
+// sign-extend to int16 and vpmaddwd; the VNNI set replaces this with vpdpbusd
+int32_t DotI8(uint64_t n, const int8_t* x, const int8_t* y) {
+	__m512i acc = _mm512_setzero_si512();
+	uint64_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m512i vx = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+		__m512i vy = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)));
+		acc = _mm512_add_epi32(acc, _mm512_madd_epi16(vx, vy));
+	}
+	if (i < n) {
+		__mmask32 tail = static_cast<__mmask32>((1ull << (n - i)) - 1);
+		__m512i vx = _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(tail, x + i));
+		__m512i vy = _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(tail, y + i));
+		acc = _mm512_add_epi32(acc, _mm512_madd_epi16(vx, vy));
+	}
+	return static_cast<int32_t>(WrappingSum(acc));
+}
+
+int32_t DotI16(uint64_t n, const int16_t* x, const int16_t* y) {
+	__m512i acc0 = _mm512_setzero_si512();
+	__m512i acc1 = _mm512_setzero_si512();
+	uint64_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+		acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(_mm512_loadu_si512(x + i), _mm512_loadu_si512(y + i)));
+		acc1 = _mm512_add_epi32(acc1, _mm512_madd_epi16(_mm512_loadu_si512(x + i + 32), _mm512_loadu_si512(y + i + 32)));
+	}
+	for (; i + 32 <= n; i += 32) {
+		acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(_mm512_loadu_si512(x + i), _mm512_loadu_si512(y + i)));
+	}
+	if (i < n) {
+		__mmask32 tail = static_cast<__mmask32>((1ull << (n - i)) - 1);
+		acc1 = _mm512_add_epi32(acc1, _mm512_madd_epi16(_mm512_maskz_loadu_epi16(tail, x + i),
+			_mm512_maskz_loadu_epi16(tail, y + i)));
+	}
+	return static_cast<int32_t>(WrappingSum(_mm512_add_epi32(acc0, acc1)));
+}
+
+float DotF16(uint64_t n, const uint16_t* x, const uint16_t* y) {
+	__m512 acc0 = _mm512_setzero_ps();
+	__m512 acc1 = _mm512_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		acc0 = _mm512_fmadd_ps(_mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i))),
+			_mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i))), acc0);
+		acc1 = _mm512_fmadd_ps(_mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i + 16))),
+			_mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i + 16))), acc1);
+	}
+	if (i + 16 <= n) {
+		acc0 = _mm512_fmadd_ps(_mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i))),
+			_mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i))), acc0);
+		i += 16;
+	}
+	if (i < n) {
+		__mmask16 tail = static_cast<__mmask16>((1u << (n - i)) - 1);
+		acc1 = _mm512_fmadd_ps(_mm512_cvtph_ps(_mm256_maskz_loadu_epi16(tail, x + i)),
+			_mm512_cvtph_ps(_mm256_maskz_loadu_epi16(tail, y + i)), acc1);
+	}
+	return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+inline __m512 LoadBF16(__mmask16 mask, const uint16_t* p) {
+	__m512i v = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(mask, p));
+	return _mm512_castsi512_ps(_mm512_slli_epi32(v, 16));
+}
+
+// the BF16 set replaces this with vdpbf16ps
+float DotBF16(uint64_t n, const uint16_t* x, const uint16_t* y) {
+	__m512 acc0 = _mm512_setzero_ps();
+	__m512 acc1 = _mm512_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		acc0 = _mm512_fmadd_ps(LoadBF16(0xFFFF, x + i), LoadBF16(0xFFFF, y + i), acc0);
+		acc1 = _mm512_fmadd_ps(LoadBF16(0xFFFF, x + i + 16), LoadBF16(0xFFFF, y + i + 16), acc1);
+	}
+	for (; i < n; i += 16) {
+		__mmask16 tail = n - i >= 16 ? 0xFFFF : static_cast<__mmask16>((1u << (n - i)) - 1);
+		acc0 = _mm512_fmadd_ps(LoadBF16(tail, x + i), LoadBF16(tail, y + i), acc0);
+	}
+	return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+#include "KernelsGemm.inl"
+#include "KernelsBatch.inl"
+#include "KernelsHash.inl"
+
+}
+
+const KernelTable& GetKernelsAVX512() noexcept {
+	static const KernelTable table = { ISA_AVX512, Sdot, Ddot, Saxpy, Daxpy, Sgemm, Dgemm,
+		Caxpy, Zaxpy, Cdot, Zdot, SluBatch, DluBatch,
+		DotI8, DotI16, DotF16, DotBF16, Hash64 };
+	return table;
+}
@@ -0,0 +1,47 @@
+#include "Kernels.hpp"
+
+// compiled with the AVX-512 flags plus -mavx512bf16 (/arch:AVX512 on MSVC), only
+// patched into the AVX-512 table when the CPU reports AVX512_BF16
+
+// the intrinsic headers are included with the same GCC 12 warning workaround as KernelsAVX512.cpp
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#include <cstring>
+
+namespace {
+
+inline __m512bh AsBF16(__m512i v) {
+	__m512bh res;
+	memcpy(&res, &v, sizeof(res));
+	return res;
+}
+
+// vdpbf16ps: pairs of bf16 products summed into each fp32 lane
+float DotBF16(uint64_t n, const uint16_t* x, const uint16_t* y) {
+	__m512 acc0 = _mm512_setzero_ps();
+	__m512 acc1 = _mm512_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+		acc0 = _mm512_dpbf16_ps(acc0, AsBF16(_mm512_loadu_si512(x + i)), AsBF16(_mm512_loadu_si512(y + i)));
+		acc1 = _mm512_dpbf16_ps(acc1, AsBF16(_mm512_loadu_si512(x + i + 32)), AsBF16(_mm512_loadu_si512(y + i + 32)));
+	}
+	for (; i < n; i += 32) {
+		__mmask32 tail = n - i >= 32 ? ~0u : static_cast<__mmask32>((1ull << (n - i)) - 1);
+		acc0 = _mm512_dpbf16_ps(acc0, AsBF16(_mm512_maskz_loadu_epi16(tail, x + i)),
+			AsBF16(_mm512_maskz_loadu_epi16(tail, y + i)));
+	}
+	return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+}
+
+void PatchKernelsBF16(KernelTable& table) noexcept {
+	table.dot_bf16 = DotBF16;
+}
@@ -0,0 +1,102 @@
+/*
+	Batched LU over BATCH_LANES lane-interleaved matrices.
+
+	Element (i, j) of lane l sits at a[(i * n + j) * BATCH_LANES + l], so every inner
+	loop below runs over the lanes with a fixed trip count and is vectorized across
+	matrices with the translation unit's own ISA flags (one AVX-512 register holds a
+	lane group of doubles, two AVX2 registers, four SSE ones). Pivot choice and row
+	swaps differ per lane and are done with selects instead of branches.
+
+	Included inside the anonymous namespace of each Kernels*.cpp.
+*/
+
+constexpr uint64_t W = BATCH_LANES;
+
+template<typename T>
+inline T LaneAbs(T x) {
+	return x < static_cast<T>(0) ? -x : x;
+}
+
+template<typename T>
+void LuInterleaved(uint64_t n, T* a, uint32_t* piv, double* det) {
+	for (uint64_t l = 0; l < W; ++l) {
+		det[l] = 1;
+	}
+
+	for (uint64_t k = 0; k < n; ++k) {
+		T* _row_k = a + k * n * W;
+
+		// lane-wise argmax |a(i, k)| for i >= k
+		T best[W];
+		uint32_t p[W];
+		for (uint64_t l = 0; l < W; ++l) {
+			best[l] = LaneAbs(_row_k[k * W + l]);
+			p[l] = static_cast<uint32_t>(k);
+		}
+		for (uint64_t i = k + 1; i < n; ++i) {
+			const T* _a_ik = a + (i * n + k) * W;
+			for (uint64_t l = 0; l < W; ++l) {
+				T v = LaneAbs(_a_ik[l]);
+				bool gt = v > best[l];
+				p[l] = gt ? static_cast<uint32_t>(i) : p[l];
+				best[l] = gt ? v : best[l];
+			}
+		}
+
+		bool _any_swap = false;
+		uint64_t off[W];
+		for (uint64_t l = 0; l < W; ++l) {
+			piv[k * W + l] = p[l];
+			_any_swap |= p[l] != k;
+			det[l] = p[l] != k ? -det[l] : det[l];
+			off[l] = p[l] * n * W + l;
+		}
+		// gather row p[l] of every lane into row k and scatter row k back; lanes with
+		// p[l] == k write their own value twice
+		if (_any_swap) {
+			for (uint64_t j = 0; j < n; ++j) {
+				T* _a_kj = _row_k + j * W;
+				T t[W], g[W];
+				for (uint64_t l = 0; l < W; ++l) {
+					t[l] = _a_kj[l];
+					g[l] = a[off[l] + j * W];
+				}
+				for (uint64_t l = 0; l < W; ++l) {
+					a[off[l] + j * W] = t[l];
+				}
+				for (uint64_t l = 0; l < W; ++l) {
+					_a_kj[l] = g[l];
+				}
+			}
+		}
+
+		// a zero pivot (singular lane) zeroes its multipliers, det is already 0 then
+		T inv[W];
+		for (uint64_t l = 0; l < W; ++l) {
+			T pv = _row_k[k * W + l];
+			det[l] *= static_cast<double>(pv);
+			inv[l] = pv != static_cast<T>(0) ? static_cast<T>(1) / pv : static_cast<T>(0);
+		}
+
+		for (uint64_t i = k + 1; i < n; ++i) {
+			T* _row_i = a + i * n * W;
+			T lik[W];
+			for (uint64_t l = 0; l < W; ++l) {
+				lik[l] = _row_i[k * W + l] * inv[l];
+				_row_i[k * W + l] = lik[l];
+			}
+			for (uint64_t j = k + 1; j < n; ++j) {
+				T ukj[W];
+				for (uint64_t l = 0; l < W; ++l) {
+					ukj[l] = _row_k[j * W + l];
+				}
+				for (uint64_t l = 0; l < W; ++l) {
+					_row_i[j * W + l] -= lik[l] * ukj[l];
+				}
+			}
+		}
+	}
+}
+
+void SluBatch(uint64_t n, float* a, uint32_t* piv, double* det) { LuInterleaved(n, a, piv, det); }
+void DluBatch(uint64_t n, double* a, uint32_t* piv, double* det) { LuInterleaved(n, a, piv, det); }
@@ -0,0 +1,38 @@
+/*
+	Portable interleaved complex kernels ({re, im} pairs, the std::complex layout).
+
+	Included inside the anonymous namespace of the kernel sets that have no
+	hand-written complex path; the SSE4.2 set gets them auto-vectorized under
+	its own flags. conj_x uses conj(x) in place of x.
+*/
+
+template<typename R>
+void ComplexAxpy(uint64_t n, const R* a, const R* x, R* y, bool conj_x) {
+	R ar = a[0];
+	R ai = conj_x ? -a[1] : a[1];
+	R sign = conj_x ? static_cast<R>(-1) : static_cast<R>(1);
+	// y += a * conj(x) is conj(conj(a) * x) applied to the imaginary sign
+	for (uint64_t i = 0; i < n; ++i) {
+		R xr = x[2 * i];
+		R xi = x[2 * i + 1];
+		y[2 * i] += ar * xr - ai * xi;
+		y[2 * i + 1] += sign * (ar * xi + ai * xr);
+	}
+}
+
+template<typename R>
+void ComplexDot(uint64_t n, const R* x, const R* y, bool conj_x, R* res) {
+	R rr = 0, ii = 0, ri = 0, ir = 0;
+	for (uint64_t i = 0; i < n; ++i) {
+		R xr = x[2 * i];
+		R xi = x[2 * i + 1];
+		R yr = y[2 * i];
+		R yi = y[2 * i + 1];
+		rr += xr * yr;
+		ii += xi * yi;
+		ri += xr * yi;
+		ir += xi * yr;
+	}
+	res[0] = conj_x ? rr + ii : rr - ii;
+	res[1] = conj_x ? ri - ir : ri + ir;
+}
@@ -0,0 +1,62 @@
+/*
+	Blocked GEMM shared by every kernel set.
+
+	Included inside the anonymous namespace of each Kernels*.cpp after that file
+	defines Axpy(n, a, x, y) and Dot(n, x, y) for float and double and
+	ComplexAxpy/ComplexDot on interleaved pairs, so the loops below are compiled
+	with the translation unit's ISA flags and never merged across sets by the linker.
+*/
+
+constexpr uint64_t GEMM_KC = 128;
+constexpr uint64_t GEMM_NC = 256;
+
+inline uint64_t BlockLen(uint64_t block, uint64_t left) {
+	return left < block ? left : block;
+}
+
+template<typename T>
+void Gemm(uint64_t n, uint64_t m, uint64_t p,
+	const T* a, uint64_t lda, const T* b, uint64_t ldb, T* c, uint64_t ldc) {
+
+	for (uint64_t i = 0; i < n; ++i) {
+		for (uint64_t j = 0; j < m; ++j) {
+			c[i * ldc + j] = static_cast<T>(0);
+		}
+	}
+
+	// i-k-j order over a kc x nc panel of b that stays in cache,
+	// the innermost axpy streams one row of b into one row of c
+	for (uint64_t jj = 0; jj < m; jj += GEMM_NC) {
+		uint64_t nc = BlockLen(GEMM_NC, m - jj);
+		for (uint64_t kk = 0; kk < p; kk += GEMM_KC) {
+			uint64_t kc = BlockLen(GEMM_KC, p - kk);
+			for (uint64_t i = 0; i < n; ++i) {
+				const T* _a_row = a + i * lda + kk;
+				T* _c_row = c + i * ldc + jj;
+				for (uint64_t k = 0; k < kc; ++k) {
+					Axpy(nc, _a_row[k], b + (kk + k) * ldb + jj, _c_row);
+				}
+			}
+		}
+	}
+}
+
+float Sdot(uint64_t n, const float* x, const float* y) { return Dot(n, x, y); }
+double Ddot(uint64_t n, const double* x, const double* y) { return Dot(n, x, y); }
+void Saxpy(uint64_t n, float a, const float* x, float* y) { Axpy(n, a, x, y); }
+void Daxpy(uint64_t n, double a, const double* x, double* y) { Axpy(n, a, x, y); }
+
+void Sgemm(uint64_t n, uint64_t m, uint64_t p,
+	const float* a, uint64_t lda, const float* b, uint64_t ldb, float* c, uint64_t ldc) {
+	Gemm<float>(n, m, p, a, lda, b, ldb, c, ldc);
+}
+
+void Dgemm(uint64_t n, uint64_t m, uint64_t p,
+	const double* a, uint64_t lda, const double* b, uint64_t ldb, double* c, uint64_t ldc) {
+	Gemm<double>(n, m, p, a, lda, b, ldb, c, ldc);
+}
+
+void Caxpy(uint64_t n, const float* a, const float* x, float* y, bool conj_x) { ComplexAxpy(n, a, x, y, conj_x); }
+void Zaxpy(uint64_t n, const double* a, const double* x, double* y, bool conj_x) { ComplexAxpy(n, a, x, y, conj_x); }
+void Cdot(uint64_t n, const float* x, const float* y, bool conj_x, float* res) { ComplexDot(n, x, y, conj_x, res); }
+void Zdot(uint64_t n, const double* x, const double* y, bool conj_x, double* res) { ComplexDot(n, x, y, conj_x, res); }
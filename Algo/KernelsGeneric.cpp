@@ -0,0 +1,63 @@
+#include "Kernels.hpp"
+#include "LowPrecision.hpp"
+
+// baseline kernels, compiled without any ISA flags
+
+namespace {
+
+float Dot(uint64_t n, const float* x, const float* y) {
+	float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		s0 += x[i] * y[i];
+		s1 += x[i + 1] * y[i + 1];
+		s2 += x[i + 2] * y[i + 2];
+		s3 += x[i + 3] * y[i + 3];
+	}
+	for (; i < n; ++i) {
+		s0 += x[i] * y[i];
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+double Dot(uint64_t n, const double* x, const double* y) {
+	double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		s0 += x[i] * y[i];
+		s1 += x[i + 1] * y[i + 1];
+		s2 += x[i + 2] * y[i + 2];
+		s3 += x[i + 3] * y[i + 3];
+	}
+	for (; i < n; ++i) {
+		s0 += x[i] * y[i];
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+void Axpy(uint64_t n, float a, const float* x, float* y) {
+	for (uint64_t i = 0; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+void Axpy(uint64_t n, double a, const double* x, double* y) {
+	for (uint64_t i = 0; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+#include "KernelsComplex.inl"
+#include "KernelsQuant.inl"
+#include "KernelsGemm.inl"
+#include "KernelsBatch.inl"
+#include "KernelsHash.inl"
+
+}
+
+const KernelTable& GetKernelsGeneric() noexcept {
+	static const KernelTable table = { ISA_GENERIC, Sdot, Ddot, Saxpy, Daxpy, Sgemm, Dgemm,
+		Caxpy, Zaxpy, Cdot, Zdot, SluBatch, DluBatch,
+		DotI8, DotI16, DotF16, DotBF16, Hash64 };
+	return table;
+}
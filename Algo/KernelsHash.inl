@@ -0,0 +1,91 @@
+/*
+	64-bit content hash of a byte range.
+
+	The input is read as little-endian 64-bit words in 64-byte stripes, one word per
+	lane of HASH_LANES accumulators. Every lane step is a 32 x 32 -> 64 bit multiply
+	and two adds, which vectorizes to pmuludq / vpmuludq under the translation unit's
+	flags. The accumulators are scrambled every HASH_BLOCK stripes, the tail is zero
+	padded into one last stripe and the lanes are folded and avalanched at the end.
+	Only integer arithmetic is involved, so every kernel set returns the same value.
+
+	Included inside the anonymous namespace of each Kernels*.cpp.
+*/
+
+constexpr uint64_t HASH_LANES = 8;
+constexpr uint64_t HASH_BLOCK = 16;
+
+constexpr uint64_t HashPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t HashPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t HashPrime3 = 0x165667B19E3779F9ull;
+constexpr uint32_t HashPrime32 = 0x9E3779B1u;
+
+constexpr uint64_t HashKey[HASH_LANES] = {
+	0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+	0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull
+};
+
+inline uint64_t HashLoad64(const unsigned char* p) {
+	uint64_t w = 0;
+	for (int b = 0; b < 8; ++b) {
+		w |= static_cast<uint64_t>(p[b]) << (8 * b);
+	}
+	return w;
+}
+
+inline uint64_t HashAvalanche(uint64_t h) {
+	h ^= h >> 33;
+	h *= HashPrime2;
+	h ^= h >> 29;
+	h *= HashPrime3;
+	h ^= h >> 32;
+	return h;
+}
+
+inline void HashStripe(uint64_t* acc, const unsigned char* p, uint64_t seed) {
+	uint64_t w[HASH_LANES];
+	for (uint64_t l = 0; l < HASH_LANES; ++l) {
+		w[l] = HashLoad64(p + 8 * l);
+	}
+	for (uint64_t l = 0; l < HASH_LANES; ++l) {
+		uint64_t d = w[l] ^ (HashKey[l] + seed);
+		acc[l] += w[l ^ 1] + (d & 0xFFFFFFFFull) * (d >> 32);
+	}
+}
+
+inline void HashScramble(uint64_t* acc) {
+	for (uint64_t l = 0; l < HASH_LANES; ++l) {
+		uint64_t a = acc[l];
+		a ^= a >> 47;
+		a ^= HashKey[(l + 1) % HASH_LANES];
+		acc[l] = a * HashPrime32;
+	}
+}
+
+uint64_t Hash64(const void* data, uint64_t bytes, uint64_t seed) {
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+	uint64_t acc[HASH_LANES] = {
+		seed + HashPrime1, seed - HashPrime2, seed + HashPrime3, seed ^ HashPrime1,
+		seed - HashPrime3, seed + HashPrime2, seed ^ HashPrime3, seed - HashPrime1
+	};
+
+	const uint64_t stripe = 8 * HASH_LANES;
+	uint64_t stripes = bytes / stripe;
+	for (uint64_t s = 0; s < stripes; ++s) {
+		HashStripe(acc, p + s * stripe, seed);
+		if ((s + 1) % HASH_BLOCK == 0) {
+			HashScramble(acc);
+		}
+	}
+
+	unsigned char last[8 * HASH_LANES] = {};
+	for (uint64_t i = stripes * stripe; i < bytes; ++i) {
+		last[i - stripes * stripe] = p[i];
+	}
+	HashStripe(acc, last, seed);
+
+	uint64_t h = bytes * HashPrime1 ^ seed;
+	for (uint64_t l = 0; l < HASH_LANES; ++l) {
+		h = (h ^ HashAvalanche(acc[l])) * HashPrime1 + HashPrime3;
+	}
+	return HashAvalanche(h);
+}
@@ -0,0 +1,54 @@
+/*
+	Portable widening dot products for the low-precision element types.
+
+	Included inside the anonymous namespace of the kernel sets without hand-written
+	versions; the plain loops are auto-vectorized under the translation unit's flags
+	(pmaddwd-style int16 products on SSE4.2).
+
+	The integer sums are carried in uint32_t, so a sum that leaves the int32 range
+	wraps modulo 2^32 like the vector kernels do instead of overflowing.
+*/
+
+int32_t DotI8(uint64_t n, const int8_t* x, const int8_t* y) {
+	uint32_t res = 0;
+	for (uint64_t i = 0; i < n; ++i) {
+		res += static_cast<uint32_t>(static_cast<int32_t>(x[i]) * static_cast<int32_t>(y[i]));
+	}
+	return static_cast<int32_t>(res);
+}
+
+int32_t DotI16(uint64_t n, const int16_t* x, const int16_t* y) {
+	uint32_t res = 0;
+	for (uint64_t i = 0; i < n; ++i) {
+		res += static_cast<uint32_t>(static_cast<int32_t>(x[i]) * static_cast<int32_t>(y[i]));
+	}
+	return static_cast<int32_t>(res);
+}
+
+float DotF16(uint64_t n, const uint16_t* x, const uint16_t* y) {
+	float s0 = 0, s1 = 0;
+	uint64_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		s0 += HalfToFloat(x[i]) * HalfToFloat(y[i]);
+		s1 += HalfToFloat(x[i + 1]) * HalfToFloat(y[i + 1]);
+	}
+	for (; i < n; ++i) {
+		s0 += HalfToFloat(x[i]) * HalfToFloat(y[i]);
+	}
+	return s0 + s1;
+}
+
+float DotBF16(uint64_t n, const uint16_t* x, const uint16_t* y) {
+	float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		s0 += BFloat16ToFloat(x[i]) * BFloat16ToFloat(y[i]);
+		s1 += BFloat16ToFloat(x[i + 1]) * BFloat16ToFloat(y[i + 1]);
+		s2 += BFloat16ToFloat(x[i + 2]) * BFloat16ToFloat(y[i + 2]);
+		s3 += BFloat16ToFloat(x[i + 3]) * BFloat16ToFloat(y[i + 3]);
+	}
+	for (; i < n; ++i) {
+		s0 += BFloat16ToFloat(x[i]) * BFloat16ToFloat(y[i]);
+	}
+	return (s0 + s1) + (s2 + s3);
+}
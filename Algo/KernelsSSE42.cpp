@@ -0,0 +1,83 @@
+#include "Kernels.hpp"
+#include "LowPrecision.hpp"
+
+// compiled with -msse4.2 (no flag needed on MSVC x64)
+
+#include <nmmintrin.h>
+
+namespace {
+
+float Dot(uint64_t n, const float* x, const float* y) {
+	__m128 acc0 = _mm_setzero_ps();
+	__m128 acc1 = _mm_setzero_ps();
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(y + i + 4)));
+	}
+	for (; i + 4 <= n; i += 4) {
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+	}
+	acc0 = _mm_add_ps(acc0, acc1);
+	acc0 = _mm_hadd_ps(acc0, acc0);
+	acc0 = _mm_hadd_ps(acc0, acc0);
+	float res = _mm_cvtss_f32(acc0);
+	for (; i < n; ++i) {
+		res += x[i] * y[i];
+	}
+	return res;
+}
+
+double Dot(uint64_t n, const double* x, const double* y) {
+	__m128d acc0 = _mm_setzero_pd();
+	__m128d acc1 = _mm_setzero_pd();
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+		acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+	}
+	acc0 = _mm_add_pd(acc0, acc1);
+	acc0 = _mm_hadd_pd(acc0, acc0);
+	double res = _mm_cvtsd_f64(acc0);
+	for (; i < n; ++i) {
+		res += x[i] * y[i];
+	}
+	return res;
+}
+
+void Axpy(uint64_t n, float a, const float* x, float* y) {
+	__m128 va = _mm_set1_ps(a);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+void Axpy(uint64_t n, double a, const double* x, double* y) {
+	__m128d va = _mm_set1_pd(a);
+	uint64_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		_mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+	}
+	for (; i < n; ++i) {
+		y[i] += a * x[i];
+	}
+}
+
+#include "KernelsComplex.inl"
+#include "KernelsQuant.inl"
+#include "KernelsGemm.inl"
+#include "KernelsBatch.inl"
+#include "KernelsHash.inl"
+
+}
+
+const KernelTable& GetKernelsSSE42() noexcept {
+	static const KernelTable table = { ISA_SSE42, Sdot, Ddot, Saxpy, Daxpy, Sgemm, Dgemm,
+		Caxpy, Zaxpy, Cdot, Zdot, SluBatch, DluBatch,
+		DotI8, DotI16, DotF16, DotBF16, Hash64 };
+	return table;
+}
@@ -0,0 +1,77 @@
+#include "Kernels.hpp"
+
+// compiled with the AVX-512 flags plus -mavx512vnni (/arch:AVX512 on MSVC), only
+// patched into the AVX-512 table when the CPU reports AVX512_VNNI
+
+// the intrinsic headers are included with the same GCC 12 warning workaround as KernelsAVX512.cpp
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+// lane sum modulo 2^32, as in KernelsAVX512.cpp
+inline uint32_t WrappingSum(__m512i v) {
+	__m256i s = _mm256_add_epi32(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+	__m128i t = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+	t = _mm_add_epi32(t, _mm_shuffle_epi32(t, 0x4E));
+	t = _mm_add_epi32(t, _mm_shuffle_epi32(t, 0xB1));
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(t));
+}
+
+/*
+	vpdpbusd multiplies unsigned by signed bytes, so x is biased to x + 128 (a sign
+	bit flip) and 128 * sum(y) is taken back out; the sum comes from a second
+	vpdpbusd against a vector of ones. The correction is done modulo 2^32, 128 *
+	sum(y) alone leaves the int32 range from n ~ 132k on.
+*/
+int32_t DotI8(uint64_t n, const int8_t* x, const int8_t* y) {
+	const __m512i bias = _mm512_set1_epi8(static_cast<char>(0x80));
+	const __m512i ones = _mm512_set1_epi8(1);
+	__m512i acc = _mm512_setzero_si512();
+	__m512i sum_y = _mm512_setzero_si512();
+	uint64_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+		__m512i vx = _mm512_xor_si512(_mm512_loadu_si512(x + i), bias);
+		__m512i vy = _mm512_loadu_si512(y + i);
+		acc = _mm512_dpbusd_epi32(acc, vx, vy);
+		sum_y = _mm512_dpbusd_epi32(sum_y, ones, vy);
+	}
+	if (i < n) {
+		// masked-off lanes load y = 0, so the biased x there contributes nothing
+		__mmask64 tail = (1ull << (n - i)) - 1;
+		__m512i vx = _mm512_xor_si512(_mm512_maskz_loadu_epi8(tail, x + i), bias);
+		__m512i vy = _mm512_maskz_loadu_epi8(tail, y + i);
+		acc = _mm512_dpbusd_epi32(acc, vx, vy);
+		sum_y = _mm512_dpbusd_epi32(sum_y, ones, vy);
+	}
+	return static_cast<int32_t>(WrappingSum(acc) - 128u * WrappingSum(sum_y));
+}
+
+int32_t DotI16(uint64_t n, const int16_t* x, const int16_t* y) {
+	__m512i acc0 = _mm512_setzero_si512();
+	__m512i acc1 = _mm512_setzero_si512();
+	uint64_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+		acc0 = _mm512_dpwssd_epi32(acc0, _mm512_loadu_si512(x + i), _mm512_loadu_si512(y + i));
+		acc1 = _mm512_dpwssd_epi32(acc1, _mm512_loadu_si512(x + i + 32), _mm512_loadu_si512(y + i + 32));
+	}
+	for (; i < n; i += 32) {
+		__mmask32 tail = n - i >= 32 ? ~0u : static_cast<__mmask32>((1ull << (n - i)) - 1);
+		acc0 = _mm512_dpwssd_epi32(acc0, _mm512_maskz_loadu_epi16(tail, x + i), _mm512_maskz_loadu_epi16(tail, y + i));
+	}
+	return static_cast<int32_t>(WrappingSum(_mm512_add_epi32(acc0, acc1)));
+}
+
+}
+
+void PatchKernelsVNNI(KernelTable& table) noexcept {
+	table.dot_i8 = DotI8;
+	table.dot_i16 = DotI16;
+}
@@ -0,0 +1,667 @@
+#ifndef _KRYLOV_H
+#define _KRYLOV_H
+
+#include "CsrQMatrix.hpp"
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include "ThreadPool.hpp"
+#include <stdint.h>
+#include <cmath>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+	Iterative solvers for A x = b that only touch A through products A v.
+
+	  CG        symmetric positive definite A (and M), 4 vectors
+	  BiCGSTAB  general A, right preconditioned, 7 vectors
+	  GMRES     general A, restarted every restart steps, right preconditioned,
+	            restart + 3 vectors and a (restart + 1) x restart Hessenberg matrix
+
+	A is a LinearOperator: a dense QMatrix, a CsrQMatrix or any y = A x callback.
+	The preconditioner M ~ A^-1 is applied the same way, as z = M r; identity when
+	none is given. x holds the initial guess on entry (zeros when it is empty) and
+	the solution on exit. The iteration stops once ||b - A x|| <= tol ||b||.
+
+	Vector operations are split into chunks of KRYLOV_CHUNK entries across the
+	shared pool. Partial dot products are summed in chunk order, so the result does
+	not depend on which thread ran what.
+*/
+
+#define KRYLOV_CHUNK 16384
+
+struct KrylovOptions {
+	double tol = 1e-8;
+	uint64_t max_iters = 1000;
+	uint64_t restart = 50;
+	// called after every iteration with the relative residual, false stops the solve
+	std::function<bool(uint64_t, double)> monitor;
+};
+
+struct KrylovResult {
+	bool converged = false;
+	uint64_t iters = 0;
+	double residual = 0.0;
+	std::vector<double> history;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// f(lo, hi) over chunks of [0, n)
+template<typename F>
+void _vchunks(uint64_t n, F f) {
+	uint64_t chunks = (n + KRYLOV_CHUNK - 1) / KRYLOV_CHUNK;
+	if (chunks <= 1) {
+		f(0, n);
+		return;
+	}
+	ThreadPool::Shared().ParallelFor(0, chunks, [&](uint64_t c) {
+		uint64_t lo = c * KRYLOV_CHUNK;
+		f(lo, lo + KRYLOV_CHUNK < n ? lo + KRYLOV_CHUNK : n);
+	});
+}
+
+template<typename T>
+T _vdot(uint64_t n, const T* x, const T* y) {
+	uint64_t chunks = (n + KRYLOV_CHUNK - 1) / KRYLOV_CHUNK;
+	if (chunks <= 1) {
+		return _dot<T>(n, x, y);
+	}
+	std::vector<T> _tmp_partial(SAFE_UINT(chunks));
+	_vchunks(n, [&](uint64_t lo, uint64_t hi) {
+		_tmp_partial[lo / KRYLOV_CHUNK] = _dot<T>(hi - lo, x + lo, y + lo);
+	});
+	T res = static_cast<T>(0);
+	for (T p : _tmp_partial) {
+		res += p;
+	}
+	return res;
+}
+
+template<typename T>
+double _vnorm(uint64_t n, const T* x) {
+	return std::sqrt(static_cast<double>(_vdot<T>(n, x, x)));
+}
+
+// y += a x
+template<typename T>
+void _vaxpy(uint64_t n, T a, const T* x, T* y) {
+	_vchunks(n, [&](uint64_t lo, uint64_t hi) {
+		_axpy<T>(hi - lo, a, x + lo, y + lo);
+	});
+}
+
+// x = a x
+template<typename T>
+void _vscale(uint64_t n, T a, T* x) {
+	_vchunks(n, [&](uint64_t lo, uint64_t hi) {
+		for (uint64_t i = lo; i < hi; ++i) {
+			x[i] *= a;
+		}
+	});
+}
+
+// y = x + b y
+template<typename T>
+void _vxpby(uint64_t n, const T* x, T b, T* y) {
+	_vchunks(n, [&](uint64_t lo, uint64_t hi) {
+		for (uint64_t i = lo; i < hi; ++i) {
+			y[i] = x[i] + b * y[i];
+		}
+	});
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Square operator y = A x. The dense and sparse constructors keep a reference to
+	the matrix, which has to outlive the operator.
+*/
+template<typename T>
+class LinearOperator {
+public:
+	LinearOperator(uint64_t n, std::function<void(const T*, T*)> f) : n(n), f(std::move(f)) {}
+
+	LinearOperator(const QMatrix<T>& a) : n(a.GetN()) {
+		if (!a.IsSquare()) {
+			merror("Cannot solve with a non-square matrix!", E_MAT_INVALID_DIMENSION);
+		}
+		QMatrixView<const T> av = a.View();
+		f = [av](const T* x, T* y) {
+			uint64_t m = av.GetM();
+			uint64_t rows = KRYLOV_CHUNK / (m ? m : 1);
+			rows = rows ? rows : 1;
+			ThreadPool::Shared().ParallelFor(0, av.GetN(), [&](uint64_t i) {
+				y[i] = _dot<T>(m, &av(i, 0), x);
+			}, rows);
+		};
+	}
+
+	LinearOperator(const CsrQMatrix<T>& a) : n(a.GetN()) {
+		if (a.GetN() != a.GetM()) {
+			merror("Cannot solve with a non-square matrix!", E_MAT_INVALID_DIMENSION);
+		}
+		const CsrQMatrix<T>* ap = &a;
+		f = [ap](const T* x, T* y) { ap->Multiply(x, y); };
+	}
+
+	uint64_t GetN() const noexcept { return n; }
+	void Apply(const T* x, T* y) const { f(x, y); }
+
+private:
+	uint64_t n;
+	std::function<void(const T*, T*)> f;
+};
+
+/*
+	z = M r for any class with GetN() and Apply(const T* r, T* z) const, which is
+	copied in. Default constructed it is the identity.
+*/
+template<typename T>
+class Preconditioner {
+public:
+	Preconditioner() : n(0) {}
+
+	template<typename P, typename = std::enable_if_t<!std::is_same_v<std::decay_t<P>, Preconditioner<T>>>>
+	Preconditioner(P&& p) : n(p.GetN()) {
+		f = [p = std::decay_t<P>(std::forward<P>(p))](const T* r, T* z) { p.Apply(r, z); };
+	}
+
+	// 0 for the identity
+	uint64_t GetN() const noexcept { return n; }
+
+	void Apply(uint64_t count, const T* r, T* z) const {
+		if (f) {
+			f(r, z);
+			return;
+		}
+		_vchunks(count, [&](uint64_t lo, uint64_t hi) {
+			for (uint64_t i = lo; i < hi; ++i) {
+				z[i] = r[i];
+			}
+		});
+	}
+
+private:
+	uint64_t n;
+	std::function<void(const T*, T*)> f;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// M = diag(A)^-1, zero diagonal entries are left as 1
+template<typename T>
+class JacobiPreconditioner {
+public:
+	explicit JacobiPreconditioner(const QMatrix<T>& a) : inv(SAFE_UINT(a.GetN())) {
+		for (uint64_t i = 0; i < inv.size(); ++i) {
+			inv[i] = a.GetItem(i, i);
+		}
+		_invert();
+	}
+
+	explicit JacobiPreconditioner(const CsrQMatrix<T>& a) : inv(SAFE_UINT(a.GetN())) {
+		for (uint64_t i = 0; i < inv.size(); ++i) {
+			inv[i] = a.GetItem(i, i);
+		}
+		_invert();
+	}
+
+	uint64_t GetN() const noexcept { return inv.size(); }
+
+	void Apply(const T* r, T* z) const {
+		_vchunks(inv.size(), [&](uint64_t lo, uint64_t hi) {
+			for (uint64_t i = lo; i < hi; ++i) {
+				z[i] = inv[i] * r[i];
+			}
+		});
+	}
+
+private:
+	void _invert() {
+		bool zero = false;
+		for (T& d : inv) {
+			zero = zero || d == static_cast<T>(0);
+			d = d == static_cast<T>(0) ? static_cast<T>(1) : static_cast<T>(1) / d;
+		}
+		if (zero) {
+			merror("Jacobi preconditioner: zero on the diagonal, left unscaled", WARN);
+		}
+	}
+
+	std::vector<T> inv;
+};
+
+/*
+	Incomplete LU without fill-in: L U keeps the sparsity pattern of A and matches
+	A on it. Every row needs a stored, non-zero diagonal entry. The triangular
+	solves of Apply are sequential.
+*/
+template<typename T>
+class Ilu0Preconditioner {
+public:
+	explicit Ilu0Preconditioner(const QMatrix<T>& a) : Ilu0Preconditioner(CsrQMatrix<T>(a)) {}
+
+	explicit Ilu0Preconditioner(const CsrQMatrix<T>& a) : n(a.GetN()), row_ptr(a.RowPtr()), col_idx(a.ColIdx()),
+		vals(a.Values()), diag(SAFE_UINT(a.GetN())) {
+		if (a.GetN() != a.GetM()) {
+			merror("Cannot apply ILU(0) to non-square matrix!", E_MAT_INVALID_DIMENSION);
+			n = 0;
+			return;
+		}
+		const uint64_t none = ~0ull;
+		std::vector<uint64_t> pos(SAFE_UINT(n), none);
+		for (uint64_t i = 0; i < n; ++i) {
+			diag[i] = none;
+			for (uint64_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+				pos[col_idx[p]] = p;
+				if (col_idx[p] == i) {
+					diag[i] = p;
+				}
+			}
+			if (diag[i] == none) {
+				merror("ILU(0): missing diagonal entry!", SEVERE);
+				n = 0;
+				return;
+			}
+			for (uint64_t p = row_ptr[i]; p < diag[i]; ++p) {
+				uint64_t k = col_idx[p];
+				T lik = vals[p] / vals[diag[k]];
+				vals[p] = lik;
+				for (uint64_t q = diag[k] + 1; q < row_ptr[k + 1]; ++q) {
+					if (pos[col_idx[q]] != none) {
+						vals[pos[col_idx[q]]] -= lik * vals[q];
+					}
+				}
+			}
+			if (vals[diag[i]] == static_cast<T>(0)) {
+				merror("ILU(0): zero pivot!", SEVERE);
+				n = 0;
+				return;
+			}
+			for (uint64_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+				pos[col_idx[p]] = none;
+			}
+		}
+	}
+
+	uint64_t GetN() const noexcept { return n; }
+
+	// z = U^-1 L^-1 r, the identity when the factorization failed
+	void Apply(const T* r, T* z) const {
+		if (n == 0) {
+			for (uint64_t i = 0; i < diag.size(); ++i) {
+				z[i] = r[i];
+			}
+			return;
+		}
+		for (uint64_t i = 0; i < n; ++i) {
+			T acc = r[i];
+			for (uint64_t p = row_ptr[i]; p < diag[i]; ++p) {
+				acc -= vals[p] * z[col_idx[p]];
+			}
+			z[i] = acc;
+		}
+		for (uint64_t i = n; i-- > 0;) {
+			T acc = z[i];
+			for (uint64_t p = diag[i] + 1; p < row_ptr[i + 1]; ++p) {
+				acc -= vals[p] * z[col_idx[p]];
+			}
+			z[i] = acc / vals[diag[i]];
+		}
+	}
+
+private:
+	uint64_t n;
+	std::vector<uint64_t> row_ptr;
+	std::vector<uint64_t> col_idx;
+	std::vector<T> vals;
+	std::vector<uint64_t> diag;
+};
+
+/*
+	M = blockdiag(A_11, A_22, ...)^-1 over consecutive blocks of block rows (the last
+	one may be smaller). The dense diagonal blocks are LU factored with partial
+	pivoting, and blocks are factored and applied in parallel.
+*/
+template<typename T>
+class BlockJacobiPreconditioner {
+public:
+	BlockJacobiPreconditioner(const QMatrix<T>& a, uint64_t block) {
+		QMatrixView<const T> av = a.View();
+		_factor(a.GetN(), block, [&](uint64_t i, uint64_t lo, uint64_t hi, T* row) {
+			for (uint64_t j = lo; j < hi; ++j) {
+				row[j - lo] = av(i, j);
+			}
+		});
+	}
+
+	BlockJacobiPreconditioner(const CsrQMatrix<T>& a, uint64_t block) {
+		const std::vector<uint64_t>& rp = a.RowPtr();
+		const std::vector<uint64_t>& ci = a.ColIdx();
+		const std::vector<T>& v = a.Values();
+		_factor(a.GetN(), block, [&](uint64_t i, uint64_t lo, uint64_t hi, T* row) {
+			for (uint64_t p = rp[i]; p < rp[i + 1]; ++p) {
+				if (ci[p] >= lo && ci[p] < hi) {
+					row[ci[p] - lo] = v[p];
+				}
+			}
+		});
+	}
+
+	uint64_t GetN() const noexcept { return n; }
+
+	void Apply(const T* r, T* z) const {
+		ThreadPool::Shared().ParallelFor(0, starts.size() - 1, [&](uint64_t b) {
+			uint64_t lo = starts[b];
+			uint64_t bs = starts[b + 1] - lo;
+			for (uint64_t i = lo; i < lo + bs; ++i) {
+				z[i] = r[i];
+			}
+			QMatrixView<const T> lu = QMatrixView<const T>::Of(factors.data() + offsets[b], bs, bs, Layout::RowMajor);
+			_lu_pivot_solve(lu, piv.data() + lo, z + lo);
+		});
+	}
+
+private:
+	template<typename F>
+	void _factor(uint64_t count, uint64_t block, F fill_row) {
+		n = count;
+		block = block ? block : 1;
+		starts.push_back(0);
+		offsets.push_back(0);
+		while (starts.back() < n) {
+			uint64_t bs = n - starts.back() < block ? n - starts.back() : block;
+			starts.push_back(starts.back() + bs);
+			offsets.push_back(offsets.back() + bs * bs);
+		}
+		factors.assign(SAFE_UINT(offsets.back()), static_cast<T>(0));
+		piv.resize(SAFE_UINT(n));
+
+		std::vector<char> singular(starts.size() - 1, 0);
+		ThreadPool::Shared().ParallelFor(0, starts.size() - 1, [&](uint64_t b) {
+			uint64_t lo = starts[b];
+			uint64_t bs = starts[b + 1] - lo;
+			T* blk = factors.data() + offsets[b];
+			for (uint64_t i = 0; i < bs; ++i) {
+				fill_row(lo + i, lo, lo + bs, blk + i * bs);
+			}
+			_lu_pivot_in_place(QMatrixView<T>::Of(blk, bs, bs, Layout::RowMajor), piv.data() + lo);
+			for (uint64_t i = 0; i < bs; ++i) {
+				if (blk[i * bs + i] == static_cast<T>(0)) {
+					// an identity block instead of dividing by zero
+					singular[b] = 1;
+					for (uint64_t k = 0; k < bs * bs; ++k) {
+						blk[k] = k % (bs + 1) == 0 ? static_cast<T>(1) : static_cast<T>(0);
+					}
+					for (uint64_t k = 0; k < bs; ++k) {
+						piv[lo + k] = static_cast<uint32_t>(k);
+					}
+					break;
+				}
+			}
+		});
+		for (char s : singular) {
+			if (s) {
+				merror("Block-Jacobi preconditioner: singular diagonal block left unscaled", WARN);
+				break;
+			}
+		}
+	}
+
+	uint64_t n = 0;
+	std::vector<uint64_t> starts;
+	std::vector<uint64_t> offsets;
+	std::vector<T> factors;
+	std::vector<uint32_t> piv;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// common argument checks, x is sized to n; false when there is nothing to iterate
+template<typename T>
+bool _krylov_setup(const LinearOperator<T>& op, const std::vector<T>& b, std::vector<T>& x,
+	const Preconditioner<T>& m, KrylovResult& res) {
+	uint64_t n = op.GetN();
+	if (b.size() != n || (!x.empty() && x.size() != n) || (m.GetN() != 0 && m.GetN() != n)) {
+		merror("Operator, right-hand side and initial guess have different dimensions!", E_MAT_INVALID_DIMENSION);
+		return false;
+	}
+	if (x.empty()) {
+		x.assign(SAFE_UINT(n), static_cast<T>(0));
+	}
+	if (_vnorm<T>(n, b.data()) == 0.0) {
+		x.assign(SAFE_UINT(n), static_cast<T>(0));
+		res.converged = true;
+		return false;
+	}
+	return true;
+}
+
+// records one iteration, false when the solve should stop
+inline bool _krylov_step(const KrylovOptions& opt, KrylovResult& res, double rel) {
+	++res.iters;
+	res.residual = rel;
+	res.history.push_back(rel);
+	res.converged = rel <= opt.tol;
+	if (res.converged || res.iters >= opt.max_iters || !std::isfinite(rel)) {
+		return false;
+	}
+	return !opt.monitor || opt.monitor(res.iters, rel);
+}
+
+// r = b - A x
+template<typename T>
+void _krylov_residual(const LinearOperator<T>& op, const std::vector<T>& b, const std::vector<T>& x, T* r) {
+	uint64_t n = op.GetN();
+	op.Apply(x.data(), r);
+	_vxpby<T>(n, b.data(), static_cast<T>(-1), r);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename Op, typename T>
+KrylovResult CG(const Op& a, const std::vector<T>& b, std::vector<T>& x, const KrylovOptions& opt = {},
+	const std::type_identity_t<Preconditioner<T>>& m = {}) {
+	static_assert(std::is_floating_point_v<T>, "Krylov solvers need a real floating point element type");
+	LinearOperator<T> op(a);
+	KrylovResult res;
+	if (!_krylov_setup(op, b, x, m, res)) {
+		return res;
+	}
+	uint64_t n = op.GetN();
+	double bnorm = _vnorm<T>(n, b.data());
+
+	std::vector<T> r(SAFE_UINT(n)), z(SAFE_UINT(n)), p(SAFE_UINT(n)), q(SAFE_UINT(n));
+	_krylov_residual(op, b, x, r.data());
+	res.residual = _vnorm<T>(n, r.data()) / bnorm;
+	if (res.residual <= opt.tol || opt.max_iters == 0) {
+		res.converged = res.residual <= opt.tol;
+		return res;
+	}
+	m.Apply(n, r.data(), z.data());
+	p = z;
+	T rz = _vdot<T>(n, r.data(), z.data());
+
+	while (true) {
+		op.Apply(p.data(), q.data());
+		T pq = _vdot<T>(n, p.data(), q.data());
+		if (pq == static_cast<T>(0)) {
+			break;
+		}
+		T alpha = rz / pq;
+		_vaxpy<T>(n, alpha, p.data(), x.data());
+		_vaxpy<T>(n, -alpha, q.data(), r.data());
+		if (!_krylov_step(opt, res, _vnorm<T>(n, r.data()) / bnorm)) {
+			break;
+		}
+		m.Apply(n, r.data(), z.data());
+		T rz_next = _vdot<T>(n, r.data(), z.data());
+		_vxpby<T>(n, z.data(), rz_next / rz, p.data());
+		rz = rz_next;
+	}
+	return res;
+}
+
+template<typename Op, typename T>
+KrylovResult BiCGSTAB(const Op& a, const std::vector<T>& b, std::vector<T>& x, const KrylovOptions& opt = {},
+	const std::type_identity_t<Preconditioner<T>>& m = {}) {
+	static_assert(std::is_floating_point_v<T>, "Krylov solvers need a real floating point element type");
+	LinearOperator<T> op(a);
+	KrylovResult res;
+	if (!_krylov_setup(op, b, x, m, res)) {
+		return res;
+	}
+	uint64_t n = op.GetN();
+	double bnorm = _vnorm<T>(n, b.data());
+
+	// r doubles as s
+	std::vector<T> r(SAFE_UINT(n)), r0(SAFE_UINT(n)), p(SAFE_UINT(n), static_cast<T>(0)), v(SAFE_UINT(n), static_cast<T>(0));
+	std::vector<T> ph(SAFE_UINT(n)), sh(SAFE_UINT(n)), t(SAFE_UINT(n));
+	_krylov_residual(op, b, x, r.data());
+	res.residual = _vnorm<T>(n, r.data()) / bnorm;
+	if (res.residual <= opt.tol || opt.max_iters == 0) {
+		res.converged = res.residual <= opt.tol;
+		return res;
+	}
+	r0 = r;
+	T rho = static_cast<T>(1), alpha = static_cast<T>(1), omega = static_cast<T>(1);
+
+	while (true) {
+		T rho_next = _vdot<T>(n, r0.data(), r.data());
+		if (rho_next == static_cast<T>(0) || omega == static_cast<T>(0)) {
+			break;
+		}
+		// p = r + beta (p - omega v)
+		T beta = (rho_next / rho) * (alpha / omega);
+		_vaxpy<T>(n, -omega, v.data(), p.data());
+		_vxpby<T>(n, r.data(), beta, p.data());
+		rho = rho_next;
+
+		m.Apply(n, p.data(), ph.data());
+		op.Apply(ph.data(), v.data());
+		T r0v = _vdot<T>(n, r0.data(), v.data());
+		if (r0v == static_cast<T>(0)) {
+			break;
+		}
+		alpha = rho / r0v;
+		_vaxpy<T>(n, alpha, ph.data(), x.data());
+		_vaxpy<T>(n, -alpha, v.data(), r.data());
+		double rel = _vnorm<T>(n, r.data()) / bnorm;
+		if (rel <= opt.tol) {
+			_krylov_step(opt, res, rel);
+			break;
+		}
+
+		m.Apply(n, r.data(), sh.data());
+		op.Apply(sh.data(), t.data());
+		T tt = _vdot<T>(n, t.data(), t.data());
+		omega = tt == static_cast<T>(0) ? static_cast<T>(0) : _vdot<T>(n, t.data(), r.data()) / tt;
+		_vaxpy<T>(n, omega, sh.data(), x.data());
+		_vaxpy<T>(n, -omega, t.data(), r.data());
+		if (!_krylov_step(opt, res, _vnorm<T>(n, r.data()) / bnorm)) {
+			break;
+		}
+	}
+	return res;
+}
+
+template<typename Op, typename T>
+KrylovResult GMRES(const Op& a, const std::vector<T>& b, std::vector<T>& x, const KrylovOptions& opt = {},
+	const std::type_identity_t<Preconditioner<T>>& m = {}) {
+	static_assert(std::is_floating_point_v<T>, "Krylov solvers need a real floating point element type");
+	LinearOperator<T> op(a);
+	KrylovResult res;
+	if (!_krylov_setup(op, b, x, m, res)) {
+		return res;
+	}
+	uint64_t n = op.GetN();
+	uint64_t k = opt.restart ? opt.restart : 1;
+	double bnorm = _vnorm<T>(n, b.data());
+
+	// Krylov basis in the rows of basis, h is (k + 1) x k row-major
+	std::vector<T> basis(SAFE_UINT((k + 1) * n));
+	std::vector<T> w(SAFE_UINT(n)), z(SAFE_UINT(n));
+	std::vector<T> h(SAFE_UINT((k + 1) * k)), cs(SAFE_UINT(k)), sn(SAFE_UINT(k)), g(SAFE_UINT(k + 1)), y(SAFE_UINT(k));
+
+	bool more = opt.max_iters > 0;
+	while (true) {
+		T* v0 = basis.data();
+		_krylov_residual(op, b, x, v0);
+		T beta = static_cast<T>(_vnorm<T>(n, v0));
+		res.residual = beta / bnorm;
+		res.converged = res.residual <= opt.tol;
+		if (res.converged || !more) {
+			break;
+		}
+		_vscale<T>(n, static_cast<T>(1) / beta, v0);
+		for (T& e : g) {
+			e = static_cast<T>(0);
+		}
+		g[0] = beta;
+
+		uint64_t j = 0;
+		while (j < k && more) {
+			T* vj = basis.data() + j * n;
+			T* vn = vj + n;
+			m.Apply(n, vj, z.data());
+			op.Apply(z.data(), vn);
+			// modified Gram-Schmidt
+			for (uint64_t i = 0; i <= j; ++i) {
+				T hij = _vdot<T>(n, basis.data() + i * n, vn);
+				h[i * k + j] = hij;
+				_vaxpy<T>(n, -hij, basis.data() + i * n, vn);
+			}
+			T hn = static_cast<T>(_vnorm<T>(n, vn));
+			h[(j + 1) * k + j] = hn;
+			if (hn != static_cast<T>(0)) {
+				_vscale<T>(n, static_cast<T>(1) / hn, vn);
+			}
+
+			// rotate column j into upper triangular form
+			for (uint64_t i = 0; i < j; ++i) {
+				T t0 = h[i * k + j];
+				T t1 = h[(i + 1) * k + j];
+				h[i * k + j] = cs[i] * t0 + sn[i] * t1;
+				h[(i + 1) * k + j] = -sn[i] * t0 + cs[i] * t1;
+			}
+			T d = std::hypot(h[j * k + j], hn);
+			cs[j] = d == static_cast<T>(0) ? static_cast<T>(1) : h[j * k + j] / d;
+			sn[j] = d == static_cast<T>(0) ? static_cast<T>(0) : hn / d;
+			h[j * k + j] = d;
+			h[(j + 1) * k + j] = static_cast<T>(0);
+			g[j + 1] = -sn[j] * g[j];
+			g[j] = cs[j] * g[j];
+			++j;
+
+			more = _krylov_step(opt, res, std::abs(static_cast<double>(g[j])) / bnorm);
+			// a zero hn means the solution lies in the current space
+			if (hn == static_cast<T>(0)) {
+				break;
+			}
+		}
+
+		// x += M V y with H y = g
+		for (uint64_t i = j; i-- > 0;) {
+			T acc = g[i];
+			for (uint64_t l = i + 1; l < j; ++l) {
+				acc -= h[i * k + l] * y[l];
+			}
+			y[i] = h[i * k + i] == static_cast<T>(0) ? static_cast<T>(0) : acc / h[i * k + i];
+		}
+		for (T& e : w) {
+			e = static_cast<T>(0);
+		}
+		for (uint64_t i = 0; i < j; ++i) {
+			_vaxpy<T>(n, y[i], basis.data() + i * n, w.data());
+		}
+		m.Apply(n, w.data(), z.data());
+		_vaxpy<T>(n, static_cast<T>(1), z.data(), x.data());
+	}
+	return res;
+}
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef _LOW_PRECISION_H
+#define _LOW_PRECISION_H
+
+#include <stdint.h>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+/*
+	16-bit floating point storage types.
+
+	Half is IEEE binary16, BFloat16 the upper half of a binary32. Both only store;
+	arithmetic happens in float through the implicit conversions, and matrix
+	products accumulate in float through the dispatched fp16/bf16 dot kernels.
+	Conversions from float round to nearest even.
+
+	_acc_type<T> is the type products of T are summed in: int32_t for int8_t and
+	int16_t, float for Half and BFloat16, T itself otherwise.
+*/
+
+inline float _bits_to_float(uint32_t u) {
+	float f;
+	memcpy(&f, &u, sizeof(f));
+	return f;
+}
+
+inline uint32_t _float_to_bits(float f) {
+	uint32_t u;
+	memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+inline float HalfToFloat(uint16_t h) {
+	uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+	uint32_t exp = (h >> 10) & 0x1F;
+	uint32_t man = h & 0x3FF;
+
+	if (exp == 0x1F) {
+		return _bits_to_float(sign | 0x7F800000 | (man << 13));
+	}
+	if (exp == 0) {
+		// subnormal (or zero): man * 2^-24
+		float f = static_cast<float>(man) * 5.9604644775390625e-8f;
+		return sign ? -f : f;
+	}
+	return _bits_to_float(sign | ((exp + 112) << 23) | (man << 13));
+}
+
+inline uint16_t FloatToHalf(float f) {
+	uint32_t u = _float_to_bits(f);
+	uint16_t sign = static_cast<uint16_t>((u >> 16) & 0x8000);
+	uint32_t abs = u & 0x7FFFFFFF;
+
+	if (abs >= 0x7F800000) {
+		// inf stays inf, NaN keeps a payload bit so it stays NaN
+		return sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 : 0);
+	}
+	if (abs >= 0x477FF000) {
+		// rounds to a value past 65504
+		return sign | 0x7C00;
+	}
+	if (abs < 0x38800000) {
+		// result is subnormal in half: scale by 2^24 and round the integer
+		float scaled = _bits_to_float(abs) * 16777216.0f;
+		uint32_t man = static_cast<uint32_t>(scaled);
+		float rem = scaled - static_cast<float>(man);
+		if (rem > 0.5f || (rem == 0.5f && (man & 1))) {
+			++man;
+		}
+		return sign | static_cast<uint16_t>(man);
+	}
+
+	uint32_t mant_odd = (abs >> 13) & 1;
+	abs += 0xC8000FFF + mant_odd;  // rebias exponent (-112 << 23) and round to nearest even
+	return sign | static_cast<uint16_t>(abs >> 13);
+}
+
+inline float BFloat16ToFloat(uint16_t b) {
+	return _bits_to_float(static_cast<uint32_t>(b) << 16);
+}
+
+inline uint16_t FloatToBFloat16(float f) {
+	uint32_t u = _float_to_bits(f);
+	if ((u & 0x7FFFFFFF) > 0x7F800000) {
+		return static_cast<uint16_t>((u >> 16) | 0x40);
+	}
+	u += 0x7FFF + ((u >> 16) & 1);
+	return static_cast<uint16_t>(u >> 16);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Half {
+	uint16_t bits;
+
+	Half() = default;
+	Half(float f) : bits(FloatToHalf(f)) {}
+	operator float() const { return HalfToFloat(bits); }
+
+	static Half FromBits(uint16_t b) {
+		Half h;
+		h.bits = b;
+		return h;
+	}
+
+	Half& operator+=(float x) { return *this = Half(float(*this) + x); }
+	Half& operator-=(float x) { return *this = Half(float(*this) - x); }
+	Half& operator*=(float x) { return *this = Half(float(*this) * x); }
+	Half& operator/=(float x) { return *this = Half(float(*this) / x); }
+};
+
+struct BFloat16 {
+	uint16_t bits;
+
+	BFloat16() = default;
+	BFloat16(float f) : bits(FloatToBFloat16(f)) {}
+	operator float() const { return BFloat16ToFloat(bits); }
+
+	static BFloat16 FromBits(uint16_t b) {
+		BFloat16 h;
+		h.bits = b;
+		return h;
+	}
+
+	BFloat16& operator+=(float x) { return *this = BFloat16(float(*this) + x); }
+	BFloat16& operator-=(float x) { return *this = BFloat16(float(*this) - x); }
+	BFloat16& operator*=(float x) { return *this = BFloat16(float(*this) * x); }
+	BFloat16& operator/=(float x) { return *this = BFloat16(float(*this) / x); }
+};
+
+static_assert(sizeof(Half) == 2 && std::is_trivially_copyable_v<Half>, "Half must be a plain 16-bit value");
+static_assert(sizeof(BFloat16) == 2 && std::is_trivially_copyable_v<BFloat16>, "BFloat16 must be a plain 16-bit value");
+
+template<typename T> struct _acc_type { using type = T; };
+template<> struct _acc_type<int8_t> { using type = int32_t; };
+template<> struct _acc_type<int16_t> { using type = int32_t; };
+template<> struct _acc_type<Half> { using type = float; };
+template<> struct _acc_type<BFloat16> { using type = float; };
+
+template<typename T>
+using _acc_type_t = typename _acc_type<T>::type;
+
+// accumulator back to the element type, integers saturate instead of wrapping
+template<typename R, typename A>
+R _narrow(A x) {
+	if constexpr (std::is_integral_v<R> && std::is_integral_v<A> && (sizeof(R) < sizeof(A))) {
+		if (x > static_cast<A>(std::numeric_limits<R>::max())) {
+			return std::numeric_limits<R>::max();
+		}
+		if (x < static_cast<A>(std::numeric_limits<R>::min())) {
+			return std::numeric_limits<R>::min();
+		}
+	}
+	return static_cast<R>(x);
+}
+
+// element types whose products go through the widening dot kernels
+template<typename T> struct _is_low_precision : std::false_type {};
+template<> struct _is_low_precision<int8_t> : std::true_type {};
+template<> struct _is_low_precision<int16_t> : std::true_type {};
+template<> struct _is_low_precision<Half> : std::true_type {};
+template<> struct _is_low_precision<BFloat16> : std::true_type {};
+
+#endif
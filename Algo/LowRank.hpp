@@ -0,0 +1,902 @@
+#ifndef _LOW_RANK_H
+#define _LOW_RANK_H
+
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include "ThreadPool.hpp"
+#include "TiledQMatrix.hpp"
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+/*
+	Randomized low-rank approximation of large matrices.
+
+	A is only reached through a SketchSource, which wraps an in-memory view or a
+	file-backed TiledQMatrix, and only in whole passes: A X, A^T X, or a selection
+	of rows or columns. Views are split into panels across the shared pool. Tiled
+	matrices stream their tiles in file order and prefetch the next tile.
+
+	  RandomizedSVD   A ~ U S V^T, range finder plus q power iterations, 2q + 2 passes
+	  ColumnID        A ~ A[:, idx] X, 2q + 1 passes
+	  RowID           A ~ X A[idx, :], 2q + 1 passes
+	  CUR             A ~ C U R from a column ID and a row selection on C, 2q + 3 passes
+	  Nystrom         A ~ U L U^T for symmetric positive semidefinite A, q + 1 passes
+
+	rank + oversample columns are sketched, with a dense Gaussian test matrix or a
+	sparse sign one (sparsity entries of +-1/sqrt(sparsity) per row). The sparse one
+	makes the first pass cost sparsity instead of rank + oversample multiply-adds per
+	entry of A. Every half step of a power iteration is orthonormalized again so the
+	small singular values are not lost to rounding.
+*/
+
+enum class SketchKind {
+	Gaussian,
+	SparseSign
+};
+
+struct SketchOptions {
+	SketchKind kind = SketchKind::Gaussian;
+	uint64_t oversample = 10;
+	uint32_t power_iters = 1;
+	uint32_t sparsity = 8;
+	uint64_t seed = 0x5eed;
+};
+
+#define SKETCH_PANEL 256
+
+// c += a * b
+template<typename T>
+void _gemm_acc(QMatrixView<const T> a, QMatrixView<const T> b, QMatrixView<T> c) {
+	static thread_local std::vector<T> _tmp;
+	_tmp.resize(SAFE_UINT(c.GetN() * c.GetM()));
+	QMatrixView<T> tv = QMatrixView<T>::Of(_tmp.data(), c.GetN(), c.GetM(), Layout::RowMajor);
+	Gemm<T>(a, b, tv);
+	for (uint64_t i = 0; i < c.GetN(); ++i) {
+		if (c.IsRowContiguous()) {
+			_axpy<T>(c.GetM(), static_cast<T>(1), &tv(i, 0), &c(i, 0));
+		}
+		else {
+			for (uint64_t j = 0; j < c.GetM(); ++j) {
+				c(i, j) += tv(i, j);
+			}
+		}
+	}
+}
+
+template<typename T>
+void _zero(QMatrixView<T> y) {
+	for (uint64_t i = 0; i < y.GetN(); ++i) {
+		for (uint64_t j = 0; j < y.GetM(); ++j) {
+			y(i, j) = static_cast<T>(0);
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// n x l random test matrix
+template<typename T>
+class SketchMatrix {
+public:
+	SketchMatrix(uint64_t n, uint64_t l, const SketchOptions& opt) : kind(opt.kind), n(n), l(l), zeta(0) {
+		std::mt19937_64 gen(opt.seed);
+		if (kind == SketchKind::Gaussian || l == 0) {
+			kind = SketchKind::Gaussian;
+			std::normal_distribution<T> dist(static_cast<T>(0), static_cast<T>(1));
+			dense.resize(SAFE_UINT(n * l));
+			for (T& x : dense) {
+				x = dist(gen);
+			}
+			return;
+		}
+
+		zeta = opt.sparsity < 1 ? 1 : (opt.sparsity > l ? l : opt.sparsity);
+		T s = static_cast<T>(1) / std::sqrt(static_cast<T>(zeta));
+		std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(l - 1));
+		idx.resize(SAFE_UINT(n * zeta));
+		val.resize(SAFE_UINT(n * zeta));
+		for (uint64_t r = 0; r < n; ++r) {
+			uint32_t* ix = &idx[r * zeta];
+			for (uint64_t z = 0; z < zeta; ++z) {
+				uint32_t c;
+				do {
+					c = pick(gen);
+				} while (std::find(ix, ix + z, c) != ix + z);
+				ix[z] = c;
+				val[r * zeta + z] = (gen() & 1) ? s : -s;
+			}
+		}
+	}
+
+	uint64_t GetN() const noexcept { return n; }
+	uint64_t GetM() const noexcept { return l; }
+	SketchKind Kind() const noexcept { return kind; }
+
+	// Gaussian only
+	QMatrixView<const T> Dense() const noexcept {
+		return QMatrixView<const T>::Of(dense.data(), n, l, Layout::RowMajor);
+	}
+
+	QMatrix<T> ToQMatrix() const {
+		if (kind == SketchKind::Gaussian) {
+			return QMatrix<T>(Dense());
+		}
+		std::vector<T> _tmp_nums(SAFE_UINT(n * l), static_cast<T>(0));
+		for (uint64_t r = 0; r < n; ++r) {
+			for (uint64_t z = 0; z < zeta; ++z) {
+				_tmp_nums[r * l + idx[r * zeta + z]] = val[r * zeta + z];
+			}
+		}
+		return QMatrix<T>(_tmp_nums.data(), n, l);
+	}
+
+	// y += a * S[j0 : j0 + a.GetM(), :]
+	void ApplyRight(QMatrixView<const T> a, uint64_t j0, QMatrixView<T> y) const {
+		if (kind == SketchKind::Gaussian) {
+			_gemm_acc<T>(a, Dense().Sub(j0, 0, a.GetM(), l), y);
+			return;
+		}
+		auto scatter = [&](uint64_t i, uint64_t j) {
+			T v = a(i, j);
+			if (v == static_cast<T>(0)) {
+				return;
+			}
+			const uint32_t* ix = &idx[(j0 + j) * zeta];
+			const T* sv = &val[(j0 + j) * zeta];
+			for (uint64_t z = 0; z < zeta; ++z) {
+				y(i, ix[z]) += sv[z] * v;
+			}
+		};
+		// walk a along its contiguous direction
+		if (a.IsRowContiguous() || !a.IsColContiguous()) {
+			for (uint64_t i = 0; i < a.GetN(); ++i) {
+				for (uint64_t j = 0; j < a.GetM(); ++j) {
+					scatter(i, j);
+				}
+			}
+		}
+		else {
+			for (uint64_t j = 0; j < a.GetM(); ++j) {
+				for (uint64_t i = 0; i < a.GetN(); ++i) {
+					scatter(i, j);
+				}
+			}
+		}
+	}
+
+private:
+	SketchKind kind;
+	uint64_t n, l, zeta;
+	std::vector<T> dense;
+	std::vector<uint32_t> idx;
+	std::vector<T> val;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+class SketchSource {
+	static_assert(std::is_floating_point_v<T>, "Sketching needs a real floating point element type");
+
+public:
+	SketchSource(QMatrixView<const T> a, ThreadPool& pool = ThreadPool::Shared())
+		: view(a), tiled(nullptr), pool(&pool) {}
+	SketchSource(const QMatrix<T>& a, ThreadPool& pool = ThreadPool::Shared())
+		: SketchSource(a.View(), pool) {}
+	SketchSource(TiledQMatrix<T>& a)
+		: view(nullptr, a.GetN(), a.GetM(), 0, 0), tiled(&a), pool(&ThreadPool::Shared()) {}
+
+	uint64_t GetN() const noexcept { return view.GetN(); }
+	uint64_t GetM() const noexcept { return view.GetM(); }
+
+	// y = A x
+	void Multiply(QMatrixView<const T> x, QMatrixView<T> y) const {
+		if (!_check(x, y, GetM(), GetN())) {
+			return;
+		}
+		uint64_t k = x.GetM();
+		_zero(y);
+		_for_blocks(false, [&](uint64_t i0, uint64_t j0, QMatrixView<const T> blk) {
+			_gemm_acc<T>(blk, x.Sub(j0, 0, blk.GetM(), k), y.Sub(i0, 0, blk.GetN(), k));
+		});
+	}
+
+	// y = A^T x
+	void MultiplyT(QMatrixView<const T> x, QMatrixView<T> y) const {
+		if (!_check(x, y, GetN(), GetM())) {
+			return;
+		}
+		uint64_t k = x.GetM();
+		_zero(y);
+		_for_blocks(true, [&](uint64_t i0, uint64_t j0, QMatrixView<const T> blk) {
+			_gemm_acc<T>(blk.Transposed(), x.Sub(i0, 0, blk.GetN(), k), y.Sub(j0, 0, blk.GetM(), k));
+		});
+	}
+
+	// y = A s, s is m x l
+	void Sketch(const SketchMatrix<T>& s, QMatrixView<T> y) const {
+		if (s.Kind() == SketchKind::Gaussian) {
+			Multiply(s.Dense(), y);
+			return;
+		}
+		if (s.GetN() != GetM() || y.GetN() != GetN() || y.GetM() != s.GetM()) {
+			merror("Sketch does not match the matrix dimensions!", E_MAT_INVALID_DIMENSION);
+			return;
+		}
+		_zero(y);
+		_for_blocks(false, [&](uint64_t i0, uint64_t j0, QMatrixView<const T> blk) {
+			s.ApplyRight(blk, j0, y.Sub(i0, 0, blk.GetN(), y.GetM()));
+		});
+	}
+
+	// y = A^T s, s is n x l
+	void SketchT(const SketchMatrix<T>& s, QMatrixView<T> y) const {
+		if (s.Kind() == SketchKind::Gaussian) {
+			MultiplyT(s.Dense(), y);
+			return;
+		}
+		if (s.GetN() != GetN() || y.GetN() != GetM() || y.GetM() != s.GetM()) {
+			merror("Sketch does not match the matrix dimensions!", E_MAT_INVALID_DIMENSION);
+			return;
+		}
+		_zero(y);
+		_for_blocks(true, [&](uint64_t i0, uint64_t j0, QMatrixView<const T> blk) {
+			s.ApplyRight(blk.Transposed(), i0, y.Sub(j0, 0, blk.GetM(), y.GetM()));
+		});
+	}
+
+	// A[idx, :]
+	QMatrix<T> Rows(const std::vector<uint64_t>& idx) const {
+		uint64_t m = GetM();
+		std::vector<T> _tmp_nums(SAFE_UINT(idx.size() * m), static_cast<T>(0));
+		QMatrixView<T> out = QMatrixView<T>::Of(_tmp_nums.data(), idx.size(), m, Layout::RowMajor);
+		if (!_in_range(idx, GetN())) {
+			return QMatrix<T>(out);
+		}
+		if (tiled == nullptr) {
+			for (uint64_t r = 0; r < idx.size(); ++r) {
+				Copy<T>(view.Row(idx[r]), out.Row(r));
+			}
+			return QMatrix<T>(out);
+		}
+
+		uint64_t tile = tiled->GetTile();
+		for (uint64_t ti = 0; ti < tiled->TileRows(); ++ti) {
+			std::vector<uint64_t> hit;
+			for (uint64_t r = 0; r < idx.size(); ++r) {
+				if (idx[r] / tile == ti) {
+					hit.push_back(r);
+				}
+			}
+			for (uint64_t tj = 0; !hit.empty() && tj < tiled->TileCols(); ++tj) {
+				tiled->Prefetch(ti, tj + 1);
+				TileHandle<T> h = tiled->Tile(ti, tj);
+				for (uint64_t r : hit) {
+					Copy<T>(h.View().Row(idx[r] - ti * tile), out.Sub(r, tj * tile, 1, h.Cols()));
+				}
+			}
+		}
+		return QMatrix<T>(out);
+	}
+
+	// A[:, idx]
+	QMatrix<T> Cols(const std::vector<uint64_t>& idx) const {
+		uint64_t n = GetN();
+		std::vector<T> _tmp_nums(SAFE_UINT(n * idx.size()), static_cast<T>(0));
+		QMatrixView<T> out = QMatrixView<T>::Of(_tmp_nums.data(), n, idx.size(), Layout::RowMajor);
+		if (!_in_range(idx, GetM())) {
+			return QMatrix<T>(out);
+		}
+		if (tiled == nullptr) {
+			for (uint64_t c = 0; c < idx.size(); ++c) {
+				Copy<T>(view.Col(idx[c]), out.Col(c));
+			}
+			return QMatrix<T>(out);
+		}
+
+		uint64_t tile = tiled->GetTile();
+		for (uint64_t tj = 0; tj < tiled->TileCols(); ++tj) {
+			std::vector<uint64_t> hit;
+			for (uint64_t c = 0; c < idx.size(); ++c) {
+				if (idx[c] / tile == tj) {
+					hit.push_back(c);
+				}
+			}
+			for (uint64_t ti = 0; !hit.empty() && ti < tiled->TileRows(); ++ti) {
+				tiled->Prefetch(ti + 1, tj);
+				TileHandle<T> h = tiled->Tile(ti, tj);
+				for (uint64_t c : hit) {
+					Copy<T>(h.View().Col(idx[c] - tj * tile), out.Sub(ti * tile, c, h.Rows(), 1));
+				}
+			}
+		}
+		return QMatrix<T>(out);
+	}
+
+private:
+	static bool _check(QMatrixView<const T> x, QMatrixView<T> y, uint64_t xn, uint64_t yn) {
+		if (x.GetN() != xn || y.GetN() != yn || x.GetM() != y.GetM()) {
+			merror("Cannot multiply views with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return false;
+		}
+		return true;
+	}
+
+	static bool _in_range(const std::vector<uint64_t>& idx, uint64_t count) {
+		for (uint64_t i : idx) {
+			if (i >= count) {
+				merror("Selected index is out of range!", E_MAT_INVALID_DIMENSION);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/*
+		f(i0, j0, block) over a partition of A. A view is cut into full-width row
+		panels (or full-height column panels with by_cols) handled in parallel, so
+		blocks writing different output rows never race. Tiles are visited one at a
+		time in file order.
+	*/
+	template<typename F>
+	void _for_blocks(bool by_cols, F f) const {
+		if (tiled == nullptr) {
+			uint64_t count = by_cols ? GetM() : GetN();
+			uint64_t panels = (count + SKETCH_PANEL - 1) / SKETCH_PANEL;
+			pool->ParallelFor(0, panels, [&](uint64_t p) {
+				uint64_t lo = p * SKETCH_PANEL;
+				uint64_t w = count - lo < SKETCH_PANEL ? count - lo : SKETCH_PANEL;
+				if (by_cols) {
+					f(0, lo, view.Sub(0, lo, GetN(), w));
+				}
+				else {
+					f(lo, 0, view.Sub(lo, 0, w, GetM()));
+				}
+			});
+			return;
+		}
+
+		uint64_t tile = tiled->GetTile();
+		uint64_t tr = tiled->TileRows();
+		uint64_t tc = tiled->TileCols();
+		for (uint64_t ti = 0; ti < tr; ++ti) {
+			for (uint64_t tj = 0; tj < tc; ++tj) {
+				if (tj + 1 < tc) {
+					tiled->Prefetch(ti, tj + 1);
+				}
+				else {
+					tiled->Prefetch(ti + 1, 0);
+				}
+				TileHandle<T> h = tiled->Tile(ti, tj);
+				f(ti * tile, tj * tile, QMatrixView<const T>(h.View()));
+			}
+		}
+	}
+
+	QMatrixView<const T> view;
+	TiledQMatrix<T>* tiled;
+	ThreadPool* pool;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Orthonormal basis of the columns of y (n x l) by classical Gram-Schmidt run twice.
+	With r given, it receives the l x l upper factor of y = q r. Columns that lie in
+	the span of the earlier ones come out as zero columns of q.
+*/
+template<typename T>
+QMatrix<T> _orth(QMatrixView<const T> y, std::vector<T>* r = nullptr) {
+	uint64_t n = y.GetN();
+	uint64_t l = y.GetM();
+	const T eps = std::numeric_limits<T>::epsilon();
+
+	// columns as contiguous rows
+	std::vector<T> qt(SAFE_UINT(l * n));
+	Copy<T>(y.Transposed(), QMatrixView<T>::Of(qt.data(), l, n, Layout::RowMajor));
+	if (r != nullptr) {
+		r->assign(SAFE_UINT(l * l), static_cast<T>(0));
+	}
+
+	ThreadPool& pool = ThreadPool::Shared();
+	uint64_t grain = n >= 65536 ? 1 : 65536 / (n + 1) + 1;
+	uint64_t chunk = 4096;
+	uint64_t chunks = (n + chunk - 1) / chunk;
+	std::vector<T> c(SAFE_UINT(l));
+
+	for (uint64_t j = 0; j < l; ++j) {
+		T* v = &qt[j * n];
+		T norm0 = std::sqrt(_dot<T>(n, v, v));
+		for (int pass = 0; pass < 2 && j > 0; ++pass) {
+			pool.ParallelFor(0, j, [&](uint64_t t) {
+				c[t] = _dot<T>(n, &qt[t * n], v);
+			}, grain);
+			pool.ParallelFor(0, chunks, [&](uint64_t b) {
+				uint64_t lo = b * chunk;
+				uint64_t w = n - lo < chunk ? n - lo : chunk;
+				for (uint64_t t = 0; t < j; ++t) {
+					_axpy<T>(w, -c[t], &qt[t * n + lo], v + lo);
+				}
+			});
+			if (r != nullptr) {
+				for (uint64_t t = 0; t < j; ++t) {
+					(*r)[t * l + j] += c[t];
+				}
+			}
+		}
+
+		T norm = std::sqrt(_dot<T>(n, v, v));
+		if (norm == static_cast<T>(0) || norm <= static_cast<T>(64) * eps * norm0) {
+			std::fill(v, v + n, static_cast<T>(0));
+			continue;
+		}
+		T inv = static_cast<T>(1) / norm;
+		for (uint64_t i = 0; i < n; ++i) {
+			v[i] *= inv;
+		}
+		if (r != nullptr) {
+			(*r)[j * l + j] = norm;
+		}
+	}
+	return QMatrix<T>(QMatrixView<const T>::Of(qt.data(), l, n, Layout::RowMajor).Transposed());
+}
+
+/*
+	Thin SVD by one-sided (Hestenes) Jacobi, for the small dense factors of the
+	randomized methods. Returns {U (n x k), S (k x k diagonal), V (m x k)} with
+	a = U S V^T, k = min(n, m) and the singular values in descending order.
+*/
+template<typename T>
+std::array<QMatrix<T>, 3> JacobiSVD(QMatrixView<const T> a) {
+	static_assert(std::is_floating_point_v<T>, "JacobiSVD needs a real floating point element type");
+
+	uint64_t n = a.GetN();
+	uint64_t m = a.GetM();
+	if (n < m) {
+		std::array<QMatrix<T>, 3> res = JacobiSVD<T>(a.Transposed());
+		return { std::move(res[2]), std::move(res[1]), std::move(res[0]) };
+	}
+
+	// w holds the columns of a as rows, vt the columns of V
+	std::vector<T> w(SAFE_UINT(m * n));
+	Copy<T>(a.Transposed(), QMatrixView<T>::Of(w.data(), m, n, Layout::RowMajor));
+	std::vector<T> vt(SAFE_UINT(m * m), static_cast<T>(0));
+	for (uint64_t i = 0; i < m; ++i) {
+		vt[i * m + i] = static_cast<T>(1);
+	}
+
+	auto rotate = [](uint64_t len, T* x, T* y, T c, T s) {
+		for (uint64_t k = 0; k < len; ++k) {
+			T t = x[k];
+			x[k] = c * t - s * y[k];
+			y[k] = s * t + c * y[k];
+		}
+	};
+
+	const T tol = std::numeric_limits<T>::epsilon() * std::sqrt(static_cast<T>(n > 0 ? n : 1));
+	for (int sweep = 0; sweep < 64; ++sweep) {
+		bool rotated = false;
+		for (uint64_t i = 0; i < m; ++i) {
+			for (uint64_t j = i + 1; j < m; ++j) {
+				T* wi = &w[i * n];
+				T* wj = &w[j * n];
+				T alpha = _dot<T>(n, wi, wi);
+				T beta = _dot<T>(n, wj, wj);
+				T gamma = _dot<T>(n, wi, wj);
+				if (gamma == static_cast<T>(0) || std::fabs(gamma) <= tol * std::sqrt(alpha * beta)) {
+					continue;
+				}
+				rotated = true;
+				T zeta = (beta - alpha) / (static_cast<T>(2) * gamma);
+				T t = (zeta >= static_cast<T>(0) ? static_cast<T>(1) : static_cast<T>(-1))
+					/ (std::fabs(zeta) + std::sqrt(static_cast<T>(1) + zeta * zeta));
+				T c = static_cast<T>(1) / std::sqrt(static_cast<T>(1) + t * t);
+				T s = c * t;
+				rotate(n, wi, wj, c, s);
+				rotate(m, &vt[i * m], &vt[j * m], c, s);
+			}
+		}
+		if (!rotated) {
+			break;
+		}
+	}
+
+	std::vector<T> sigma(SAFE_UINT(m));
+	for (uint64_t i = 0; i < m; ++i) {
+		sigma[i] = std::sqrt(_dot<T>(n, &w[i * n], &w[i * n]));
+	}
+	std::vector<uint64_t> order(SAFE_UINT(m));
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint64_t x, uint64_t y) { return sigma[x] > sigma[y]; });
+
+	std::vector<T> u(SAFE_UINT(n * m), static_cast<T>(0));
+	std::vector<T> s(SAFE_UINT(m * m), static_cast<T>(0));
+	std::vector<T> v(SAFE_UINT(m * m));
+	for (uint64_t k = 0; k < m; ++k) {
+		uint64_t src = order[k];
+		T sk = sigma[src];
+		s[k * m + k] = sk;
+		if (sk > static_cast<T>(0)) {
+			for (uint64_t i = 0; i < n; ++i) {
+				u[i * m + k] = w[src * n + i] / sk;
+			}
+		}
+		for (uint64_t i = 0; i < m; ++i) {
+			v[i * m + k] = vt[src * m + i];
+		}
+	}
+	return { QMatrix<T>(u.data(), n, m), QMatrix<T>(s.data(), m, m), QMatrix<T>(v.data(), m, m) };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+struct InterpolativeDecomp {
+	std::vector<uint64_t> idx;
+	QMatrix<T> x;
+};
+
+template<typename T>
+struct CURDecomp {
+	std::vector<uint64_t> rows, cols;
+	QMatrix<T> c, u, r;
+};
+
+/*
+	Greedy column-pivoted Gram-Schmidt over the count rows of w (length l each),
+	which it overwrites. Picks up to k rows and returns them with X (k x count) so
+	that every row of w is X^T times the picked rows.
+*/
+template<typename T>
+InterpolativeDecomp<T> _pivoted_id(std::vector<T>& w, uint64_t count, uint64_t l, uint64_t k) {
+	k = k < count ? k : count;
+	k = k < l ? k : l;
+
+	std::vector<T> r(SAFE_UINT(k * count), static_cast<T>(0));
+	std::vector<T> norm2(SAFE_UINT(count));
+	std::vector<char> used(SAFE_UINT(count), 0);
+	std::vector<uint64_t> idx;
+	std::vector<T> q(SAFE_UINT(l));
+
+	ThreadPool& pool = ThreadPool::Shared();
+	uint64_t grain = l >= 4096 ? 1 : 4096 / (l + 1) + 1;
+	pool.ParallelFor(0, count, [&](uint64_t j) {
+		norm2[j] = _dot<T>(l, &w[j * l], &w[j * l]);
+	}, grain);
+
+	for (uint64_t t = 0; t < k; ++t) {
+		uint64_t p = count;
+		for (uint64_t j = 0; j < count; ++j) {
+			if (!used[j] && (p == count || norm2[j] > norm2[p])) {
+				p = j;
+			}
+		}
+		T nrm = p == count ? static_cast<T>(0) : std::sqrt(_dot<T>(l, &w[p * l], &w[p * l]));
+		if (nrm == static_cast<T>(0)) {
+			break;
+		}
+		used[p] = 1;
+		idx.push_back(p);
+		r[t * count + p] = nrm;
+		for (uint64_t i = 0; i < l; ++i) {
+			q[i] = w[p * l + i] / nrm;
+		}
+
+		pool.ParallelFor(0, count, [&](uint64_t j) {
+			if (used[j]) {
+				return;
+			}
+			T* wj = &w[j * l];
+			T c = _dot<T>(l, q.data(), wj);
+			r[t * count + j] = c;
+			_axpy<T>(l, -c, q.data(), wj);
+			norm2[j] = _dot<T>(l, wj, wj);
+		}, grain);
+	}
+	k = idx.size();
+
+	// X = R11^-1 [R11 R12] by back substitution, R11[s][u] = r[s][idx[u]]
+	std::vector<T> x(SAFE_UINT(k * count), static_cast<T>(0));
+	for (uint64_t s = k; s-- > 0;) {
+		T* xs = &x[s * count];
+		for (uint64_t j = 0; j < count; ++j) {
+			xs[j] = r[s * count + j];
+		}
+		for (uint64_t u = s + 1; u < k; ++u) {
+			_axpy<T>(count, -r[s * count + idx[u]], &x[u * count], xs);
+		}
+		T inv = static_cast<T>(1) / r[s * count + idx[s]];
+		for (uint64_t j = 0; j < count; ++j) {
+			xs[j] *= inv;
+		}
+	}
+	for (uint64_t s = 0; s < k; ++s) {
+		for (uint64_t u = 0; u < k; ++u) {
+			x[s * count + idx[u]] = static_cast<T>(s == u ? 1 : 0);
+		}
+	}
+	return { std::move(idx), QMatrix<T>(x.data(), k, count) };
+}
+
+/*
+	rows x l sample (A A^T)^q A Omega of the range of A (of A^T with of_transpose),
+	2q + 1 passes. The intermediate products are orthonormalized, the last one is
+	not, so the sample keeps the weight of each direction for the pivoted IDs.
+*/
+template<typename T>
+std::vector<T> _range_sample(const SketchSource<T>& a, uint64_t l, const SketchOptions& opt, bool of_transpose = false) {
+	uint64_t rows = of_transpose ? a.GetM() : a.GetN();
+	uint64_t other = of_transpose ? a.GetN() : a.GetM();
+
+	SketchMatrix<T> s(other, l, opt);
+	std::vector<T> y(SAFE_UINT(rows * l));
+	QMatrixView<T> yv = QMatrixView<T>::Of(y.data(), rows, l, Layout::RowMajor);
+	if (of_transpose) {
+		a.SketchT(s, yv);
+	}
+	else {
+		a.Sketch(s, yv);
+	}
+
+	std::vector<T> z(SAFE_UINT(other * l));
+	QMatrixView<T> zv = QMatrixView<T>::Of(z.data(), other, l, Layout::RowMajor);
+	for (uint32_t it = 0; it < opt.power_iters; ++it) {
+		QMatrix<T> q = _orth<T>(yv);
+		if (of_transpose) {
+			a.Multiply(q.View(), zv);
+		}
+		else {
+			a.MultiplyT(q.View(), zv);
+		}
+		QMatrix<T> qz = _orth<T>(zv);
+		if (of_transpose) {
+			a.MultiplyT(qz.View(), yv);
+		}
+		else {
+			a.Multiply(qz.View(), yv);
+		}
+	}
+	return y;
+}
+
+template<typename T>
+uint64_t _sketch_width(const SketchSource<T>& a, uint64_t rank, const SketchOptions& opt) {
+	uint64_t k = a.GetN() < a.GetM() ? a.GetN() : a.GetM();
+	uint64_t l = rank + opt.oversample;
+	return l < k ? l : k;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// {U (n x rank), S (rank x rank diagonal), V (m x rank)} with A ~ U S V^T
+template<typename T>
+std::array<QMatrix<T>, 3> RandomizedSVD(const SketchSource<T>& a, uint64_t rank, const SketchOptions& opt = SketchOptions()) {
+	uint64_t n = a.GetN();
+	uint64_t m = a.GetM();
+	uint64_t l = _sketch_width(a, rank, opt);
+	rank = rank < l ? rank : l;
+
+	std::vector<T> y = _range_sample(a, l, opt);
+	QMatrix<T> q = _orth<T>(QMatrixView<const T>::Of(y.data(), n, l, Layout::RowMajor));
+
+	// B = Q^T A, kept as B^T = A^T Q = Q2 R so B = R^T Q2^T
+	std::vector<T> bt(SAFE_UINT(m * l));
+	QMatrixView<T> btv = QMatrixView<T>::Of(bt.data(), m, l, Layout::RowMajor);
+	a.MultiplyT(q.View(), btv);
+	std::vector<T> r;
+	QMatrix<T> q2 = _orth<T>(btv, &r);
+
+	// R^T = Ur S Vr^T, so A ~ (Q Ur) S (Q2 Vr)^T
+	std::array<QMatrix<T>, 3> small = JacobiSVD<T>(QMatrixView<const T>::Of(r.data(), l, l, Layout::RowMajor).Transposed());
+
+	std::vector<T> u(SAFE_UINT(n * rank));
+	std::vector<T> v(SAFE_UINT(m * rank));
+	Gemm<T>(q.View(), small[0].View().Sub(0, 0, l, rank), QMatrixView<T>::Of(u.data(), n, rank, Layout::RowMajor));
+	Gemm<T>(q2.View(), small[2].View().Sub(0, 0, l, rank), QMatrixView<T>::Of(v.data(), m, rank, Layout::RowMajor));
+	return { QMatrix<T>(u.data(), n, rank), QMatrix<T>(small[1].View().Sub(0, 0, rank, rank)), QMatrix<T>(v.data(), m, rank) };
+}
+
+// A ~ A[:, idx] X, X is k x m
+template<typename T>
+InterpolativeDecomp<T> ColumnID(const SketchSource<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	uint64_t l = _sketch_width(a, k, opt);
+	std::vector<T> w = _range_sample(a, l, opt, true);
+	return _pivoted_id(w, a.GetM(), l, k);
+}
+
+// A ~ X A[idx, :], X is n x k
+template<typename T>
+InterpolativeDecomp<T> RowID(const SketchSource<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	uint64_t l = _sketch_width(a, k, opt);
+	std::vector<T> w = _range_sample(a, l, opt);
+	InterpolativeDecomp<T> id = _pivoted_id(w, a.GetN(), l, k);
+	return { std::move(id.idx), id.x.Transpose() };
+}
+
+// A ~ C U R with C = A[:, cols], R = A[rows, :] and U = X R^+ from the column ID X
+template<typename T>
+CURDecomp<T> CUR(const SketchSource<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	InterpolativeDecomp<T> col = ColumnID(a, k, opt);
+	k = col.idx.size();
+	QMatrix<T> c = a.Cols(col.idx);
+
+	// rows where C has the most independent information
+	uint64_t n = a.GetN();
+	std::vector<T> w(c.View().Data(), c.View().Data() + n * k);
+	std::vector<uint64_t> rows = _pivoted_id(w, n, k, k).idx;
+	QMatrix<T> r = a.Rows(rows);
+	uint64_t kr = rows.size();
+
+	// R^T = Q1 R1, so R^+ = Q1 R1^-T and U R1^T = X Q1
+	std::vector<T> r1;
+	QMatrix<T> q1 = _orth<T>(r.View().Transposed(), &r1);
+	std::vector<T> u(SAFE_UINT(k * kr));
+	Gemm<T>(col.x.View(), q1.View(), QMatrixView<T>::Of(u.data(), k, kr, Layout::RowMajor));
+	for (uint64_t i = 0; i < k; ++i) {
+		T* ui = &u[i * kr];
+		for (uint64_t s = kr; s-- > 0;) {
+			T d = r1[s * kr + s];
+			if (d == static_cast<T>(0)) {
+				ui[s] = static_cast<T>(0);
+				continue;
+			}
+			T acc = ui[s];
+			for (uint64_t t = s + 1; t < kr; ++t) {
+				acc -= r1[s * kr + t] * ui[t];
+			}
+			ui[s] = acc / d;
+		}
+	}
+	return { std::move(rows), std::move(col.idx), std::move(c), QMatrix<T>(u.data(), k, kr), std::move(r) };
+}
+
+/*
+	{U (n x rank), L (rank x rank diagonal)} with A ~ U L U^T, for symmetric positive
+	semidefinite A. Stable form of Tropp et al.: a small shift nu keeps the core
+	Omega^T A Omega factorizable and is taken off the eigenvalues again.
+*/
+template<typename T>
+std::array<QMatrix<T>, 2> Nystrom(const SketchSource<T>& a, uint64_t rank, const SketchOptions& opt = SketchOptions()) {
+	uint64_t n = a.GetN();
+	uint64_t l = _sketch_width(a, rank, opt);
+	rank = rank < l ? rank : l;
+	if (a.GetN() != a.GetM()) {
+		merror("Nystrom approximation needs a square symmetric matrix!", E_MAT_INVALID_DIMENSION);
+		std::vector<T> _tmp_zero(SAFE_UINT(n * rank + rank * rank), static_cast<T>(0));
+		return { QMatrix<T>(_tmp_zero.data(), n, rank), QMatrix<T>(_tmp_zero.data(), rank, rank) };
+	}
+
+	std::vector<T> y(SAFE_UINT(n * l));
+	QMatrixView<T> yv = QMatrixView<T>::Of(y.data(), n, l, Layout::RowMajor);
+	QMatrix<T> omega = _orth<T>(SketchMatrix<T>(n, l, opt).ToQMatrix().View());
+	for (uint32_t it = 0; it < opt.power_iters; ++it) {
+		a.Multiply(omega.View(), yv);
+		omega = _orth<T>(yv);
+	}
+	a.Multiply(omega.View(), yv);
+
+	T nu = std::sqrt(static_cast<T>(n)) * std::numeric_limits<T>::epsilon() * std::sqrt(_dot<T>(n * l, y.data(), y.data()));
+	_axpy<T>(n * l, nu, omega.View().Data(), y.data());
+
+	// core = Omega^T Y_nu = C C^T
+	std::vector<T> core(SAFE_UINT(l * l));
+	Gemm<T>(omega.View().Transposed(), yv, QMatrixView<T>::Of(core.data(), l, l, Layout::RowMajor));
+	std::vector<T> ch(SAFE_UINT(l * l), static_cast<T>(0));
+	bool semidefinite = true;
+	for (uint64_t j = 0; j < l; ++j) {
+		T d = core[j * l + j];
+		for (uint64_t t = 0; t < j; ++t) {
+			d -= ch[j * l + t] * ch[j * l + t];
+		}
+		if (d <= static_cast<T>(0)) {
+			semidefinite = semidefinite && d > -nu * static_cast<T>(l);
+			continue;
+		}
+		T cjj = std::sqrt(d);
+		ch[j * l + j] = cjj;
+		for (uint64_t i = j + 1; i < l; ++i) {
+			T x = (core[i * l + j] + core[j * l + i]) / static_cast<T>(2);
+			for (uint64_t t = 0; t < j; ++t) {
+				x -= ch[i * l + t] * ch[j * l + t];
+			}
+			ch[i * l + j] = x / cjj;
+		}
+	}
+	if (!semidefinite) {
+		merror("Nystrom approximation of a matrix that is not positive semidefinite!", WARN);
+	}
+
+	// B = Y_nu C^-T, row by row: C b^T = y^T
+	ThreadPool::Shared().ParallelFor(0, n, [&](uint64_t i) {
+		T* b = &y[i * l];
+		for (uint64_t j = 0; j < l; ++j) {
+			T d = ch[j * l + j];
+			if (d == static_cast<T>(0)) {
+				b[j] = static_cast<T>(0);
+				continue;
+			}
+			T acc = b[j];
+			for (uint64_t t = 0; t < j; ++t) {
+				acc -= ch[j * l + t] * b[t];
+			}
+			b[j] = acc / d;
+		}
+	}, 256);
+
+	// B = Qb Rb, Rb = Ur S Vr^T, so A ~ (Qb Ur) (S^2 - nu) (Qb Ur)^T
+	std::vector<T> rb;
+	QMatrix<T> qb = _orth<T>(yv, &rb);
+	std::array<QMatrix<T>, 3> small = JacobiSVD<T>(QMatrixView<const T>::Of(rb.data(), l, l, Layout::RowMajor));
+
+	std::vector<T> u(SAFE_UINT(n * rank));
+	Gemm<T>(qb.View(), small[0].View().Sub(0, 0, l, rank), QMatrixView<T>::Of(u.data(), n, rank, Layout::RowMajor));
+	std::vector<T> lam(SAFE_UINT(rank * rank), static_cast<T>(0));
+	for (uint64_t k = 0; k < rank; ++k) {
+		T s = small[1].View()(k, k);
+		T e = s * s - nu;
+		lam[k * rank + k] = e > static_cast<T>(0) ? e : static_cast<T>(0);
+	}
+	return { QMatrix<T>(u.data(), n, rank), QMatrix<T>(lam.data(), rank, rank) };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+std::array<QMatrix<T>, 3> RandomizedSVD(const QMatrix<T>& a, uint64_t rank, const SketchOptions& opt = SketchOptions()) {
+	return RandomizedSVD(SketchSource<T>(a), rank, opt);
+}
+
+template<typename T>
+std::array<QMatrix<T>, 3> RandomizedSVD(TiledQMatrix<T>& a, uint64_t rank, const SketchOptions& opt = SketchOptions()) {
+	return RandomizedSVD(SketchSource<T>(a), rank, opt);
+}
+
+template<typename T>
+InterpolativeDecomp<T> ColumnID(const QMatrix<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	return ColumnID(SketchSource<T>(a), k, opt);
+}
+
+template<typename T>
+InterpolativeDecomp<T> ColumnID(TiledQMatrix<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	return ColumnID(SketchSource<T>(a), k, opt);
+}
+
+template<typename T>
+InterpolativeDecomp<T> RowID(const QMatrix<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	return RowID(SketchSource<T>(a), k, opt);
+}
+
+template<typename T>
+InterpolativeDecomp<T> RowID(TiledQMatrix<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	return RowID(SketchSource<T>(a), k, opt);
+}
+
+template<typename T>
+CURDecomp<T> CUR(const QMatrix<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	return CUR(SketchSource<T>(a), k, opt);
+}
+
+template<typename T>
+CURDecomp<T> CUR(TiledQMatrix<T>& a, uint64_t k, const SketchOptions& opt = SketchOptions()) {
+	return CUR(SketchSource<T>(a), k, opt);
+}
+
+template<typename T>
+std::array<QMatrix<T>, 2> Nystrom(const QMatrix<T>& a, uint64_t rank, const SketchOptions& opt = SketchOptions()) {
+	return Nystrom(SketchSource<T>(a), rank, opt);
+}
+
+template<typename T>
+std::array<QMatrix<T>, 2> Nystrom(TiledQMatrix<T>& a, uint64_t rank, const SketchOptions& opt = SketchOptions()) {
+	return Nystrom(SketchSource<T>(a), rank, opt);
+}
+
+#endif
@@ -2,6 +2,8 @@
 #define _MATRIX_H
 
 #include <cstdlib>
+#include <cstring>
+#include <stdint.h>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -9,6 +11,7 @@
 #include <ostream>
 
 #include "MatrixError.hpp"
+#include "LowPrecision.hpp"
 
 #define STACK_TRESHOLD 256
 #define FLAG
@@ -146,26 +149,27 @@ public:
 
 			for (size_t i = 0; i < n; ++i) {
 				for (size_t j = 0; j < m; ++j) {
-					T part_sum = 0;
-					for (size_t k = 0; k = m; ++k) {
+					_acc_type_t<T> part_sum = 0;
+					for (size_t k = 0; k < m; ++k) {
 						DEREF_TRY(part_sum += heap_data[SAFE_UINT(i * m + k)] * other.heap_data[SAFE_UINT(k * m + j)]);
 					}
-					G_TRY(_tmp_heap_data[SAFE_UINT(i * m + j)] = part_sum);
+					G_TRY(_tmp_heap_data[SAFE_UINT(i * m + j)] = _narrow<T>(part_sum));
 				}
 			}
 
 			memcpy(heap_data, _tmp_heap_data, SAFE_UINT(n * m * sizeof(T)));
+			delete[] _tmp_heap_data;
 		}
 		else if (!is_heap && !other.is_heap) {
 			T _tmp_stack_data[STACK_TRESHOLD];
 
 			for (size_t i = 0; i < n; ++i) {
 				for (size_t j = 0; j < m; ++j) {
-					T part_sum = 0;
+					_acc_type_t<T> part_sum = 0;
 					for (size_t k = 0; k < m; ++k) {
 						DEREF_TRY(part_sum += stack_data[SAFE_UINT(i * m + k)] * other.stack_data[SAFE_UINT(k * m + j)]);
 					}
-					G_TRY(_tmp_stack_data[SAFE_UINT(i * m + j)] = part_sum);
+					G_TRY(_tmp_stack_data[SAFE_UINT(i * m + j)] = _narrow<T>(part_sum));
 				}
 			}
 
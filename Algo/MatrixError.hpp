@@ -2,7 +2,9 @@
 #define _MATRIX_ERROR_H
 
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
+#include <stdint.h>
 
 #define E_MAT_INVALID_DIMENSION 91
 #define E_VEC_INVALID_DIMENSION 92
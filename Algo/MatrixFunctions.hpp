@@ -0,0 +1,613 @@
+#ifndef _MATRIX_FUNCTIONS_H
+#define _MATRIX_FUNCTIONS_H
+
+#include "LowRank.hpp"
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include "ThreadPool.hpp"
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <initializer_list>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+	Inverse, pseudo-inverse and functions of square matrices.
+
+	  Inverse        blocked right-looking LU with partial pivoting, then A X = I by
+	                 blocked triangular solves over column panels of X
+	  PseudoInverse  V S^+ U^T from the one-sided Jacobi SVD, singular values up to
+	                 rcond * s_max count as zero
+	  Expm           scaling and squaring with the [m/m] Pade approximant, m picked
+	                 from 3, 5, 7, 9, 13 (3, 5, 7 for float) by the 1-norm (Higham 2005)
+	  Sqrtm          product form of the Denman-Beavers iteration with determinant scaling
+	  Logm           inverse scaling and squaring: square roots until ||A - I||_1 <= 1/4,
+	                 then log(I + X) by 8 point Gauss-Legendre, which is the [8/8] Pade
+	                 approximant in partial fractions
+
+	Sqrtm and Logm need A without eigenvalues on the closed negative real axis.
+
+	The work is GEMM: the LU trailing update, the off-diagonal blocks of the
+	triangular solves and the Pade polynomials. Products are split into row panels
+	across the shared pool once they reach MATFUN_PAR_FLOPS. Smaller ones, like a
+	200 x 200 Expm, stay on the calling thread, so many of them can run side by side
+	(the vector overload of Expm).
+*/
+
+#define MATFUN_BLOCK 64
+#define MATFUN_PAR_FLOPS (1ull << 24)
+
+template<typename T> struct _real_of { using type = T; };
+template<typename T> struct _real_of<std::complex<T>> { using type = T; };
+
+// c = a b, or c -= a b with subtract
+template<typename T>
+void _gemm_rows(QMatrixView<const T> a, QMatrixView<const T> b, QMatrixView<T> c, bool subtract = false) {
+	uint64_t n = c.GetN();
+	uint64_t m = c.GetM();
+	uint64_t p = a.GetM();
+	if (p == 0) {
+		if (!subtract) {
+			for (uint64_t i = 0; i < n; ++i) {
+				for (uint64_t j = 0; j < m; ++j) {
+					c(i, j) = static_cast<T>(0);
+				}
+			}
+		}
+		return;
+	}
+
+	auto panel = [&](uint64_t r0, uint64_t rows) {
+		QMatrixView<const T> ap = a.Sub(r0, 0, rows, p);
+		QMatrixView<T> cp = c.Sub(r0, 0, rows, m);
+		if (!subtract) {
+			Gemm<T>(ap, b, cp);
+			return;
+		}
+		static thread_local std::vector<T> _tmp;
+		_tmp.resize(SAFE_UINT(rows * m));
+		QMatrixView<T> tv = QMatrixView<T>::Of(_tmp.data(), rows, m, Layout::RowMajor);
+		Gemm<T>(ap, b, tv);
+		for (uint64_t i = 0; i < rows; ++i) {
+			_axpy<T>(m, static_cast<T>(-1), &tv(i, 0), &cp(i, 0));
+		}
+	};
+
+	if (n * m * p < MATFUN_PAR_FLOPS || n <= MATFUN_BLOCK) {
+		panel(0, n);
+		return;
+	}
+	ThreadPool::Shared().ParallelFor(0, (n + MATFUN_BLOCK - 1) / MATFUN_BLOCK, [&](uint64_t k) {
+		uint64_t r0 = k * MATFUN_BLOCK;
+		panel(r0, n - r0 < MATFUN_BLOCK ? n - r0 : MATFUN_BLOCK);
+	});
+}
+
+// b = L^-1 b, L unit lower triangular
+template<typename T>
+void _trsm_lower_blocked(QMatrixView<const T> l, QMatrixView<T> b) {
+	uint64_t n = l.GetN();
+	uint64_t r = b.GetM();
+	for (uint64_t i0 = 0; i0 < n; i0 += MATFUN_BLOCK) {
+		uint64_t ib = n - i0 < MATFUN_BLOCK ? n - i0 : MATFUN_BLOCK;
+		if (i0 > 0) {
+			_gemm_rows<T>(l.Sub(i0, 0, ib, i0), b.Sub(0, 0, i0, r), b.Sub(i0, 0, ib, r), true);
+		}
+		for (uint64_t i = i0; i < i0 + ib; ++i) {
+			for (uint64_t k = i0; k < i; ++k) {
+				_axpy<T>(r, -l(i, k), &b(k, 0), &b(i, 0));
+			}
+		}
+	}
+}
+
+// b = U^-1 b, U upper triangular
+template<typename T>
+void _trsm_upper_blocked(QMatrixView<const T> u, QMatrixView<T> b) {
+	uint64_t n = u.GetN();
+	uint64_t r = b.GetM();
+	for (uint64_t blk = (n + MATFUN_BLOCK - 1) / MATFUN_BLOCK; blk-- > 0;) {
+		uint64_t i0 = blk * MATFUN_BLOCK;
+		uint64_t i1 = n - i0 < MATFUN_BLOCK ? n : i0 + MATFUN_BLOCK;
+		if (i1 < n) {
+			_gemm_rows<T>(u.Sub(i0, i1, i1 - i0, n - i1), b.Sub(i1, 0, n - i1, r), b.Sub(i0, 0, i1 - i0, r), true);
+		}
+		for (uint64_t i = i1; i-- > i0;) {
+			for (uint64_t k = i + 1; k < i1; ++k) {
+				_axpy<T>(r, -u(i, k), &b(k, 0), &b(i, 0));
+			}
+			T inv = static_cast<T>(1) / u(i, i);
+			for (uint64_t j = 0; j < r; ++j) {
+				b(i, j) *= inv;
+			}
+		}
+	}
+}
+
+/*
+	P A = L U in place with the storage and pivots of _lu_pivot_in_place, factored
+	MATFUN_BLOCK columns at a time: the panel unblocked, then U12 = L11^-1 A12 and
+	the GEMM update A22 -= L21 U12. a has to be row-contiguous. False when singular.
+*/
+template<typename T>
+bool _lu_blocked(QMatrixView<T> a, uint32_t* piv) {
+	uint64_t n = a.GetN();
+	bool regular = true;
+	for (uint64_t k0 = 0; k0 < n; k0 += MATFUN_BLOCK) {
+		uint64_t kb = n - k0 < MATFUN_BLOCK ? n - k0 : MATFUN_BLOCK;
+		uint64_t k1 = k0 + kb;
+		for (uint64_t k = k0; k < k1; ++k) {
+			uint64_t p = k;
+			for (uint64_t i = k + 1; i < n; ++i) {
+				if (std::abs(a(i, k)) > std::abs(a(p, k))) {
+					p = i;
+				}
+			}
+			piv[k] = static_cast<uint32_t>(p);
+			if (p != k) {
+				std::swap_ranges(&a(k, 0), &a(k, 0) + n, &a(p, 0));
+			}
+			T pv = a(k, k);
+			if (pv == static_cast<T>(0)) {
+				regular = false;
+				continue;
+			}
+			for (uint64_t i = k + 1; i < n; ++i) {
+				T lik = a(i, k) / pv;
+				a(i, k) = lik;
+				_axpy<T>(k1 - k - 1, -lik, &a(k, k + 1), &a(i, k + 1));
+			}
+		}
+		if (k1 < n) {
+			_trsm_lower_blocked<T>(a.Sub(k0, k0, kb, kb), a.Sub(k0, k1, kb, n - k1));
+			_gemm_rows<T>(a.Sub(k1, k0, n - k1, kb), a.Sub(k0, k1, kb, n - k1), a.Sub(k1, k1, n - k1, n - k1), true);
+		}
+	}
+	return regular;
+}
+
+// b = A^-1 b from the output of _lu_blocked, wide right-hand sides in parallel column panels
+template<typename T>
+void _lu_solve_many(QMatrixView<const T> lu, const uint32_t* piv, QMatrixView<T> b) {
+	uint64_t n = lu.GetN();
+	uint64_t r = b.GetM();
+	for (uint64_t k = 0; k < n; ++k) {
+		if (piv[k] != k) {
+			std::swap_ranges(&b(k, 0), &b(k, 0) + r, &b(piv[k], 0));
+		}
+	}
+	auto solve = [&](uint64_t c0, uint64_t cb) {
+		_trsm_lower_blocked<T>(lu, b.Sub(0, c0, n, cb));
+		_trsm_upper_blocked<T>(lu, b.Sub(0, c0, n, cb));
+	};
+	if (n * n * r < MATFUN_PAR_FLOPS || r <= MATFUN_BLOCK) {
+		solve(0, r);
+		return;
+	}
+	ThreadPool::Shared().ParallelFor(0, (r + MATFUN_BLOCK - 1) / MATFUN_BLOCK, [&](uint64_t k) {
+		uint64_t c0 = k * MATFUN_BLOCK;
+		solve(c0, r - c0 < MATFUN_BLOCK ? r - c0 : MATFUN_BLOCK);
+	});
+}
+
+template<typename T>
+double _norm1(QMatrixView<const T> a) {
+	std::vector<double> sums(SAFE_UINT(a.GetM()), 0.0);
+	for (uint64_t i = 0; i < a.GetN(); ++i) {
+		for (uint64_t j = 0; j < a.GetM(); ++j) {
+			sums[j] += static_cast<double>(std::abs(a(i, j)));
+		}
+	}
+	double res = 0.0;
+	for (double s : sums) {
+		res = s > res ? s : res;
+	}
+	return res;
+}
+
+// out = sum of c[k] * mats[k] + ci * I over n x n row-major buffers
+template<typename T>
+void _lincomb(uint64_t n, T* out, std::initializer_list<std::pair<T, const T*>> terms, T ci) {
+	for (uint64_t i = 0; i < n * n; ++i) {
+		out[i] = static_cast<T>(0);
+	}
+	for (const std::pair<T, const T*>& t : terms) {
+		_axpy<T>(n * n, t.first, t.second, out);
+	}
+	for (uint64_t i = 0; i < n; ++i) {
+		out[i * n + i] += ci;
+	}
+}
+
+template<typename T>
+void _set_identity(uint64_t n, T* out) {
+	for (uint64_t i = 0; i < n * n; ++i) {
+		out[i] = static_cast<T>(0);
+	}
+	for (uint64_t i = 0; i < n; ++i) {
+		out[i * n + i] = static_cast<T>(1);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+QMatrix<T> Inverse(const QMatrix<T>& a) {
+	static_assert(std::is_floating_point_v<T> || _is_complex<T>::value,
+		"Inverse needs a floating point or complex element type");
+	if (!a.IsSquare()) {
+		merror("Cannot invert non-square matrix!", E_MAT_INVALID_DIMENSION);
+		return a;
+	}
+	uint64_t n = a.GetN();
+	QMatrix<T> lu = a;
+	std::vector<uint32_t> piv(SAFE_UINT(n));
+	if (!_lu_blocked<T>(lu.View(), piv.data())) {
+		merror("Cannot invert singular matrix!", SEVERE);
+		return a;
+	}
+	std::vector<T> x(SAFE_UINT(n * n));
+	_set_identity<T>(n, x.data());
+	_lu_solve_many<T>(lu.View(), piv.data(), QMatrixView<T>::Of(x.data(), n, n, Layout::RowMajor));
+	return QMatrix<T>(x.data(), n, n);
+}
+
+// Moore-Penrose pseudo-inverse (m x n for an n x m a), rcond < 0 picks max(n, m) * eps
+template<typename T>
+QMatrix<T> PseudoInverse(const QMatrix<T>& a, double rcond = -1.0) {
+	static_assert(std::is_floating_point_v<T>, "PseudoInverse needs a real floating point element type");
+	uint64_t n = a.GetN();
+	uint64_t m = a.GetM();
+	std::vector<T> res(SAFE_UINT(m * n), static_cast<T>(0));
+	if (n == 0 || m == 0) {
+		return QMatrix<T>(res.data(), m, n);
+	}
+
+	std::array<QMatrix<T>, 3> svd = JacobiSVD<T>(a.View());
+	uint64_t k = svd[1].GetN();
+	double smax = static_cast<double>(svd[1].GetItem(0, 0));
+	double cut = (rcond < 0.0 ? static_cast<double>(n > m ? n : m) * std::numeric_limits<T>::epsilon() : rcond) * smax;
+
+	// V S^+ (m x k) times U^T (k x n)
+	QMatrixView<const T> v = svd[2].View();
+	std::vector<T> vs(SAFE_UINT(m * k));
+	for (uint64_t j = 0; j < k; ++j) {
+		double s = static_cast<double>(svd[1].GetItem(j, j));
+		T inv = s > cut ? static_cast<T>(1.0 / s) : static_cast<T>(0);
+		for (uint64_t i = 0; i < m; ++i) {
+			vs[i * k + j] = v(i, j) * inv;
+		}
+	}
+	QMatrix<T> ut = svd[0].Transpose();
+	_gemm_rows<T>(QMatrixView<const T>::Of(vs.data(), m, k, Layout::RowMajor), ut.View(),
+		QMatrixView<T>::Of(res.data(), m, n, Layout::RowMajor));
+	return QMatrix<T>(res.data(), m, n);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// [m/m] Pade coefficients of exp, b[j] for j = 0..m
+inline const double* _pade_exp_coefs(uint32_t m) {
+	static const double b3[] = { 120.0, 60.0, 12.0, 1.0 };
+	static const double b5[] = { 30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0 };
+	static const double b7[] = { 17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0, 1512.0, 56.0, 1.0 };
+	static const double b9[] = { 17643225600.0, 8821612800.0, 2075673600.0, 302702400.0, 30270240.0,
+		2162160.0, 110880.0, 3960.0, 90.0, 1.0 };
+	static const double b13[] = { 64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+		1187353796428800.0, 129060195264000.0, 10559470521600.0, 670442572800.0, 33522128640.0,
+		1323241920.0, 40840800.0, 960960.0, 16380.0, 182.0, 1.0 };
+	switch (m) {
+	case 3: return b3;
+	case 5: return b5;
+	case 7: return b7;
+	case 9: return b9;
+	default: return b13;
+	}
+}
+
+/*
+	exp(A) of one matrix. Products of a single 200 x 200 matrix stay below
+	MATFUN_PAR_FLOPS, use the vector overload to spread many over the pool.
+*/
+template<typename T>
+QMatrix<T> Expm(const QMatrix<T>& a) {
+	static_assert(std::is_floating_point_v<T> || _is_complex<T>::value,
+		"Expm needs a floating point or complex element type");
+	using R = typename _real_of<T>::type;
+	if (!a.IsSquare()) {
+		merror("Cannot take the exponential of a non-square matrix!", E_MAT_INVALID_DIMENSION);
+		return a;
+	}
+	uint64_t n = a.GetN();
+	if (n == 0) {
+		return a;
+	}
+
+	// largest 1-norm each degree handles to unit roundoff, the last one is scaled down to
+	static const uint32_t deg_d[] = { 3, 5, 7, 9, 13 };
+	static const double theta_d[] = { 1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1,
+		2.097847961257068e0, 5.371920351148152e0 };
+	static const uint32_t deg_s[] = { 3, 5, 7 };
+	static const double theta_s[] = { 4.258730016922831e-1, 1.880152677804762e0, 3.925724783138660e0 };
+	const bool single = std::is_same_v<R, float>;
+	const uint32_t* deg = single ? deg_s : deg_d;
+	const double* theta = single ? theta_s : theta_d;
+	const uint32_t count = single ? 3 : 5;
+
+	uint64_t nn = n * n;
+	std::vector<T> x(SAFE_UINT(nn));
+	Copy<T>(a.View(), QMatrixView<T>::Of(x.data(), n, n, Layout::RowMajor));
+
+	double nrm = _norm1<T>(a.View());
+	uint32_t m = deg[count - 1];
+	int s = 0;
+	for (uint32_t k = 0; k < count; ++k) {
+		if (nrm <= theta[k]) {
+			m = deg[k];
+			break;
+		}
+	}
+	if (nrm > theta[count - 1]) {
+		s = static_cast<int>(std::ceil(std::log2(nrm / theta[count - 1])));
+		T scale = static_cast<T>(std::ldexp(1.0, -s));
+		for (T& e : x) {
+			e *= scale;
+		}
+	}
+
+	const double* b = _pade_exp_coefs(m);
+	auto c = [&](uint32_t j) { return static_cast<T>(b[j]); };
+	auto view = [n](std::vector<T>& buf) { return QMatrixView<T>::Of(buf.data(), n, n, Layout::RowMajor); };
+	auto cview = [n](const std::vector<T>& buf) { return QMatrixView<const T>::Of(buf.data(), n, n, Layout::RowMajor); };
+
+	// pw[k] = A^(2k + 2)
+	uint32_t powers = m == 13 ? 3 : (m - 1) / 2;
+	std::vector<std::vector<T>> pw(powers, std::vector<T>(SAFE_UINT(nn)));
+	_gemm_rows<T>(cview(x), cview(x), view(pw[0]));
+	for (uint32_t k = 1; k < powers; ++k) {
+		_gemm_rows<T>(cview(pw[k - 1]), cview(pw[0]), view(pw[k]));
+	}
+
+	std::vector<T> u(SAFE_UINT(nn)), v(SAFE_UINT(nn)), w(SAFE_UINT(nn));
+	if (m == 13) {
+		const T* a2 = pw[0].data();
+		const T* a4 = pw[1].data();
+		const T* a6 = pw[2].data();
+		// u = A (A6 (b13 A6 + b11 A4 + b9 A2) + b7 A6 + b5 A4 + b3 A2 + b1 I)
+		_lincomb<T>(n, w.data(), { { c(13), a6 }, { c(11), a4 }, { c(9), a2 } }, static_cast<T>(0));
+		_gemm_rows<T>(cview(pw[2]), cview(w), view(v));
+		_lincomb<T>(n, w.data(), { { static_cast<T>(1), v.data() }, { c(7), a6 }, { c(5), a4 }, { c(3), a2 } }, c(1));
+		_gemm_rows<T>(cview(x), cview(w), view(u));
+		// v = A6 (b12 A6 + b10 A4 + b8 A2) + b6 A6 + b4 A4 + b2 A2 + b0 I
+		_lincomb<T>(n, w.data(), { { c(12), a6 }, { c(10), a4 }, { c(8), a2 } }, static_cast<T>(0));
+		_gemm_rows<T>(cview(pw[2]), cview(w), view(v));
+		_lincomb<T>(n, w.data(), { { static_cast<T>(1), v.data() }, { c(6), a6 }, { c(4), a4 }, { c(2), a2 } }, c(0));
+		v.swap(w);
+	}
+	else {
+		// u = A sum b[2k + 1] A^2k, v = sum b[2k] A^2k
+		_set_identity<T>(n, w.data());
+		for (T& e : w) {
+			e *= c(1);
+		}
+		_set_identity<T>(n, v.data());
+		for (T& e : v) {
+			e *= c(0);
+		}
+		for (uint32_t k = 0; k < powers; ++k) {
+			_axpy<T>(nn, c(2 * k + 3), pw[k].data(), w.data());
+			_axpy<T>(nn, c(2 * k + 2), pw[k].data(), v.data());
+		}
+		_gemm_rows<T>(cview(x), cview(w), view(u));
+	}
+
+	// (V - U) R = V + U
+	for (uint64_t i = 0; i < nn; ++i) {
+		T ui = u[i];
+		u[i] = v[i] - ui;
+		v[i] += ui;
+	}
+	std::vector<uint32_t> piv(SAFE_UINT(n));
+	if (!_lu_blocked<T>(view(u), piv.data())) {
+		merror("Singular denominator in the Pade approximant of exp!", SEVERE);
+	}
+	_lu_solve_many<T>(cview(u), piv.data(), view(v));
+
+	for (int k = 0; k < s; ++k) {
+		_gemm_rows<T>(cview(v), cview(v), view(w));
+		v.swap(w);
+	}
+	return QMatrix<T>(v.data(), n, n);
+}
+
+// exp of every matrix, one matrix per pool task
+template<typename T>
+std::vector<QMatrix<T>> Expm(const std::vector<QMatrix<T>>& as) {
+	std::vector<QMatrix<T>> res;
+	res.reserve(as.size());
+	for (const QMatrix<T>& a : as) {
+		res.emplace_back(a.View());
+	}
+	ThreadPool::Shared().ParallelFor(0, as.size(), [&](uint64_t k) {
+		res[k] = Expm(as[k]);
+	});
+	return res;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Principal square root by the product form of Denman-Beavers (Higham, Functions
+	of Matrices, 6.29): M_0 = X_0 = A,
+	  X_k+1 = mu X_k (I + mu^-2 M_k^-1) / 2
+	  M_k+1 = (I + (mu^2 M_k + mu^-2 M_k^-1) / 2) / 2,  mu = |det M_k|^(-1/2n)
+	until M = I, where X = A^1/2. One LU and inverse plus one product per step.
+*/
+template<typename T>
+QMatrix<T> Sqrtm(const QMatrix<T>& a) {
+	static_assert(std::is_floating_point_v<T> || _is_complex<T>::value,
+		"Sqrtm needs a floating point or complex element type");
+	using R = typename _real_of<T>::type;
+	if (!a.IsSquare()) {
+		merror("Cannot take the square root of a non-square matrix!", E_MAT_INVALID_DIMENSION);
+		return a;
+	}
+	uint64_t n = a.GetN();
+	if (n == 0) {
+		return a;
+	}
+	uint64_t nn = n * n;
+	auto view = [n](std::vector<T>& buf) { return QMatrixView<T>::Of(buf.data(), n, n, Layout::RowMajor); };
+	auto cview = [n](const std::vector<T>& buf) { return QMatrixView<const T>::Of(buf.data(), n, n, Layout::RowMajor); };
+
+	std::vector<T> mk(SAFE_UINT(nn)), xk(SAFE_UINT(nn)), lu(SAFE_UINT(nn)), inv(SAFE_UINT(nn)), tmp(SAFE_UINT(nn));
+	Copy<T>(a.View(), view(mk));
+	xk = mk;
+	std::vector<uint32_t> piv(SAFE_UINT(n));
+
+	const double tol = static_cast<double>(n) * std::numeric_limits<R>::epsilon();
+	double prev = std::numeric_limits<double>::infinity();
+	bool converged = false;
+	for (int it = 0; it < 64; ++it) {
+		lu = mk;
+		if (!_lu_blocked<T>(view(lu), piv.data())) {
+			merror("Singular iterate in the matrix square root!", SEVERE);
+			return a;
+		}
+		double logdet = 0.0;
+		for (uint64_t i = 0; i < n; ++i) {
+			logdet += std::log(static_cast<double>(std::abs(lu[i * n + i])));
+		}
+		double mu = std::exp(-logdet / (2.0 * static_cast<double>(n)));
+		T mu2 = static_cast<T>(mu * mu);
+		T imu2 = static_cast<T>(1.0 / (mu * mu));
+
+		_set_identity<T>(n, inv.data());
+		_lu_solve_many<T>(cview(lu), piv.data(), view(inv));
+
+		// X = mu / 2 X (I + mu^-2 M^-1)
+		_lincomb<T>(n, tmp.data(), { { imu2, inv.data() } }, static_cast<T>(1));
+		_gemm_rows<T>(cview(xk), cview(tmp), view(lu));
+		T half_mu = static_cast<T>(mu / 2.0);
+		for (uint64_t i = 0; i < nn; ++i) {
+			xk[i] = half_mu * lu[i];
+		}
+
+		// M = I / 2 + (mu^2 M + mu^-2 M^-1) / 4
+		T quarter = static_cast<T>(0.25);
+		for (uint64_t i = 0; i < nn; ++i) {
+			mk[i] = quarter * (mu2 * mk[i] + imu2 * inv[i]);
+		}
+		for (uint64_t i = 0; i < n; ++i) {
+			mk[i * n + i] += static_cast<T>(0.5);
+		}
+
+		for (uint64_t i = 0; i < n; ++i) {
+			mk[i * n + i] -= static_cast<T>(1);
+		}
+		double err = _norm1<T>(cview(mk));
+		for (uint64_t i = 0; i < n; ++i) {
+			mk[i * n + i] += static_cast<T>(1);
+		}
+		// stop at the tolerance, or once rounding keeps the error from halving
+		if (err <= tol || (err > prev / 2.0 && err <= std::sqrt(tol))) {
+			converged = true;
+			break;
+		}
+		prev = err;
+	}
+	if (!converged) {
+		merror("Matrix square root did not converge, is there an eigenvalue on the negative real axis?", WARN);
+	}
+	return QMatrix<T>(xk.data(), n, n);
+}
+
+// nodes and weights of the count point Gauss-Legendre rule on [0, 1]
+inline void _gauss_legendre01(uint32_t count, double* t, double* w) {
+	const double pi = 3.14159265358979323846;
+	for (uint32_t i = 0; i < count; ++i) {
+		double x = std::cos(pi * (i + 0.75) / (count + 0.5));
+		double dp = 1.0;
+		for (int it = 0; it < 100; ++it) {
+			// p1 = P_count(x), p0 = P_count-1(x)
+			double p0 = 1.0;
+			double p1 = x;
+			for (uint32_t k = 2; k <= count; ++k) {
+				double p2 = ((2.0 * k - 1.0) * x * p1 - (k - 1.0) * p0) / k;
+				p0 = p1;
+				p1 = p2;
+			}
+			dp = count * (x * p1 - p0) / (x * x - 1.0);
+			double dx = p1 / dp;
+			x -= dx;
+			if (std::fabs(dx) < 1e-16) {
+				break;
+			}
+		}
+		t[i] = (x + 1.0) / 2.0;
+		w[i] = 1.0 / ((1.0 - x * x) * dp * dp);
+	}
+}
+
+/*
+	Principal logarithm by inverse scaling and squaring: k square roots bring A
+	within 1/4 of I in the 1-norm, then log A = 2^k log(I + X) with
+	log(I + X) = sum w_j (I + t_j X)^-1 X over the Gauss-Legendre nodes of [0, 1].
+*/
+template<typename T>
+QMatrix<T> Logm(const QMatrix<T>& a) {
+	static_assert(std::is_floating_point_v<T> || _is_complex<T>::value,
+		"Logm needs a floating point or complex element type");
+	if (!a.IsSquare()) {
+		merror("Cannot take the logarithm of a non-square matrix!", E_MAT_INVALID_DIMENSION);
+		return a;
+	}
+	uint64_t n = a.GetN();
+	if (n == 0) {
+		return a;
+	}
+	uint64_t nn = n * n;
+	auto view = [n](std::vector<T>& buf) { return QMatrixView<T>::Of(buf.data(), n, n, Layout::RowMajor); };
+	auto cview = [n](const std::vector<T>& buf) { return QMatrixView<const T>::Of(buf.data(), n, n, Layout::RowMajor); };
+
+	QMatrix<T> r = a;
+	std::vector<T> x(SAFE_UINT(nn));
+	int k = 0;
+	while (true) {
+		Copy<T>(r.View(), view(x));
+		for (uint64_t i = 0; i < n; ++i) {
+			x[i * n + i] -= static_cast<T>(1);
+		}
+		if (_norm1<T>(cview(x)) <= 0.25 || k == 64) {
+			break;
+		}
+		r = Sqrtm(r);
+		++k;
+	}
+
+	const uint32_t nodes = 8;
+	double t[nodes], w[nodes];
+	_gauss_legendre01(nodes, t, w);
+
+	std::vector<T> res(SAFE_UINT(nn), static_cast<T>(0)), p(SAFE_UINT(nn)), q(SAFE_UINT(nn));
+	std::vector<uint32_t> piv(SAFE_UINT(n));
+	for (uint32_t j = 0; j < nodes; ++j) {
+		_lincomb<T>(n, p.data(), { { static_cast<T>(t[j]), x.data() } }, static_cast<T>(1));
+		if (!_lu_blocked<T>(view(p), piv.data())) {
+			merror("Singular factor in the matrix logarithm!", SEVERE);
+			return a;
+		}
+		q = x;
+		_lu_solve_many<T>(cview(p), piv.data(), view(q));
+		_axpy<T>(nn, static_cast<T>(w[j] * std::ldexp(1.0, k)), q.data(), res.data());
+	}
+	return QMatrix<T>(res.data(), n, n);
+}
+
+#endif
@@ -0,0 +1,205 @@
+#include "Numa.hpp"
+#include "MatrixError.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define KALGEBRA_NUMA_LINUX
+#endif
+
+#if defined(KALGEBRA_NUMA_LINUX)
+// <linux/mempolicy.h> values, the header is not always installed
+#define _MPOL_PREFERRED 1
+#define _MPOL_INTERLEAVE 3
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+static std::vector<uint32_t> _parse_cpulist(const std::string& s) {
+	std::vector<uint32_t> res;
+	size_t i = 0;
+	while (i < s.size()) {
+		char* end = nullptr;
+		unsigned long lo = strtoul(s.c_str() + i, &end, 10);
+		if (end == s.c_str() + i) {
+			break;
+		}
+		unsigned long hi = lo;
+		i = end - s.c_str();
+		if (i < s.size() && s[i] == '-') {
+			hi = strtoul(s.c_str() + i + 1, &end, 10);
+			i = end - s.c_str();
+		}
+		for (unsigned long c = lo; c <= hi; ++c) {
+			res.push_back(static_cast<uint32_t>(c));
+		}
+		while (i < s.size() && (s[i] == ',' || s[i] == '\n' || s[i] == ' ')) {
+			++i;
+		}
+	}
+	return res;
+}
+
+static bool _read_line(const std::string& path, std::string& line) {
+	FILE* f = fopen(path.c_str(), "r");
+	if (f == nullptr) {
+		return false;
+	}
+	char buf[4096];
+	bool ok = fgets(buf, sizeof(buf), f) != nullptr;
+	fclose(f);
+	if (ok) {
+		line = buf;
+	}
+	return ok;
+}
+
+static long _mbind(void* p, uint64_t bytes, int mode, const std::vector<unsigned long>& mask) {
+	// the kernel reads maxnode - 1 bits
+	unsigned long maxnode = static_cast<unsigned long>(mask.size() * 8 * sizeof(unsigned long));
+	return syscall(SYS_mbind, p, static_cast<unsigned long>(bytes), mode, mask.data(), maxnode, 0u);
+}
+
+static std::vector<unsigned long> _node_mask(const std::vector<uint32_t>& ids) {
+	uint32_t top = 0;
+	for (uint32_t id : ids) {
+		top = id > top ? id : top;
+	}
+	const uint32_t bits = 8 * sizeof(unsigned long);
+	std::vector<unsigned long> mask((top + 1) / bits + 1, 0ul);
+	for (uint32_t id : ids) {
+		mask[id / bits] |= 1ul << (id % bits);
+	}
+	return mask;
+}
+#endif
+
+NumaTopology::NumaTopology() : page(4096) {
+#if defined(KALGEBRA_NUMA_LINUX)
+	long _page = sysconf(_SC_PAGESIZE);
+	if (_page > 0) {
+		page = static_cast<uint64_t>(_page);
+	}
+
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+	std::string online;
+	if (_read_line("/sys/devices/system/node/online", online)) {
+		for (uint32_t id : _parse_cpulist(online)) {
+			std::string cpulist;
+			if (!_read_line("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist", cpulist)) {
+				continue;
+			}
+			NumaNode node{ id, {} };
+			for (uint32_t c : _parse_cpulist(cpulist)) {
+				if (!have_mask || (c < CPU_SETSIZE && CPU_ISSET(c, &allowed))) {
+					node.cpus.push_back(c);
+				}
+			}
+			if (!node.cpus.empty()) {
+				nodes.push_back(std::move(node));
+			}
+		}
+	}
+#endif
+
+	if (nodes.empty()) {
+		NumaNode node{ 0, {} };
+		unsigned int cpus = std::thread::hardware_concurrency();
+		for (uint32_t c = 0; c < (cpus ? cpus : 1); ++c) {
+			node.cpus.push_back(c);
+		}
+		nodes.push_back(std::move(node));
+	}
+}
+
+const NumaTopology& NumaTopology::Get() {
+	static NumaTopology topo;
+	return topo;
+}
+
+void* NumaMap(uint64_t bytes) {
+	if (bytes == 0) {
+		return nullptr;
+	}
+#if defined(KALGEBRA_NUMA_LINUX)
+	void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		merror("Could not map memory for a NUMA placed buffer!", CRITICAL);
+		return nullptr;
+	}
+	return p;
+#else
+	void* p = nullptr;
+	ALLOC_TRY(p = ::operator new(bytes, std::align_val_t(NumaTopology::Get().PageSize())));
+	return p;
+#endif
+}
+
+void NumaUnmap(void* p, uint64_t bytes) {
+	if (p == nullptr) {
+		return;
+	}
+#if defined(KALGEBRA_NUMA_LINUX)
+	munmap(p, bytes);
+#else
+	(void)bytes;
+	::operator delete(p, std::align_val_t(NumaTopology::Get().PageSize()));
+#endif
+}
+
+bool NumaBindRange(void* p, uint64_t bytes, uint32_t node) {
+	const NumaTopology& topo = NumaTopology::Get();
+	if (p == nullptr || bytes == 0 || node >= topo.NodeCount() || topo.NodeCount() == 1) {
+		return false;
+	}
+#if defined(KALGEBRA_NUMA_LINUX)
+	return _mbind(p, bytes, _MPOL_PREFERRED, _node_mask({ topo.Node(node).id })) == 0;
+#else
+	return false;
+#endif
+}
+
+bool NumaInterleaveRange(void* p, uint64_t bytes) {
+	const NumaTopology& topo = NumaTopology::Get();
+	if (p == nullptr || bytes == 0 || topo.NodeCount() == 1) {
+		return false;
+	}
+#if defined(KALGEBRA_NUMA_LINUX)
+	std::vector<uint32_t> ids;
+	for (uint32_t k = 0; k < topo.NodeCount(); ++k) {
+		ids.push_back(topo.Node(k).id);
+	}
+	return _mbind(p, bytes, _MPOL_INTERLEAVE, _node_mask(ids)) == 0;
+#else
+	return false;
+#endif
+}
+
+bool PinThreadToNode(uint32_t k) {
+	const NumaTopology& topo = NumaTopology::Get();
+	if (k >= topo.NodeCount()) {
+		return false;
+	}
+#if defined(KALGEBRA_NUMA_LINUX)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (uint32_t c : topo.Node(k).cpus) {
+		if (c < CPU_SETSIZE) {
+			CPU_SET(c, &set);
+		}
+	}
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
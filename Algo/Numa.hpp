@@ -0,0 +1,144 @@
+#ifndef _NUMA_H
+#define _NUMA_H
+
+#include "ThreadPool.hpp"
+#include <stdint.h>
+#include <future>
+#include <memory>
+#include <vector>
+
+/*
+	NUMA topology, node-placed memory and node-pinned workers.
+
+	The topology is read once from /sys/devices/system/node and restricted to the
+	CPUs the process may run on; nodes without such CPUs are left out. Memory comes
+	from anonymous mappings whose pages are placed with mbind (called through
+	syscall, so there is no libnuma dependency). The policy is only a preference,
+	and first touch from a pinned worker places the pages as well when mbind is
+	not available, e.g. under a seccomp filter.
+
+	Everywhere else (and on Linux without /sys/devices/system/node) the topology is
+	a single node with every CPU, placement calls do nothing and pinning fails
+	quietly, so callers need no special cases.
+*/
+
+struct NumaNode {
+	uint32_t id;
+	std::vector<uint32_t> cpus;
+};
+
+class NumaTopology {
+public:
+	static const NumaTopology& Get();
+
+	uint32_t NodeCount() const noexcept { return static_cast<uint32_t>(nodes.size()); }
+	const NumaNode& Node(uint32_t k) const { return nodes[k]; }
+	uint64_t PageSize() const noexcept { return page; }
+
+private:
+	NumaTopology();
+
+	std::vector<NumaNode> nodes;
+	uint64_t page;
+};
+
+// page-aligned anonymous mapping, the pages are not touched yet
+void* NumaMap(uint64_t bytes);
+void NumaUnmap(void* p, uint64_t bytes);
+
+// placement of [p, p + bytes), p page-aligned; false when the policy could not be set
+bool NumaBindRange(void* p, uint64_t bytes, uint32_t node);
+bool NumaInterleaveRange(void* p, uint64_t bytes);
+
+// restricts the calling thread to the CPUs of topology node k
+bool PinThreadToNode(uint32_t k);
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+	One ThreadPool per topology node, its workers pinned to that node.
+
+	ParallelFor splits [begin, end) into one contiguous part per node, sized by the
+	node's worker count (Split()), and every part only runs on its own node. Data
+	laid out with the same split is therefore only touched by the node holding it.
+*/
+class NumaPool {
+public:
+	explicit NumaPool(uint32_t threads_per_node = 0) {
+		const NumaTopology& topo = NumaTopology::Get();
+		for (uint32_t k = 0; k < topo.NodeCount(); ++k) {
+			size_t threads = threads_per_node ? threads_per_node : topo.Node(k).cpus.size();
+			pools.emplace_back(std::make_unique<ThreadPool>(threads, [k](size_t) { PinThreadToNode(k); }));
+		}
+	}
+
+	NumaPool(const NumaPool&) = delete;
+	NumaPool& operator=(const NumaPool&) = delete;
+
+	uint32_t NodeCount() const noexcept { return static_cast<uint32_t>(pools.size()); }
+	ThreadPool& Node(uint32_t k) noexcept { return *pools[k]; }
+
+	size_t Size() const noexcept {
+		size_t res = 0;
+		for (const std::unique_ptr<ThreadPool>& p : pools) {
+			res += p->Size();
+		}
+		return res;
+	}
+
+	// node k owns [split[k], split[k + 1])
+	std::vector<uint64_t> Split(uint64_t count) const {
+		std::vector<uint64_t> split(pools.size() + 1, 0);
+		size_t total = Size();
+		size_t acc = 0;
+		for (size_t k = 0; k < pools.size(); ++k) {
+			acc += pools[k]->Size();
+			split[k + 1] = count * acc / total;
+		}
+		return split;
+	}
+
+	// runs f(k) once on a worker of every node k and waits for all of them
+	template<typename F>
+	void OnEachNode(F f) {
+		if (pools.size() == 1) {
+			pools[0]->Submit([&f] { f(0u); }).get();
+			return;
+		}
+		std::vector<std::future<void>> done;
+		for (uint32_t k = 0; k < pools.size(); ++k) {
+			done.push_back(pools[k]->Submit([&f, k] { f(k); }));
+		}
+		for (std::future<void>& d : done) {
+			d.get();
+		}
+	}
+
+	// f(i) for every i in [begin, end), i in node k's part of split runs on node k
+	template<typename F>
+	void ParallelFor(uint64_t begin, uint64_t end, const std::vector<uint64_t>& split, F f, uint64_t grain = 1) {
+		OnEachNode([&](uint32_t k) {
+			uint64_t lo = begin + split[k];
+			uint64_t hi = begin + split[k + 1] < end ? begin + split[k + 1] : end;
+			pools[k]->ParallelFor(lo, hi, f, grain);
+		});
+	}
+
+	template<typename F>
+	void ParallelFor(uint64_t begin, uint64_t end, F f, uint64_t grain = 1) {
+		if (end <= begin) {
+			return;
+		}
+		ParallelFor(begin, end, Split(end - begin), f, grain);
+	}
+
+	static NumaPool& Shared() {
+		static NumaPool pool;
+		return pool;
+	}
+
+private:
+	std::vector<std::unique_ptr<ThreadPool>> pools;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "Numa.hpp"
+#include "NumaQMatrix.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+/*
+	numa_bench [MiB per buffer] [gemm n]
+
+	1. read / write bandwidth of the workers of every node against memory bound to
+	   every node, the diagonal is local traffic, the rest crosses the interconnect
+	2. NumaAxpy over the whole machine for each placement
+	3. NumaGemm with first-touch operands against partitioned a, c and interleaved b
+*/
+
+static double _best_seconds(int reps, const std::function<void()>& f) {
+	double best = 1e30;
+	for (int r = 0; r < reps; ++r) {
+		auto t0 = std::chrono::steady_clock::now();
+		f();
+		double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		best = s < best ? s : best;
+	}
+	return best;
+}
+
+static const char* _placement_name(NumaPlacement p) {
+	switch (p) {
+	case NumaPlacement::FirstTouch: return "first-touch";
+	case NumaPlacement::Interleave: return "interleave";
+	default: return "partitioned";
+	}
+}
+
+static void _bandwidth_matrix(NumaPool& pool, uint64_t bytes) {
+	const uint64_t count = bytes / sizeof(double);
+	const uint64_t grain = 1 << 16;
+	const uint64_t chunks = (count + grain - 1) / grain;
+	uint32_t nodes = pool.NodeCount();
+
+	printf("per-node bandwidth, GB/s (rows: worker node, columns: memory node)\n");
+	printf("%-12s", "");
+	for (uint32_t j = 0; j < nodes; ++j) {
+		printf("  mem %-3u read  write", NumaTopology::Get().Node(j).id);
+	}
+	printf("\n");
+
+	std::vector<double*> bufs(nodes);
+	for (uint32_t j = 0; j < nodes; ++j) {
+		bufs[j] = static_cast<double*>(NumaMap(count * sizeof(double)));
+		NumaBindRange(bufs[j], count * sizeof(double), j);
+		// touched from node j so the pages land there even without mbind
+		pool.Node(j).Submit([&] {
+			pool.Node(j).ParallelFor(0, chunks, [&](uint64_t c) {
+				uint64_t hi = (c + 1) * grain < count ? (c + 1) * grain : count;
+				std::fill(bufs[j] + c * grain, bufs[j] + hi, 1.0);
+			});
+		}).get();
+	}
+
+	for (uint32_t i = 0; i < nodes; ++i) {
+		printf("cpu node %-3u", NumaTopology::Get().Node(i).id);
+		ThreadPool& workers = pool.Node(i);
+		for (uint32_t j = 0; j < nodes; ++j) {
+			double* buf = bufs[j];
+			std::vector<double> partial(chunks);
+			double read = _best_seconds(5, [&] {
+				workers.Submit([&] {
+					workers.ParallelFor(0, chunks, [&](uint64_t c) {
+						uint64_t hi = (c + 1) * grain < count ? (c + 1) * grain : count;
+						// x . x streams x once, the second operand hits in L1
+						partial[c] = _dot<double>(hi - c * grain, buf + c * grain, buf + c * grain);
+					});
+				}).get();
+			});
+			double write = _best_seconds(5, [&] {
+				workers.Submit([&] {
+					workers.ParallelFor(0, chunks, [&](uint64_t c) {
+						uint64_t hi = (c + 1) * grain < count ? (c + 1) * grain : count;
+						std::fill(buf + c * grain, buf + hi, 2.0);
+					});
+				}).get();
+			});
+			printf("  %13.2f %6.2f", bytes / read * 1e-9, bytes / write * 1e-9);
+		}
+		printf("\n");
+	}
+
+	for (uint32_t j = 0; j < nodes; ++j) {
+		NumaUnmap(bufs[j], count * sizeof(double));
+	}
+}
+
+static void _axpy_placements(uint64_t bytes) {
+	uint64_t m = 4096;
+	uint64_t n = bytes / sizeof(double) / m;
+	n = n ? n : 1;
+
+	printf("\nNumaAxpy %llu x %llu doubles, all workers\n", (unsigned long long)n, (unsigned long long)m);
+	for (NumaPlacement p : { NumaPlacement::FirstTouch, NumaPlacement::Interleave, NumaPlacement::Partitioned }) {
+		NumaQMatrix<double> x(n, m, p);
+		NumaQMatrix<double> y(n, m, p);
+		double s = _best_seconds(5, [&] { NumaAxpy(0.5, x, y); });
+		printf("  %-12s %8.2f GB/s\n", _placement_name(p), 3.0 * n * m * sizeof(double) / s * 1e-9);
+	}
+}
+
+static void _gemm_placements(uint64_t n) {
+	printf("\nNumaGemm %llu x %llu floats, all workers\n", (unsigned long long)n, (unsigned long long)n);
+
+	std::vector<float> _tmp_nums(SAFE_UINT(n * n));
+	for (uint64_t i = 0; i < n * n; ++i) {
+		_tmp_nums[i] = static_cast<float>((i * 7919) % 1000) * 1e-3f - 0.5f;
+	}
+	QMatrixView<const float> src = QMatrixView<const float>::Of(_tmp_nums.data(), n, n, Layout::RowMajor);
+
+	struct Setup {
+		const char* name;
+		NumaPlacement ac, b;
+	};
+	for (const Setup& st : { Setup{ "first-touch", NumaPlacement::FirstTouch, NumaPlacement::FirstTouch },
+		Setup{ "partitioned", NumaPlacement::Partitioned, NumaPlacement::Interleave } }) {
+		NumaQMatrix<float> a(src, st.ac);
+		NumaQMatrix<float> b(src, st.b);
+		NumaQMatrix<float> c(n, n, st.ac);
+		double s = _best_seconds(3, [&] { NumaGemm(a, b, c); });
+		printf("  %-12s %8.2f GFLOP/s\n", st.name, 2.0 * n * n * n / s * 1e-9);
+	}
+}
+
+int main(int argc, char** argv) {
+	uint64_t mib = argc > 1 ? strtoull(argv[1], nullptr, 10) : 256;
+	uint64_t gemm_n = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2048;
+	mib = mib ? mib : 1;
+
+	NumaPool& pool = NumaPool::Shared();
+	const NumaTopology& topo = NumaTopology::Get();
+	printf("%u NUMA node(s), %zu worker(s)\n", topo.NodeCount(), pool.Size());
+	for (uint32_t k = 0; k < topo.NodeCount(); ++k) {
+		printf("  node %u: %zu cpu(s)\n", topo.Node(k).id, topo.Node(k).cpus.size());
+	}
+	printf("\n");
+
+	_bandwidth_matrix(pool, mib << 20);
+	_axpy_placements(mib << 20);
+	if (gemm_n > 0) {
+		_gemm_placements(gemm_n);
+	}
+	return 0;
+}
@@ -0,0 +1,217 @@
+#ifndef _NUMA_QMATRIX_H
+#define _NUMA_QMATRIX_H
+
+#include "MatrixError.hpp"
+#include "Numa.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include <stdint.h>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/*
+	Row-major matrix whose pages are placed across the NUMA nodes of a NumaPool.
+
+	  - FirstTouch: zeroed by the calling thread, so every page lands on the caller's
+	    node; this is what a plain new T[n * m] gets and only suits single-node use
+	  - Interleave: pages round-robin over all nodes, for operands every node reads
+	    in full (the right-hand side of NumaGemm)
+	  - Partitioned: rows split like NumaPool::Split(n), each block bound to and
+	    first touched by its own node
+
+	NumaAxpy, NumaTransform and NumaGemm hand the rows of their output to the node
+	that owns them, so on partitioned storage every node only streams local memory.
+	Block boundaries are rounded to pages; a page shared by two blocks goes to the
+	lower one.
+*/
+
+enum class NumaPlacement {
+	FirstTouch,
+	Interleave,
+	Partitioned
+};
+
+template<typename T>
+class NumaQMatrix {
+	static_assert(std::is_trivially_copyable_v<T>, "NUMA placed matrices hold trivially copyable elements");
+
+public:
+	NumaQMatrix(uint64_t n, uint64_t m, NumaPlacement placement = NumaPlacement::Partitioned,
+		NumaPool& pool = NumaPool::Shared());
+	NumaQMatrix(QMatrixView<const T> src, NumaPlacement placement = NumaPlacement::Partitioned,
+		NumaPool& pool = NumaPool::Shared());
+	~NumaQMatrix();
+
+	NumaQMatrix(const NumaQMatrix<T>&) = delete;
+	NumaQMatrix<T>& operator=(const NumaQMatrix<T>&) = delete;
+	NumaQMatrix(NumaQMatrix<T>&& other) noexcept;
+
+	uint64_t GetN() const noexcept { return n; }
+	uint64_t GetM() const noexcept { return m; }
+	NumaPlacement Placement() const noexcept { return placement; }
+	NumaPool& Pool() const noexcept { return *pool; }
+
+	// rows of node k are [RowSplit()[k], RowSplit()[k + 1])
+	const std::vector<uint64_t>& RowSplit() const noexcept { return split; }
+
+	T* Data() noexcept { return data; }
+	const T* Data() const noexcept { return data; }
+	QMatrixView<T> View() noexcept { return QMatrixView<T>(data, n, m, SAFE_INT(m), 1); }
+	QMatrixView<const T> View() const noexcept { return QMatrixView<const T>(data, n, m, SAFE_INT(m), 1); }
+
+	QMatrix<T> ToQMatrix() const { return QMatrix<T>(View()); }
+
+private:
+	void _place();
+
+	T* data;
+	uint64_t n, m, bytes;
+	NumaPlacement placement;
+	NumaPool* pool;
+	std::vector<uint64_t> split;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+NumaQMatrix<T>::NumaQMatrix(uint64_t n, uint64_t m, NumaPlacement placement, NumaPool& pool) :
+	data(nullptr), n(n), m(m), bytes(n * m * sizeof(T)), placement(placement), pool(&pool), split(pool.Split(n)) {
+	_place();
+}
+
+template<typename T>
+NumaQMatrix<T>::NumaQMatrix(QMatrixView<const T> src, NumaPlacement placement, NumaPool& pool) :
+	NumaQMatrix(src.GetN(), src.GetM(), placement, pool) {
+	if (data == nullptr) {
+		return;
+	}
+	// each node copies its own rows so the source streams into local pages
+	pool.OnEachNode([&](uint32_t k) {
+		uint64_t lo = split[k];
+		uint64_t hi = split[k + 1];
+		if (hi > lo) {
+			Copy<T>(src.Sub(lo, 0, hi - lo, m), View().Sub(lo, 0, hi - lo, m));
+		}
+	});
+}
+
+template<typename T>
+NumaQMatrix<T>::NumaQMatrix(NumaQMatrix<T>&& other) noexcept :
+	data(other.data), n(other.n), m(other.m), bytes(other.bytes), placement(other.placement),
+	pool(other.pool), split(std::move(other.split)) {
+	other.data = nullptr;
+	other.n = 0;
+	other.m = 0;
+	other.bytes = 0;
+}
+
+template<typename T>
+NumaQMatrix<T>::~NumaQMatrix() {
+	NumaUnmap(data, bytes);
+	n = 0;
+	m = 0;
+}
+
+template<typename T>
+void NumaQMatrix<T>::_place() {
+	data = static_cast<T*>(NumaMap(bytes));
+	if (data == nullptr) {
+		return;
+	}
+
+	char* base = reinterpret_cast<char*>(data);
+	uint64_t page = NumaTopology::Get().PageSize();
+	uint64_t row_bytes = m * sizeof(T);
+
+	if (placement == NumaPlacement::FirstTouch) {
+		memset(base, 0, SAFE_UINT(bytes));
+		return;
+	}
+
+	if (placement == NumaPlacement::Interleave) {
+		NumaInterleaveRange(base, bytes);
+	}
+	else {
+		for (uint32_t k = 0; k < pool->NodeCount(); ++k) {
+			uint64_t lo = (split[k] * row_bytes + page - 1) / page * page;
+			uint64_t hi = k + 1 == pool->NodeCount() ? bytes : (split[k + 1] * row_bytes + page - 1) / page * page;
+			if (hi > lo) {
+				NumaBindRange(base + lo, hi - lo, k);
+			}
+		}
+	}
+
+	// first touch from the owning node, which also places the pages where mbind failed
+	pool->ParallelFor(0, n, split, [&](uint64_t i) {
+		memset(base + i * row_bytes, 0, SAFE_UINT(row_bytes));
+	}, 64);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// rows of y per node, split further into about one chunk per worker
+template<typename T, typename F>
+void _numa_rows(NumaQMatrix<T>& y, F f) {
+	NumaPool& pool = y.Pool();
+	const std::vector<uint64_t>& split = y.RowSplit();
+	pool.OnEachNode([&](uint32_t k) {
+		uint64_t lo = split[k];
+		uint64_t rows = split[k + 1] - lo;
+		if (rows == 0) {
+			return;
+		}
+		ThreadPool& node = pool.Node(k);
+		uint64_t chunk = (rows + node.Size() - 1) / node.Size();
+		uint64_t chunks = (rows + chunk - 1) / chunk;
+		node.ParallelFor(0, chunks, [&](uint64_t c) {
+			uint64_t r0 = lo + c * chunk;
+			uint64_t r1 = r0 + chunk < lo + rows ? r0 + chunk : lo + rows;
+			f(r0, r1);
+		});
+	});
+}
+
+// y += alpha * x
+template<typename T>
+void NumaAxpy(T alpha, const NumaQMatrix<T>& x, NumaQMatrix<T>& y) {
+	if (x.GetN() != y.GetN() || x.GetM() != y.GetM()) {
+		merror("Cannot add matrices with different dimensions!", E_MAT_INVALID_DIMENSION);
+		return;
+	}
+	uint64_t m = y.GetM();
+	_numa_rows(y, [&](uint64_t r0, uint64_t r1) {
+		_axpy<T>((r1 - r0) * m, alpha, x.Data() + r0 * m, y.Data() + r0 * m);
+	});
+}
+
+// a(i, j) = f(a(i, j)) for every entry
+template<typename T, typename F>
+void NumaTransform(NumaQMatrix<T>& a, F f) {
+	uint64_t m = a.GetM();
+	_numa_rows(a, [&](uint64_t r0, uint64_t r1) {
+		T* p = a.Data() + r0 * m;
+		for (uint64_t i = 0; i < (r1 - r0) * m; ++i) {
+			p[i] = f(p[i]);
+		}
+	});
+}
+
+/*
+	c = a * b, every node computes the rows of c it owns from the same rows of a.
+	b is read in full by all nodes, so it is best Interleave placed.
+*/
+template<typename T>
+void NumaGemm(const NumaQMatrix<T>& a, const NumaQMatrix<T>& b, NumaQMatrix<T>& c) {
+	if (a.GetM() != b.GetN() || c.GetN() != a.GetN() || c.GetM() != b.GetM()) {
+		merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+		return;
+	}
+	uint64_t p = a.GetM();
+	uint64_t m = c.GetM();
+	_numa_rows(c, [&](uint64_t r0, uint64_t r1) {
+		Gemm<T>(a.View().Sub(r0, 0, r1 - r0, p), b.View(), c.View().Sub(r0, 0, r1 - r0, m));
+	});
+}
+
+#endif
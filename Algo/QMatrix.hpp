@@ -2,13 +2,23 @@
 #define _QMATRIX_H
 
 #include "MatrixError.hpp"
+#include "QMatrixView.hpp"
 #include <stdint.h>
+#include <algorithm>
+#include <cstring>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <complex>
 #include <ostream>
+#include <type_traits>
 
 template<typename T> class QMatrix;
 
+// determinants accumulate in double precision, complex ones in complex<double>
+template<typename T> struct _det_type { using type = double; };
+template<typename T> struct _det_type<std::complex<T>> { using type = std::complex<double>; };
+
 #define SQUARE
 
 /*
@@ -20,11 +30,15 @@ template<typename T> class QMatrix;
 template<typename U>
 struct _row {
 public:
-	_row(const U* _a_, uint64_t k) {
+	_row(const U* _a_, uint64_t k) : entries(nullptr), k(k) {
 		ALLOC_TRY(entries = new U[k]);
 		memcpy(entries, _a_, SAFE_UINT(SAFE_UINT(k) * sizeof(U)));
 	}
-	~_row() {}
+	_row(const _row<U>& other) : _row(other.entries, other.k) {}
+	_row<U>& operator=(const _row<U>&) = delete;
+	~_row() {
+		delete[] entries;
+	}
 
 	U operator[](size_t idx) {
 		DEREF_TRY(return entries[idx]);
@@ -32,12 +46,17 @@ public:
 
 private:
 	U* entries;
+	uint64_t k;
 };
 
 template<typename T>
 class QMatrix {
 public:
+	using DetType = typename _det_type<T>::type;
+
 	QMatrix(const T* entries, uint64_t n, uint64_t m);
+	QMatrix(const T* entries, uint64_t n, uint64_t m, Layout layout, uint64_t ld = 0);
+	QMatrix(QMatrixView<const T> view);
 	~QMatrix();
 	QMatrix(const QMatrix<T>& other);
 	QMatrix(QMatrix<T>&& other) noexcept;
@@ -45,8 +64,19 @@ public:
 	uint64_t GetN() const noexcept;
 	uint64_t GetM() const noexcept;
 
-	double OpNorm(const QMatrix<T>& a) const noexcept;
-	double Det() const noexcept;
+	// content hash over the dimensions and the element bytes. A snapshot: it is
+	// cached until the matrix is assigned to or a writable View() is taken, so
+	// writes through a view taken earlier are not seen. Never used for equality.
+	uint64_t Hash() const noexcept;
+
+	QMatrixView<T> View() noexcept;
+	QMatrixView<const T> View() const noexcept;
+	QMatrix<T> Transpose() const;
+	QMatrix<T> Adjoint() const;
+
+	// spectral norm, the largest singular value
+	double OpNorm() const noexcept;
+	DetType Det() const noexcept;
 	
 	uint64_t Rank() const noexcept;
 	uint64_t Defect() const noexcept;
@@ -54,6 +84,7 @@ public:
 	bool IsLinearlyDep(const QMatrix<T>& a) const noexcept;
 	bool IsSquare() const noexcept;
 
+	// A = L U with U unit upper and L lower up to the row swaps of partial pivoting
 	SQUARE std::array<QMatrix<T>, 2> DecomposeLU() const;
 	SQUARE std::array<QMatrix<T>, 3> DecomposeEigen(const QMatrix<T>& a) const;
 	SQUARE std::array<QMatrix<T>, 3> DecomposeSingularValue(const QMatrix<T>& a) const;
@@ -63,67 +94,76 @@ public:
 	QMatrix<T>& operator=(const QMatrix<T>& other);
 	QMatrix<T>& operator=(QMatrix<T>&& other) noexcept;
 
-	template<typename T> friend std::ostream& operator<<(std::ostream& os, const QMatrix<T>& mat);
-    SQUARE template<typename T> friend QMatrix<T> operator+(const QMatrix<T>& left, const QMatrix<T>& right);
-    SQUARE template<typename T> friend QMatrix<T> operator-(const QMatrix<T>& left, const QMatrix<T>& right);
-    template<typename T> friend QMatrix<T> operator*(const QMatrix<T>& left, const QMatrix<T>& right);
-    template<typename T> friend QMatrix<T> operator+(const QMatrix<T>& a, T scalar);
-    template<typename T> friend QMatrix<T> operator-(const QMatrix<T>& a, T scalar);
-    template<typename T> friend QMatrix<T> operator*(const QMatrix<T>& a, T scalar);
+	template<typename U> friend std::ostream& operator<<(std::ostream& os, const QMatrix<U>& mat);
+    template<typename U> friend bool operator==(const QMatrix<U>& a, const QMatrix<U>& b);
+    SQUARE template<typename U> friend QMatrix<U> operator+(const QMatrix<U>& left, const QMatrix<U>& right);
+    SQUARE template<typename U> friend QMatrix<U> operator-(const QMatrix<U>& left, const QMatrix<U>& right);
+    template<typename U> friend QMatrix<U> operator*(const QMatrix<U>& left, const QMatrix<U>& right);
+    template<typename U> friend QMatrix<U> operator+(const QMatrix<U>& a, U scalar);
+    template<typename U> friend QMatrix<U> operator-(const QMatrix<U>& a, U scalar);
+    template<typename U> friend QMatrix<U> operator*(const QMatrix<U>& a, U scalar);
+    SQUARE template<typename U> friend QMatrix<U> I(uint64_t n);
 
 private:
 	T* data;
 	uint64_t n, m;
+	// 0 until computed
+	mutable std::atomic<uint64_t> hash{ 0 };
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 template<typename T>
 QMatrix<T>::~QMatrix() {
-    n = static_cast<T>(0);
-    m = static_cast<T>(0);
+    n = 0;
+    m = 0;
     delete[] data;
 }
 
 template<typename T>
-QMatrix<T>::QMatrix(const T* entries, uint64_t n, uint64_t m) : n(n), m(m) {
+QMatrix<T>::QMatrix(const T* entries, uint64_t n, uint64_t m) : data(nullptr), n(n), m(m) {
     ALLOC_TRY(data = new T[SAFE_UINT(n) * SAFE_UINT(m)]);
     memcpy(data, entries, SAFE_UINT(SAFE_UINT(n) * SAFE_UINT(m) * sizeof(T)));
 }
 
 template<typename T>
-QMatrix<T>::QMatrix(const QMatrix<T>& other) {
-    if (n != other.n || m != other.m) {
-        //delete[] data;
-        ALLOC_TRY(data = new T[SAFE_UINT(other.GetN()) * SAFE_UINT(other.GetM())]);
-    }
-    n = other.n;
-    m = other.m;
-
-    memcpy(data, other.data, SAFE_UINT(SAFE_UINT(n) * SAFE_UINT(m) * sizeof(T)));
+QMatrix<T>::QMatrix(const T* entries, uint64_t n, uint64_t m, Layout layout, uint64_t ld) : data(nullptr), n(n), m(m) {
+    ALLOC_TRY(data = new T[SAFE_UINT(n) * SAFE_UINT(m)]);
+    Copy<T>(QMatrixView<const T>::Of(entries, n, m, layout, ld), View());
 }
 
 template<typename T>
-QMatrix<T>::QMatrix(QMatrix<T>&& other) noexcept {
-    if (n != other.n || m != other.m) {
-        //delete[] data;
-        ALLOC_TRY(data = new T[SAFE_UINT(other.n) * SAFE_UINT(other.m)]);
-    }
-    n = other.n;
-    m = other.m;
+QMatrix<T>::QMatrix(QMatrixView<const T> view) : data(nullptr), n(view.GetN()), m(view.GetM()) {
+    ALLOC_TRY(data = new T[SAFE_UINT(n) * SAFE_UINT(m)]);
+    Copy<T>(view, View());
+}
 
+template<typename T>
+QMatrix<T>::QMatrix(const QMatrix<T>& other) : data(nullptr), n(other.n), m(other.m) {
+    ALLOC_TRY(data = new T[SAFE_UINT(n) * SAFE_UINT(m)]);
     memcpy(data, other.data, SAFE_UINT(SAFE_UINT(n) * SAFE_UINT(m) * sizeof(T)));
+}
+
+template<typename T>
+QMatrix<T>::QMatrix(QMatrix<T>&& other) noexcept : data(other.data), n(other.n), m(other.m), hash(other.hash.load()) {
+    other.hash = 0;
     other.data = nullptr;
+    other.n = 0;
+    other.m = 0;
 }
 
 template<typename T>
 QMatrix<T>& QMatrix<T>::operator=(const QMatrix<T>& other) {
+    if (this == &other) {
+        return *this;
+    }
     if (n != other.n || m != other.m) {
         delete[] data;
         ALLOC_TRY(data = new T[SAFE_UINT(other.n) * SAFE_UINT(other.m)]);
     }
     n = other.n;
     m = other.m;
+    hash = 0;
 
     memcpy(data, other.data, SAFE_UINT(SAFE_UINT(n) * SAFE_UINT(m) * sizeof(T)));
 
@@ -132,15 +172,19 @@ QMatrix<T>& QMatrix<T>::operator=(const QMatrix<T>& other) {
 
 template<typename T>
 QMatrix<T>& QMatrix<T>::operator=(QMatrix<T>&& other) noexcept {
-    if (n != other.n || m != other.m) {
-        delete[] data;
-        ALLOC_TRY(data = new T[SAFE_UINT(other.n) * SAFE_UINT(other.m)]);
+    if (this == &other) {
+        return *this;
     }
+    delete[] data;
+    data = other.data;
     n = other.n;
     m = other.m;
+    hash = other.hash.load();
 
-    memcpy(data, other.data, SAFE_UINT(SAFE_UINT(n) * SAFE_UINT(m) * sizeof(T)));
+    other.hash = 0;
     other.data = nullptr;
+    other.n = 0;
+    other.m = 0;
 
     return *this;
 }
@@ -160,6 +204,48 @@ uint64_t QMatrix<T>::GetM() const noexcept {
     return SAFE_UINT(m);
 }
 
+template<typename T>
+uint64_t QMatrix<T>::Hash() const noexcept {
+    uint64_t h = hash.load(std::memory_order_relaxed);
+    if (h != 0) {
+        return h;
+    }
+    uint64_t seed = (n * 0x9E3779B185EBCA87ull) ^ (m + 0xC2B2AE3D27D4EB4Full) ^ (sizeof(T) << 56);
+    h = Kernels().hash64(data, SAFE_UINT(n * m * sizeof(T)), seed);
+    h = h ? h : 1;
+    hash.store(h, std::memory_order_relaxed);
+    return h;
+}
+
+template<typename T>
+QMatrixView<T> QMatrix<T>::View() noexcept {
+    // the caller may write through the view
+    hash.store(0, std::memory_order_relaxed);
+    return QMatrixView<T>(data, n, m, SAFE_INT(m), 1);
+}
+
+template<typename T>
+QMatrixView<const T> QMatrix<T>::View() const noexcept {
+    return QMatrixView<const T>(data, n, m, SAFE_INT(m), 1);
+}
+
+template<typename T>
+QMatrix<T> QMatrix<T>::Transpose() const {
+    return QMatrix<T>(View().Transposed());
+}
+
+// conjugate transpose, same as Transpose() for real T
+template<typename T>
+QMatrix<T> QMatrix<T>::Adjoint() const {
+    QMatrix<T> res = Transpose();
+    if constexpr (_is_complex<T>::value) {
+        for (uint64_t i = 0; i < n * m; ++i) {
+            res.data[i] = std::conj(res.data[i]);
+        }
+    }
+    return res;
+}
+
 template<typename T>
 T QMatrix<T>::GetItem(uint64_t i, uint64_t j) const {
     T res = 0;
@@ -169,13 +255,7 @@ T QMatrix<T>::GetItem(uint64_t i, uint64_t j) const {
 
 template<typename T>
 _row<T> QMatrix<T>::operator[](uint64_t i) const {
-    T* _tmp_dat = nullptr;
-    ALLOC_TRY(_tmp_dat = new T[m]);
-    memcpy(_tmp_dat, static_cast<T*>(data + i * SAFE_UINT(m)), SAFE_UINT(SAFE_UINT(m)*sizeof(T)));
-  
-    _row<T> r(_tmp_dat, m);
-    _tmp_dat = nullptr;
-    return r;
+    return _row<T>(data + i * SAFE_UINT(m), m);
 }
 
 template<typename TT>
@@ -184,20 +264,23 @@ bool operator==(const QMatrix<TT>& a, const QMatrix<TT>& b) {
         return false;
     }
 
-    uint64_t n = a.GetN();
-    uint64_t m = a.GetM();
-
-    bool _flag = true;
-    for (size_t i = 0; i < n; ++i) {
-        for (size_t j = 0; j < m; ++j) {
-            if (a[i][j] != b[i][j]) {
-                _flag = false;
-            }
+    // blocks of branch-free compares, stopping after the first block with a difference
+    const uint64_t block = 256;
+    const TT* x = a.data;
+    const TT* y = b.data;
+    uint64_t count = a.GetN() * a.GetM();
+    for (uint64_t lo = 0; lo < count; lo += block) {
+        uint64_t hi = lo + block < count ? lo + block : count;
+        bool _diff = false;
+        for (uint64_t i = lo; i < hi; ++i) {
+            _diff |= x[i] != y[i];
+        }
+        if (_diff) {
+            return false;
         }
     }
 
-    return _flag;
-
+    return true;
 }
 
 template<typename TT>
@@ -210,69 +293,242 @@ bool operator>(const QMatrix<TT>& a, const QMatrix<TT> b) {
     return a.OpNorm() > b.OpNorm();
 }
 
+/*
+    Crout factorization in place: afterwards a holds L on and below the diagonal
+    and the strictly upper part of the unit upper U. Returns false on a zero pivot,
+    there is no pivoting.
+*/
+template<typename T>
+bool _crout_in_place(QMatrixView<T> a) {
+    static_assert(!std::is_integral_v<T>, "Crout factors of an integer matrix are not integers");
+    uint64_t n = a.GetN();
+    for (uint64_t i = 0; i < n; ++i) {
+        for (uint64_t j = i; j < n; ++j) {
+            T s = a(j, i);
+            for (uint64_t k = 0; k < i; ++k) {
+                s -= a(j, k) * a(k, i);
+            }
+            a(j, i) = s;
+        }
+        if (a(i, i) == static_cast<T>(0)) {
+            return false;
+        }
+        for (uint64_t j = i + 1; j < n; ++j) {
+            T s = a(i, j);
+            for (uint64_t k = 0; k < i; ++k) {
+                s -= a(i, k) * a(k, j);
+            }
+            a(i, j) = s / a(i, i);
+        }
+    }
+    return true;
+}
+
+/*
+	P A = L U with partial pivoting in place (L unit lower, U upper, getrf storage),
+	piv[k] is the row swapped with row k at step k. Returns det A.
+*/
+template<typename T>
+typename QMatrix<T>::DetType _lu_pivot_in_place(QMatrixView<T> a, uint32_t* piv) {
+	using D = typename QMatrix<T>::DetType;
+	uint64_t n = a.GetN();
+	D det = static_cast<D>(1);
+	for (uint64_t k = 0; k < n; ++k) {
+		uint64_t p = k;
+		for (uint64_t i = k + 1; i < n; ++i) {
+			if (std::abs(a(i, k)) > std::abs(a(p, k))) {
+				p = i;
+			}
+		}
+		piv[k] = static_cast<uint32_t>(p);
+		if (p != k) {
+			det = -det;
+			for (uint64_t j = 0; j < n; ++j) {
+				T t = a(k, j);
+				a(k, j) = a(p, j);
+				a(p, j) = t;
+			}
+		}
+		T pv = a(k, k);
+		det *= static_cast<D>(pv);
+		if (pv == static_cast<T>(0)) {
+			continue;
+		}
+		for (uint64_t i = k + 1; i < n; ++i) {
+			T lik = a(i, k) / pv;
+			a(i, k) = lik;
+			if (a.IsRowContiguous()) {
+				_axpy<T>(n - k - 1, -lik, &a(k, k + 1), &a(i, k + 1));
+			}
+			else {
+				for (uint64_t j = k + 1; j < n; ++j) {
+					a(i, j) -= lik * a(k, j);
+				}
+			}
+		}
+	}
+	return det;
+}
+
+// solves with the output of _lu_pivot_in_place, w is overwritten
+template<typename T>
+void _lu_pivot_solve(QMatrixView<const T> lu, const uint32_t* piv, T* w) {
+	uint64_t k = lu.GetN();
+	for (uint64_t i = 0; i < k; ++i) {
+		T t = w[i];
+		w[i] = w[piv[i]];
+		w[piv[i]] = t;
+	}
+	for (uint64_t i = 0; i < k; ++i) {
+		for (uint64_t j = 0; j < i; ++j) {
+			w[i] -= lu(i, j) * w[j];
+		}
+	}
+	for (uint64_t i = k; i-- > 0;) {
+		for (uint64_t j = i + 1; j < k; ++j) {
+			w[i] -= lu(i, j) * w[j];
+		}
+		w[i] /= lu(i, i);
+	}
+}
+
+// power iteration on A^H A from a fixed start vector, in double precision
+template<typename T>
+double QMatrix<T>::OpNorm() const noexcept {
+    using D = DetType;
+    if (n == 0 || m == 0) {
+        return 0.0;
+    }
+
+    std::vector<D> x(SAFE_UINT(m)), y(SAFE_UINT(n));
+    for (uint64_t j = 0; j < m; ++j) {
+        x[j] = static_cast<D>(1.0 + static_cast<double>(j) / (2.0 * static_cast<double>(m)));
+    }
+
+    double sigma = 0.0;
+    for (int it = 0; it < 1000; ++it) {
+        double xn = 0.0;
+        for (const D& e : x) {
+            xn += std::norm(e);
+        }
+        xn = std::sqrt(xn);
+        if (xn == 0.0) {
+            return 0.0;
+        }
+
+        // y = A x / |x|, |y| grows towards the norm from below
+        double yn = 0.0;
+        for (uint64_t i = 0; i < n; ++i) {
+            D acc = static_cast<D>(0);
+            for (uint64_t j = 0; j < m; ++j) {
+                acc += static_cast<D>(data[i * m + j]) * x[j];
+            }
+            y[i] = acc / xn;
+            yn += std::norm(y[i]);
+        }
+        yn = std::sqrt(yn);
+
+        // x = A^H y
+        std::fill(x.begin(), x.end(), static_cast<D>(0));
+        for (uint64_t i = 0; i < n; ++i) {
+            for (uint64_t j = 0; j < m; ++j) {
+                D aij = static_cast<D>(data[i * m + j]);
+                if constexpr (_is_complex<D>::value) {
+                    aij = std::conj(aij);
+                }
+                x[j] += aij * y[i];
+            }
+        }
+
+        bool done = std::fabs(yn - sigma) <= 1e-15 * yn;
+        sigma = yn;
+        if (done) {
+            break;
+        }
+    }
+    return sigma;
+}
+
 template<typename T>
 SQUARE
-double QMatrix<T>::Det() const noexcept {
+typename QMatrix<T>::DetType QMatrix<T>::Det() const noexcept {
     if (!IsSquare()) {
         merror("Cannot calculate determinant of non-square matrix!", E_MAT_INVALID_DIMENSION);
-        return static_cast<T>(0);
+        return static_cast<DetType>(0);
     }
 
-    double detU = 1, detL = 1;
-    std::array<QMatrix<T>, 2> decomp = this->DecomposeLU();
-    for (size_t i = 0; i < GetN(); ++i) {
-        DEREF_TRY(detL *= decomp[0][i][i]);
-        DEREF_TRY(detU *= decomp[1][i][i]);
+    // partial pivoting on a DetType copy: integers are not truncated and a zero leading pivot is fine
+    std::vector<DetType> lu(SAFE_UINT(n * n));
+    for (uint64_t i = 0; i < n * n; ++i) {
+        lu[i] = static_cast<DetType>(data[i]);
     }
-
-    return detL * detU;
-
+    std::vector<uint32_t> piv(SAFE_UINT(n));
+    return _lu_pivot_in_place<DetType>(QMatrixView<DetType>::Of(lu.data(), n, n, Layout::RowMajor), piv.data());
 }
 
 template<typename T>
 SQUARE
 std::array<QMatrix<T>, 2> QMatrix<T>::DecomposeLU() const {
     
-    auto a = *this;
-    if (!a.IsSquare()) {
+    if (!IsSquare()) {
         merror("Cannot apply LU-decomposition to non-square matrix!", E_MAT_INVALID_DIMENSION);
+        return std::array<QMatrix<T>, 2> {*this, *this};
     }
 
-    uint64_t n = a.GetN();
-
-    T* _tmp_nums = nullptr;
-    ALLOC_TRY(_tmp_nums = new T[SAFE_UINT(n * n)]);
-    memset(_tmp_nums, 0, SAFE_UINT(sizeof(T) * SAFE_UINT(n * n)));
-
-    QMatrix<T> l(_tmp_nums, n, n);
-    QMatrix<T> u(_tmp_nums, n, n);
+    uint64_t n = GetN();
 
-    _tmp_nums = nullptr;
+    // the factors of an integer matrix are not integers
+    if constexpr (std::is_integral_v<T>) {
+        merror("Cannot store LU-decomposition of an integer matrix, convert to a floating point type!", WARN);
+        QMatrix<T> id = *this;
+        for (size_t i = 0; i < n * n; i++) {
+            id.data[i] = i % (n + 1) == 0 ? 1 : 0;
+        }
+        return std::array<QMatrix<T>, 2> {id, *this};
+    }
 
-    size_t i = 0, j = 0, k = 0;
-    for (i = 0; i < n; i++) {
-        for (j = 0; j < n; j++) {
-            if (j < i)
-                l.data[j * n + i] = 0;
-            else {
-                l.data[j * n + i] = a[j][i];
-                for (k = 0; k < i; k++) {
-                    l.data[i * n + j] = l[j][i] - l[j][k] * u[k][i];
-                }
-            }
+    /*
+        P A = L' U' with partial pivoting, rescaled to the Crout form L' D, D^-1 U'
+        (L lower, U unit upper) and P folded into L, so that A = L U with L a row
+        permutation of a lower triangle.
+    */
+    QMatrix<T> lu = *this;
+    std::vector<uint32_t> piv(SAFE_UINT(n));
+    _lu_pivot_in_place<T>(lu.View(), piv.data());
+
+    QMatrix<T> l = lu;
+    QMatrix<T> u = lu;
+
+    bool regular = true;
+    for (size_t i = 0; i < n; i++) {
+        T d = lu.data[i * n + i];
+        if (d == static_cast<T>(0)) {
+            regular = false;
         }
+        for (size_t j = 0; j < n; j++) {
+            if (j > i)
+                l.data[i * n + j] = 0;
+            else if (j == i)
+                l.data[i * n + j] = d;
+            else
+                l.data[i * n + j] = lu.data[i * n + j] * lu.data[j * n + j];
 
-        for (j = 0; j < n; j++) {
             if (j < i)
                 u.data[i * n + j] = 0;
             else if (j == i)
                 u.data[i * n + j] = 1;
-            else {
-                u.data[i * n + j] = a[i][j] / l[i][i];
-                for (k = 0; k < i; k++) {
-                    u.data[i * n + j] = u[i][j] - ((l[i][k] * u[k][j]) / l[i][i]);
-                }
-            }
+            else if (d != static_cast<T>(0))
+                u.data[i * n + j] = lu.data[i * n + j] / d;
+        }
+    }
+    if (!regular) {
+        merror("Zero pivot in LU-decomposition!", SEVERE);
+    }
+
+    // undo the row swaps on L, last one first
+    for (size_t k = n; k-- > 0;) {
+        if (piv[k] != k) {
+            std::swap_ranges(l.data + k * n, l.data + (k + 1) * n, l.data + piv[k] * n);
         }
     }
 
@@ -293,7 +549,7 @@ QMatrix<T> operator+(const QMatrix<T>& left, const QMatrix<T>& right) {
     QMatrix<T> res = left;
     for (size_t i = 0; i < n; ++i) {
         for (size_t j = 0; j < m; ++j) {
-            DEREF_TRY(res.data[i * m + j] = left[i][j] + right[i][j]);
+            res.data[i * m + j] = left.data[i * m + j] + right.data[i * m + j];
         }
     }
 
@@ -314,7 +570,7 @@ QMatrix<T> operator-(const QMatrix<T>& left, const QMatrix<T>& right) {
     QMatrix<T> res = left;
     for (size_t i = 0; i < n; ++i) {
         for (size_t j = 0; j < m; ++j) {
-            DEREF_TRY(res.data[i * m + j] = left[i][j] - right[i][j]);
+            res.data[i * m + j] = left.data[i * m + j] - right.data[i * m + j];
         }
     }
 
@@ -323,32 +579,22 @@ QMatrix<T> operator-(const QMatrix<T>& left, const QMatrix<T>& right) {
 
 template<typename T>
 QMatrix<T> operator*(const QMatrix<T>& left, const QMatrix<T>& right) {
-    if (left.GetN() != right.GetN() || left.GetM() != right.GetM()) {
+    if (left.GetM() != right.GetN()) {
         merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
         return left;
     }
 
     uint64_t n = left.GetN();
     uint64_t m = right.GetM();
-    uint64_t p = left.GetM();
 
     T* _tmp_nums = nullptr;
-    ALLOC_TRY(_tmp_nums = new T[SAFE_UINT(n * m)]);
-    memset(_tmp_nums, 0, SAFE_UINT(sizeof(T) * SAFE_UINT(n * m)));
+    ALLOC_TRY(_tmp_nums = new T[SAFE_UINT(n * m)]());
 
     QMatrix<T> res(_tmp_nums, n, m);
+    delete[] _tmp_nums;
     _tmp_nums = nullptr;
 
-    for (size_t i = 0; i < n; ++i) {
-        for (size_t j = 0; j < m; ++j) {
-            T part_sum = 0;
-            for (size_t k = 0; k < p; ++k) {
-                //DEREF_TRY(part_sum += left[i][k] * right[k][j]);
-                part_sum += left.data[i * m + j] * right.data[k * m + j];
-            }
-            res.data[SAFE_UINT(i * m + j)] = part_sum;
-        }
-    }
+    Gemm<T>(left.View(), right.View(), res.View());
 
     return res;
 }
@@ -405,15 +651,13 @@ template<typename T>
 SQUARE
 QMatrix<T> I(uint64_t n) {
     T* _tmp_nums = nullptr;
-    ALLOC_TRY(_tmp_nums = new T[SAFE_UINT(n * n)]);
-    memset(_tmp_nums, 0, SAFE_UINT(sizeof(T) * SAFE_UINT(n * n)));
-
-
+    ALLOC_TRY(_tmp_nums = new T[SAFE_UINT(n * n)]());
 
     QMatrix<T> res(_tmp_nums, n, n);
     for (size_t i = 0; i < n; ++i) {
         res.data[SAFE_UINT(i * n + i)] = static_cast<T>(1);
     }
+    delete[] _tmp_nums;
     _tmp_nums = nullptr;
 
     return res;
@@ -426,7 +670,7 @@ std::ostream& operator<<(std::ostream& os, const QMatrix<T>& mat) {
     os << n << " x " << m << " matrix\n";
     for (size_t i = 0; i < n; ++i) {
         for (size_t j = 0; j < m; ++j) {
-            os << mat[i][j] << " ";
+            os << mat.GetItem(i, j) << " ";
         }
         os << "\n";
     }
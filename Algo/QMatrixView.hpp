@@ -0,0 +1,401 @@
+#ifndef _QMATRIX_VIEW_H
+#define _QMATRIX_VIEW_H
+
+#include "MatrixError.hpp"
+#include "Kernels.hpp"
+#include "LowPrecision.hpp"
+#include <stdint.h>
+#include <complex>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/*
+	Non-owning strided view over matrix data.
+
+	Element (i, j) lives at data[i * row_stride + j * col_stride], which covers
+	row-major and column-major storage with any leading dimension, submatrices
+	and transposes (swapping the strides) without copying anything.
+*/
+
+template<typename T> struct _is_complex : std::false_type {};
+template<typename T> struct _is_complex<std::complex<T>> : std::true_type {};
+
+template<typename T>
+T _conj(const T& x) {
+	if constexpr (_is_complex<T>::value) {
+		return std::conj(x);
+	}
+	else {
+		return x;
+	}
+}
+
+enum class Layout {
+	RowMajor,
+	ColMajor
+};
+
+template<typename T>
+class QMatrixView {
+public:
+	QMatrixView(T* data, uint64_t n, uint64_t m, int64_t row_stride, int64_t col_stride) :
+		data(data), n(n), m(m), row_stride(row_stride), col_stride(col_stride) {}
+
+	// a view over const data can always be made from a mutable one
+	template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+	QMatrixView(const QMatrixView<U>& other) :
+		data(other.Data()), n(other.GetN()), m(other.GetM()),
+		row_stride(other.RowStride()), col_stride(other.ColStride()) {}
+
+	static QMatrixView<T> Of(T* data, uint64_t n, uint64_t m, Layout layout, uint64_t ld = 0) {
+		if (layout == Layout::RowMajor) {
+			return QMatrixView<T>(data, n, m, SAFE_INT(ld == 0 ? m : ld), 1);
+		}
+		return QMatrixView<T>(data, n, m, 1, SAFE_INT(ld == 0 ? n : ld));
+	}
+
+	T& operator()(uint64_t i, uint64_t j) const {
+		return data[SAFE_INT(i) * row_stride + SAFE_INT(j) * col_stride];
+	}
+
+	T* Data() const noexcept { return data; }
+	uint64_t GetN() const noexcept { return n; }
+	uint64_t GetM() const noexcept { return m; }
+	int64_t RowStride() const noexcept { return row_stride; }
+	int64_t ColStride() const noexcept { return col_stride; }
+
+	// rows are contiguous (row-major with leading dimension RowStride())
+	bool IsRowContiguous() const noexcept { return col_stride == 1 || m <= 1; }
+	// columns are contiguous (column-major with leading dimension ColStride())
+	bool IsColContiguous() const noexcept { return row_stride == 1 || n <= 1; }
+
+	QMatrixView<T> Transposed() const noexcept {
+		return QMatrixView<T>(data, m, n, col_stride, row_stride);
+	}
+
+	QMatrixView<T> Sub(uint64_t i0, uint64_t j0, uint64_t rows, uint64_t cols) const {
+		if (i0 + rows > n || j0 + cols > m) {
+			merror("Submatrix view exceeds the parent matrix!", E_MAT_INVALID_DIMENSION);
+			return QMatrixView<T>(data, 0, 0, row_stride, col_stride);
+		}
+		return QMatrixView<T>(&(*this)(i0, j0), rows, cols, row_stride, col_stride);
+	}
+
+	QMatrixView<T> Row(uint64_t i) const { return Sub(i, 0, 1, m); }
+	QMatrixView<T> Col(uint64_t j) const { return Sub(0, j, n, 1); }
+
+private:
+	T* data;
+	uint64_t n, m;
+	int64_t row_stride, col_stride;
+};
+
+template<typename T>
+using ConstQMatrixView = QMatrixView<const T>;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define TRANSPOSE_LEAF 32
+
+// cache-oblivious copy: halve the longer side until the block fits in cache,
+// so a layout change (or a transpose) touches every line of src and dst only once
+template<typename T>
+void Copy(QMatrixView<const std::remove_const_t<T>> src, QMatrixView<T> dst) {
+	if (src.GetN() != dst.GetN() || src.GetM() != dst.GetM()) {
+		merror("Cannot copy between views with different dimensions!", E_MAT_INVALID_DIMENSION);
+		return;
+	}
+
+	uint64_t n = src.GetN();
+	uint64_t m = src.GetM();
+
+	if (n <= TRANSPOSE_LEAF && m <= TRANSPOSE_LEAF) {
+		if (dst.IsRowContiguous() || !dst.IsColContiguous()) {
+			for (uint64_t i = 0; i < n; ++i) {
+				for (uint64_t j = 0; j < m; ++j) {
+					dst(i, j) = src(i, j);
+				}
+			}
+		}
+		else {
+			for (uint64_t j = 0; j < m; ++j) {
+				for (uint64_t i = 0; i < n; ++i) {
+					dst(i, j) = src(i, j);
+				}
+			}
+		}
+		return;
+	}
+
+	if (n >= m) {
+		uint64_t h = n / 2;
+		Copy<T>(src.Sub(0, 0, h, m), dst.Sub(0, 0, h, m));
+		Copy<T>(src.Sub(h, 0, n - h, m), dst.Sub(h, 0, n - h, m));
+	}
+	else {
+		uint64_t h = m / 2;
+		Copy<T>(src.Sub(0, 0, n, h), dst.Sub(0, 0, n, h));
+		Copy<T>(src.Sub(0, h, n, m - h), dst.Sub(0, h, n, m - h));
+	}
+}
+
+// dst = src^T, dst must be m x n
+template<typename T>
+void Transpose(QMatrixView<const std::remove_const_t<T>> src, QMatrixView<T> dst) {
+	Copy<T>(src.Transposed(), dst);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define GEMM_VIEW_KC 128
+
+// y += a * x (a * conj(x) with conj_x), through the dispatched kernels where one exists
+template<typename T>
+void _axpy(uint64_t n, T a, const T* x, T* y, bool conj_x = false) {
+	if constexpr (std::is_same_v<T, float>) {
+		Kernels().saxpy(n, a, x, y);
+	}
+	else if constexpr (std::is_same_v<T, double>) {
+		Kernels().daxpy(n, a, x, y);
+	}
+	else if constexpr (std::is_same_v<T, std::complex<float>>) {
+		Kernels().caxpy(n, reinterpret_cast<const float*>(&a), reinterpret_cast<const float*>(x),
+			reinterpret_cast<float*>(y), conj_x);
+	}
+	else if constexpr (std::is_same_v<T, std::complex<double>>) {
+		Kernels().zaxpy(n, reinterpret_cast<const double*>(&a), reinterpret_cast<const double*>(x),
+			reinterpret_cast<double*>(y), conj_x);
+	}
+	else {
+		for (uint64_t i = 0; i < n; ++i) {
+			y[i] += a * (conj_x ? _conj(x[i]) : x[i]);
+		}
+	}
+}
+
+// x . y (conj(x) . y with conj_x)
+template<typename T>
+T _dot(uint64_t n, const T* x, const T* y, bool conj_x = false) {
+	if constexpr (std::is_same_v<T, float>) {
+		return Kernels().sdot(n, x, y);
+	}
+	else if constexpr (std::is_same_v<T, double>) {
+		return Kernels().ddot(n, x, y);
+	}
+	else if constexpr (std::is_same_v<T, std::complex<float>>) {
+		T res;
+		Kernels().cdot(n, reinterpret_cast<const float*>(x), reinterpret_cast<const float*>(y), conj_x,
+			reinterpret_cast<float*>(&res));
+		return res;
+	}
+	else if constexpr (std::is_same_v<T, std::complex<double>>) {
+		T res;
+		Kernels().zdot(n, reinterpret_cast<const double*>(x), reinterpret_cast<const double*>(y), conj_x,
+			reinterpret_cast<double*>(&res));
+		return res;
+	}
+	else {
+		T res = static_cast<T>(0);
+		for (uint64_t i = 0; i < n; ++i) {
+			res += (conj_x ? _conj(x[i]) : x[i]) * y[i];
+		}
+		return res;
+	}
+}
+
+// x . y summed in _acc_type_t<T>, through the widening kernels for the low-precision types
+template<typename T>
+_acc_type_t<T> _dot_wide(uint64_t n, const T* x, const T* y) {
+	if constexpr (std::is_same_v<T, int8_t>) {
+		return Kernels().dot_i8(n, x, y);
+	}
+	else if constexpr (std::is_same_v<T, int16_t>) {
+		return Kernels().dot_i16(n, x, y);
+	}
+	else if constexpr (std::is_same_v<T, Half>) {
+		return Kernels().dot_f16(n, reinterpret_cast<const uint16_t*>(x), reinterpret_cast<const uint16_t*>(y));
+	}
+	else if constexpr (std::is_same_v<T, BFloat16>) {
+		return Kernels().dot_bf16(n, reinterpret_cast<const uint16_t*>(x), reinterpret_cast<const uint16_t*>(y));
+	}
+	else {
+		_acc_type_t<T> res = static_cast<_acc_type_t<T>>(0);
+		for (uint64_t i = 0; i < n; ++i) {
+			res += static_cast<_acc_type_t<T>>(x[i]) * static_cast<_acc_type_t<T>>(y[i]);
+		}
+		return res;
+	}
+}
+
+#define GEMM_WIDE_NB 64
+
+/*
+	c = a * b with the products summed in _acc_type_t<T> (int32 for int8/int16, fp32
+	for fp16/bf16). c is either that accumulator type, to keep the full result, or T,
+	in which case every entry is narrowed once at the end.
+
+	b is transposed into a packed buffer once so both operands of every entry are
+	contiguous runs for the dot kernels, and GEMM_WIDE_NB columns of it are kept hot
+	while all rows of a stream past them.
+*/
+template<typename T, typename R>
+void GemmWide(QMatrixView<const T> a, QMatrixView<const T> b, QMatrixView<R> c) {
+	if (a.GetM() != b.GetN() || c.GetN() != a.GetN() || c.GetM() != b.GetM()) {
+		merror("Cannot multiply views with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+		return;
+	}
+
+	uint64_t n = a.GetN();
+	uint64_t m = b.GetM();
+	uint64_t p = a.GetM();
+
+	std::vector<T> _tmp_bt(SAFE_UINT(m * p));
+	Copy<T>(b.Transposed(), QMatrixView<T>::Of(_tmp_bt.data(), m, p, Layout::RowMajor));
+
+	std::vector<T> _tmp_a;
+	const T* _a_base = a.Data();
+	int64_t lda = a.RowStride();
+	if (!a.IsRowContiguous() || lda < 0) {
+		_tmp_a.resize(SAFE_UINT(n * p));
+		Copy<T>(a, QMatrixView<T>::Of(_tmp_a.data(), n, p, Layout::RowMajor));
+		_a_base = _tmp_a.data();
+		lda = SAFE_INT(p);
+	}
+
+	for (uint64_t jj = 0; jj < m; jj += GEMM_WIDE_NB) {
+		uint64_t jn = m - jj < GEMM_WIDE_NB ? m - jj : GEMM_WIDE_NB;
+		for (uint64_t i = 0; i < n; ++i) {
+			const T* _a_row = _a_base + SAFE_INT(i) * lda;
+			for (uint64_t j = jj; j < jj + jn; ++j) {
+				c(i, j) = _narrow<R>(_dot_wide<T>(p, _a_row, _tmp_bt.data() + j * p));
+			}
+		}
+	}
+}
+
+/*
+	c = a * b on arbitrary views.
+
+	The layouts are matched to a kernel instead of being converted:
+	  - c column-major: solve c^T = b^T * a^T, which is row-major again
+	  - a, b, c row-major: dispatched blocked GEMM
+	  - b, c row-major: axpy over rows of b (covers a^T * b)
+	  - a row-major, b column-major: dot of rows of a with columns of b (covers a * b^T)
+	  - anything else: b is packed one k-panel at a time and the axpy path is used
+	  - int8/int16/fp16/bf16: GemmWide, accumulating wide and narrowing once
+
+	conj_a / conj_b use the complex conjugate of that operand, so together with
+	Transposed() the conjugate transpose (a^H * b, a * b^H) is a view as well.
+*/
+template<typename T>
+void Gemm(QMatrixView<const std::remove_const_t<T>> a, QMatrixView<const std::remove_const_t<T>> b, QMatrixView<T> c,
+	bool conj_a = false, bool conj_b = false) {
+	if (a.GetM() != b.GetN() || c.GetN() != a.GetN() || c.GetM() != b.GetM()) {
+		merror("Cannot multiply views with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+		return;
+	}
+
+	uint64_t n = a.GetN();
+	uint64_t m = b.GetM();
+	uint64_t p = a.GetM();
+
+	if (!c.IsRowContiguous() && c.IsColContiguous()) {
+		Gemm<T>(b.Transposed(), a.Transposed(), c.Transposed(), conj_b, conj_a);
+		return;
+	}
+
+	if constexpr (_is_low_precision<T>::value) {
+		GemmWide<T, T>(a, b, c);
+		return;
+	}
+
+	if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+		if (a.IsRowContiguous() && b.IsRowContiguous() && c.IsRowContiguous()
+			&& a.RowStride() > 0 && b.RowStride() > 0 && c.RowStride() > 0) {
+			if constexpr (std::is_same_v<T, float>) {
+				Kernels().sgemm(n, m, p, a.Data(), a.RowStride(), b.Data(), b.RowStride(), c.Data(), c.RowStride());
+			}
+			else {
+				Kernels().dgemm(n, m, p, a.Data(), a.RowStride(), b.Data(), b.RowStride(), c.Data(), c.RowStride());
+			}
+			return;
+		}
+	}
+
+	if (c.IsRowContiguous() && a.IsRowContiguous() && b.IsColContiguous() && !b.IsRowContiguous()) {
+		for (uint64_t i = 0; i < n; ++i) {
+			const T* _a_row = &a(i, 0);
+			for (uint64_t j = 0; j < m; ++j) {
+				const T* _b_col = &b(0, j);
+				if (conj_b && conj_a) {
+					c(i, j) = _conj(_dot<T>(p, _a_row, _b_col));
+				}
+				else if (conj_b) {
+					c(i, j) = _dot<T>(p, _b_col, _a_row, true);
+				}
+				else {
+					c(i, j) = _dot<T>(p, _a_row, _b_col, conj_a);
+				}
+			}
+		}
+		return;
+	}
+
+	for (uint64_t i = 0; i < n; ++i) {
+		for (uint64_t j = 0; j < m; ++j) {
+			c(i, j) = static_cast<T>(0);
+		}
+	}
+
+	std::vector<T> _panel;
+	std::vector<T> _c_row;
+	if (!c.IsRowContiguous()) {
+		_c_row.resize(SAFE_UINT(m));
+	}
+
+	for (uint64_t kk = 0; kk < p; kk += GEMM_VIEW_KC) {
+		uint64_t kc = p - kk < GEMM_VIEW_KC ? p - kk : GEMM_VIEW_KC;
+
+		QMatrixView<const T> _b_blk = b.Sub(kk, 0, kc, m);
+		const T* _b_base = nullptr;
+		int64_t ldb = 0;
+		if (_b_blk.IsRowContiguous()) {
+			_b_base = _b_blk.Data();
+			ldb = _b_blk.RowStride();
+		}
+		else {
+			_panel.resize(SAFE_UINT(kc * m));
+			Copy<T>(_b_blk, QMatrixView<T>::Of(_panel.data(), kc, m, Layout::RowMajor));
+			_b_base = _panel.data();
+			ldb = SAFE_INT(m);
+		}
+
+		for (uint64_t i = 0; i < n; ++i) {
+			T* _dst = nullptr;
+			if (c.IsRowContiguous()) {
+				_dst = &c(i, 0);
+			}
+			else {
+				for (uint64_t j = 0; j < m; ++j) {
+					_c_row[j] = c(i, j);
+				}
+				_dst = _c_row.data();
+			}
+
+			for (uint64_t k = 0; k < kc; ++k) {
+				T _a_ik = conj_a ? _conj(a(i, kk + k)) : a(i, kk + k);
+				_axpy<T>(m, _a_ik, _b_base + SAFE_INT(k) * ldb, _dst, conj_b);
+			}
+
+			if (!c.IsRowContiguous()) {
+				for (uint64_t j = 0; j < m; ++j) {
+					c(i, j) = _c_row[j];
+				}
+			}
+		}
+	}
+}
+
+#endif
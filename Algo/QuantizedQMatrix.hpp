@@ -0,0 +1,179 @@
+#ifndef _QUANTIZED_QMATRIX_H
+#define _QUANTIZED_QMATRIX_H
+
+#include "LowPrecision.hpp"
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include <stdint.h>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/*
+	Symmetric int8/int16 quantization of float matrices.
+
+	x ~ scale * q with q in [-qmax, qmax], qmax = 2^(bits-1) - 1, one scale for the
+	whole matrix or one per row. QuantizedGemm multiplies against the transposed
+	right-hand side (one row per output column, the usual weight layout) so the
+	row scales of both operands factor out of every int32 dot product.
+
+	int32 accumulation is exact while k * qmax_a * qmax_b < 2^31 for a run of k
+	products. That is ~130k products for int8 but only 2 for full 16-bit values, so
+	int16 quantizes to 12 bits by default (512 products per run) and QuantizedGemm
+	splits longer inner dimensions into runs that it sums in int64.
+
+	fp16/bf16 need no scales: ConvertQMatrix<Half>(a) / ConvertQMatrix<BFloat16>(a)
+	and back with ConvertQMatrix<float>.
+*/
+
+enum class QuantScale {
+	PerTensor,
+	PerRow
+};
+
+template<typename Q>
+class QuantizedQMatrix {
+	static_assert(std::is_same_v<Q, int8_t> || std::is_same_v<Q, int16_t>,
+		"Quantized matrices hold int8_t or int16_t");
+
+public:
+	QuantizedQMatrix(QMatrix<Q> values, std::vector<float> scales, QuantScale mode,
+		int32_t qmax = std::numeric_limits<Q>::max())
+		: values(std::move(values)), scales(std::move(scales)), mode(mode), qmax(qmax) {
+		uint64_t expected = mode == QuantScale::PerRow ? this->values.GetN() : 1;
+		if (this->scales.size() != expected) {
+			merror("Quantization scale count does not match the scale mode!", E_MAT_INVALID_DIMENSION);
+			this->scales.resize(SAFE_UINT(expected), 1.0f);
+		}
+	}
+
+	uint64_t GetN() const noexcept { return values.GetN(); }
+	uint64_t GetM() const noexcept { return values.GetM(); }
+	const QMatrix<Q>& Values() const noexcept { return values; }
+	QuantScale Mode() const noexcept { return mode; }
+	float Scale(uint64_t row) const { return mode == QuantScale::PerRow ? scales[row] : scales[0]; }
+	int32_t QMax() const noexcept { return qmax; }
+
+private:
+	QMatrix<Q> values;
+	std::vector<float> scales;
+	QuantScale mode;
+	int32_t qmax;
+};
+
+template<typename Q>
+constexpr uint32_t _default_quant_bits() {
+	return std::is_same_v<Q, int16_t> ? 12 : 8 * sizeof(Q);
+}
+
+template<typename To, typename From>
+QMatrix<To> ConvertQMatrix(const QMatrix<From>& a) {
+	std::vector<To> _tmp_nums(SAFE_UINT(a.GetN() * a.GetM()));
+	QMatrixView<const From> v = a.View();
+	for (uint64_t i = 0; i < a.GetN(); ++i) {
+		for (uint64_t j = 0; j < a.GetM(); ++j) {
+			_tmp_nums[i * a.GetM() + j] = static_cast<To>(static_cast<float>(v(i, j)));
+		}
+	}
+	return QMatrix<To>(_tmp_nums.data(), a.GetN(), a.GetM());
+}
+
+template<typename Q>
+QuantizedQMatrix<Q> Quantize(const QMatrix<float>& a, QuantScale mode = QuantScale::PerRow,
+	uint32_t bits = _default_quant_bits<Q>()) {
+	if (bits < 2 || bits > 8 * sizeof(Q)) {
+		merror("Quantization bit width does not fit the element type!", WARN);
+		bits = _default_quant_bits<Q>();
+	}
+	const int32_t _qmax = static_cast<int32_t>((1u << (bits - 1)) - 1);
+	const float qmax = static_cast<float>(_qmax);
+	uint64_t n = a.GetN();
+	uint64_t m = a.GetM();
+	QMatrixView<const float> v = a.View();
+
+	std::vector<float> scales(mode == QuantScale::PerRow ? SAFE_UINT(n) : 1, 0.0f);
+	for (uint64_t i = 0; i < n; ++i) {
+		float& s = scales[mode == QuantScale::PerRow ? i : 0];
+		for (uint64_t j = 0; j < m; ++j) {
+			s = std::fmax(s, std::fabs(v(i, j)));
+		}
+	}
+	for (float& s : scales) {
+		s = s > 0.0f ? s / qmax : 1.0f;
+	}
+
+	std::vector<Q> _tmp_nums(SAFE_UINT(n * m));
+	for (uint64_t i = 0; i < n; ++i) {
+		float inv = 1.0f / scales[mode == QuantScale::PerRow ? i : 0];
+		for (uint64_t j = 0; j < m; ++j) {
+			float q = std::nearbyint(v(i, j) * inv);
+			q = std::fmin(std::fmax(q, -qmax), qmax);
+			_tmp_nums[i * m + j] = static_cast<Q>(q);
+		}
+	}
+	return QuantizedQMatrix<Q>(QMatrix<Q>(_tmp_nums.data(), n, m), std::move(scales), mode, _qmax);
+}
+
+template<typename Q>
+QMatrix<float> Dequantize(const QuantizedQMatrix<Q>& q) {
+	uint64_t n = q.GetN();
+	uint64_t m = q.GetM();
+	QMatrixView<const Q> v = q.Values().View();
+	std::vector<float> _tmp_nums(SAFE_UINT(n * m));
+	for (uint64_t i = 0; i < n; ++i) {
+		float s = q.Scale(i);
+		for (uint64_t j = 0; j < m; ++j) {
+			_tmp_nums[i * m + j] = s * static_cast<float>(v(i, j));
+		}
+	}
+	return QMatrix<float>(_tmp_nums.data(), n, m);
+}
+
+// a * bt^T in float, a is n x p and bt is m x p
+template<typename Q>
+QMatrix<float> QuantizedGemm(const QuantizedQMatrix<Q>& a, const QuantizedQMatrix<Q>& bt) {
+	if (a.GetM() != bt.GetM()) {
+		merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+		return Dequantize(a);
+	}
+
+	uint64_t n = a.GetN();
+	uint64_t m = bt.GetN();
+	uint64_t p = a.GetM();
+
+	// longest run of products that cannot overflow the int32 accumulator
+	uint64_t _max_prod = static_cast<uint64_t>(a.QMax()) * static_cast<uint64_t>(bt.QMax());
+	uint64_t run = _max_prod == 0 ? p : static_cast<uint64_t>(std::numeric_limits<int32_t>::max()) / _max_prod;
+	run = run == 0 ? 1 : run;
+
+	std::vector<int32_t> _tmp_acc(SAFE_UINT(n * m));
+	std::vector<int64_t> _tmp_sum;
+	QMatrixView<const Q> av = a.Values().View();
+	QMatrixView<const Q> bv = bt.Values().View();
+	for (uint64_t kk = 0; kk < p; kk += run) {
+		uint64_t kc = p - kk < run ? p - kk : run;
+		GemmWide<Q, int32_t>(av.Sub(0, kk, n, kc), bv.Sub(0, kk, m, kc).Transposed(),
+			QMatrixView<int32_t>::Of(_tmp_acc.data(), n, m, Layout::RowMajor));
+		if (kc == p) {
+			break;
+		}
+		_tmp_sum.resize(SAFE_UINT(n * m), 0);
+		for (uint64_t i = 0; i < n * m; ++i) {
+			_tmp_sum[i] += _tmp_acc[i];
+		}
+	}
+
+	std::vector<float> _tmp_nums(SAFE_UINT(n * m));
+	for (uint64_t i = 0; i < n; ++i) {
+		float sa = a.Scale(i);
+		for (uint64_t j = 0; j < m; ++j) {
+			float acc = _tmp_sum.empty() ? static_cast<float>(_tmp_acc[i * m + j]) : static_cast<float>(_tmp_sum[i * m + j]);
+			_tmp_nums[i * m + j] = sa * bt.Scale(j) * acc;
+		}
+	}
+	return QMatrix<float>(_tmp_nums.data(), n, m);
+}
+
+#endif
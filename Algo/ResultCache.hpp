@@ -0,0 +1,308 @@
+#ifndef _RESULT_CACHE_H
+#define _RESULT_CACHE_H
+
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include <stdint.h>
+#include <array>
+#include <cstring>
+#include <cstdlib>
+#include <exception>
+#include <future>
+#include <initializer_list>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Process-wide cache of results of QMatrix operations.
+
+	Entries are keyed by the operation, the result type and the content hashes of
+	the operands (QMatrix::Hash()), and keep a copy of the operands. A hit is only
+	served once the operands compare equal byte for byte, so hash collisions cost
+	a recomputation, never a wrong result. The same holds for a stale Hash()
+	after writes through an older view. Concurrent requests for the same key
+	share one computation: the first one computes, the others wait for it.
+
+	The cache holds at most Capacity() bytes of operands and results and evicts the
+	least recently used entries past that. The shared instance is sized by the
+	KALGEBRA_CACHE_MB environment variable, RESULT_CACHE_MB by default.
+*/
+
+#define RESULT_CACHE_MB 256
+
+enum class CacheOp : uint32_t {
+	Det = 1,
+	DecomposeLU = 2,
+	Product = 3,
+	// first id for operations defined outside the library
+	User = 1024
+};
+
+// bytes held by a cached result
+template<typename R>
+uint64_t _result_bytes(const R&) {
+	return sizeof(R);
+}
+
+template<typename T>
+uint64_t _result_bytes(const QMatrix<T>& r) {
+	return sizeof(QMatrix<T>) + r.GetN() * r.GetM() * sizeof(T);
+}
+
+template<typename T, size_t N>
+uint64_t _result_bytes(const std::array<QMatrix<T>, N>& r) {
+	uint64_t res = 0;
+	for (const QMatrix<T>& q : r) {
+		res += _result_bytes(q);
+	}
+	return res;
+}
+
+class ResultCache {
+public:
+	explicit ResultCache(uint64_t max_bytes = SAFE_UINT(RESULT_CACHE_MB) << 20) : capacity(max_bytes), bytes(0), hits(0), misses(0) {}
+
+	ResultCache(const ResultCache&) = delete;
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	/*
+		Result of compute() for these operands, computed at most once while the
+		entry stays cached. compute has to return R and may throw, in which case
+		nothing is cached and waiting callers see the exception too.
+	*/
+	template<typename R, typename T, typename F>
+	R GetOrCompute(CacheOp op, std::initializer_list<const QMatrix<T>*> operands, F compute) {
+		std::vector<const QMatrix<T>*> probe(operands);
+		uint64_t key = (static_cast<uint64_t>(op) * 0x9E3779B185EBCA87ull) ^ typeid(R).hash_code();
+		for (const QMatrix<T>* a : probe) {
+			key = (key ^ a->Hash()) * 0xC2B2AE3D27D4EB4Full + 0x165667B19E3779F9ull;
+		}
+
+		std::shared_future<std::shared_ptr<const void>> result;
+		if (_find<R, T>(key, op, probe, result)) {
+			return *static_cast<const R*>(result.get().get());
+		}
+
+		// copied outside the lock, then looked up again in case another caller got there first
+		auto entry = std::make_shared<Entry>();
+		entry->key = key;
+		entry->op = op;
+		entry->type = &typeid(R);
+		auto stored = std::make_shared<std::vector<QMatrix<T>>>();
+		stored->reserve(probe.size());
+		for (const QMatrix<T>* a : probe) {
+			stored->push_back(*a);
+			entry->bytes += _result_bytes(*a);
+		}
+		entry->operands = stored;
+		entry->same = &_same_operands<T>;
+
+		std::promise<std::shared_ptr<const void>> done;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (_find_locked<R, T>(key, op, probe, result)) {
+				++hits;
+			}
+			else {
+				++misses;
+				entry->result = done.get_future().share();
+				lru.push_front(entry);
+				index.emplace(key, lru.begin());
+			}
+		}
+		if (result.valid()) {
+			return *static_cast<const R*>(result.get().get());
+		}
+
+		std::shared_ptr<const R> value;
+		try {
+			value = std::make_shared<const R>(compute());
+		}
+		catch (...) {
+			done.set_exception(std::current_exception());
+			std::lock_guard<std::mutex> lock(mutex);
+			_erase(entry);
+			throw;
+		}
+		done.set_value(value);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (entry->live) {
+				entry->bytes += _result_bytes(*value);
+				entry->counted = true;
+				bytes += entry->bytes;
+				_evict();
+			}
+		}
+		return *value;
+	}
+
+	uint64_t Capacity() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return capacity;
+	}
+	uint64_t Bytes() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return bytes;
+	}
+	uint64_t Size() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return lru.size();
+	}
+	uint64_t Hits() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return hits;
+	}
+	uint64_t Misses() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return misses;
+	}
+
+	void SetCapacity(uint64_t max_bytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+		capacity = max_bytes;
+		_evict();
+	}
+
+	// drops every entry, computations in flight still complete for their callers
+	void Clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (std::shared_ptr<Entry>& e : lru) {
+			e->live = false;
+		}
+		lru.clear();
+		index.clear();
+		bytes = 0;
+	}
+
+	static ResultCache& Shared() {
+		static ResultCache cache([] {
+			const char* env = std::getenv("KALGEBRA_CACHE_MB");
+			uint64_t mb = env != nullptr ? strtoull(env, nullptr, 10) : RESULT_CACHE_MB;
+			return mb << 20;
+		}());
+		return cache;
+	}
+
+private:
+	struct Entry {
+		uint64_t key = 0;
+		CacheOp op = CacheOp::User;
+		const std::type_info* type = nullptr;
+		std::shared_ptr<const void> operands;
+		bool (*same)(const void*, const void*) = nullptr;
+		std::shared_future<std::shared_ptr<const void>> result;
+		uint64_t bytes = 0;
+		// in the cache total, which only happens once the result is in
+		bool counted = false;
+		bool live = true;
+	};
+
+	using EntryList = std::list<std::shared_ptr<Entry>>;
+
+	template<typename T>
+	static bool _same_operands(const void* stored, const void* probe) {
+		const std::vector<QMatrix<T>>& s = *static_cast<const std::vector<QMatrix<T>>*>(stored);
+		const std::vector<const QMatrix<T>*>& p = *static_cast<const std::vector<const QMatrix<T>*>*>(probe);
+		if (s.size() != p.size()) {
+			return false;
+		}
+		for (size_t k = 0; k < s.size(); ++k) {
+			if (s[k].GetN() != p[k]->GetN() || s[k].GetM() != p[k]->GetM()
+				|| memcmp(s[k].View().Data(), p[k]->View().Data(), SAFE_UINT(s[k].GetN() * s[k].GetM() * sizeof(T))) != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename R, typename T>
+	bool _find(uint64_t key, CacheOp op, const std::vector<const QMatrix<T>*>& probe,
+		std::shared_future<std::shared_ptr<const void>>& result) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (_find_locked<R, T>(key, op, probe, result)) {
+			++hits;
+			return true;
+		}
+		return false;
+	}
+
+	// moves a matching entry to the front
+	template<typename R, typename T>
+	bool _find_locked(uint64_t key, CacheOp op, const std::vector<const QMatrix<T>*>& probe,
+		std::shared_future<std::shared_ptr<const void>>& result) {
+		auto range = index.equal_range(key);
+		for (auto it = range.first; it != range.second; ++it) {
+			const Entry& e = **it->second;
+			if (e.op == op && *e.type == typeid(R) && e.same == &_same_operands<T> && e.same(e.operands.get(), &probe)) {
+				lru.splice(lru.begin(), lru, it->second);
+				result = e.result;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void _erase(const std::shared_ptr<Entry>& entry) {
+		if (!entry->live) {
+			return;
+		}
+		entry->live = false;
+		auto range = index.equal_range(entry->key);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (*it->second == entry) {
+				if (entry->counted) {
+					bytes -= entry->bytes;
+				}
+				lru.erase(it->second);
+				index.erase(it);
+				return;
+			}
+		}
+	}
+
+	// least recently used first, entries still computing are not counted and stay
+	void _evict() {
+		auto it = lru.end();
+		while (bytes > capacity && it != lru.begin()) {
+			--it;
+			std::shared_ptr<Entry> e = *it;
+			if (!e->counted) {
+				continue;
+			}
+			++it;
+			_erase(e);
+		}
+	}
+
+	mutable std::mutex mutex;
+	EntryList lru;
+	std::unordered_multimap<uint64_t, EntryList::iterator> index;
+	uint64_t capacity;
+	uint64_t bytes;
+	uint64_t hits, misses;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+typename QMatrix<T>::DetType CachedDet(const QMatrix<T>& a, ResultCache& cache = ResultCache::Shared()) {
+	return cache.GetOrCompute<typename QMatrix<T>::DetType>(CacheOp::Det, { &a }, [&] { return a.Det(); });
+}
+
+template<typename T>
+std::array<QMatrix<T>, 2> CachedDecomposeLU(const QMatrix<T>& a, ResultCache& cache = ResultCache::Shared()) {
+	return cache.GetOrCompute<std::array<QMatrix<T>, 2>>(CacheOp::DecomposeLU, { &a }, [&] { return a.DecomposeLU(); });
+}
+
+template<typename T>
+QMatrix<T> CachedProduct(const QMatrix<T>& a, const QMatrix<T>& b, ResultCache& cache = ResultCache::Shared()) {
+	return cache.GetOrCompute<QMatrix<T>>(CacheOp::Product, { &a, &b }, [&] { return a * b; });
+}
+
+#endif
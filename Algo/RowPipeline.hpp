@@ -0,0 +1,301 @@
+#ifndef _ROW_PIPELINE_H
+#define _ROW_PIPELINE_H
+
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include "ThreadPool.hpp"
+#include <stdint.h>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+/*
+	Streaming row-batch pipeline: the QMatrix scalar operators (+, -, * with a T)
+	and a product with a resident weight matrix, applied to rows as they arrive,
+	without ever holding the whole input.
+
+	A reader fills batches of up to batch_rows rows on its own thread, into one of
+	two buffers, while the calling thread works on the other one. Every finished
+	batch goes to the sink in input order, on the calling thread. Memory is two
+	input batches, one output batch and the weights, whatever the input size.
+
+	The scalar operations are composed into a single x * a + b, so each element is
+	touched once (equal to applying the operators one by one up to rounding). With
+	a weight matrix the scalar operations before it are folded into the GEMM:
+	(x a + b) W = a (x W) + b colsum(W), so the product runs on the raw rows and
+	everything else is one per-column epilogue, applied to each ROW_PIPELINE_PANEL
+	row panel right after its product while it is still in cache. Panels are split
+	across the shared pool.
+*/
+
+#define ROW_PIPELINE_BATCH 4096
+#define ROW_PIPELINE_PANEL 64
+
+template<typename T>
+class RowPipeline {
+public:
+	// writes up to max_rows rows of Cols() entries to dst, returns how many, 0 at the end
+	using Reader = std::function<uint64_t(T* dst, uint64_t max_rows)>;
+	// one finished batch, first_row is the index of its first row in the whole stream
+	using Sink = std::function<void(QMatrixView<const T> batch, uint64_t first_row)>;
+
+	explicit RowPipeline(uint64_t cols, uint64_t batch_rows = ROW_PIPELINE_BATCH) :
+		cols(cols), batch_rows(batch_rows == 0 ? 1 : batch_rows), weight_cols(0),
+		has_weights(false), pre_a(1), pre_b(0), post_a(1), post_b(0) {}
+
+	// stages in the order they are applied, each scalar stage does what the QMatrix operator does
+	RowPipeline<T>& Add(T scalar) {
+		_affine(static_cast<T>(1), scalar);
+		return *this;
+	}
+	RowPipeline<T>& Sub(T scalar) {
+		_affine(static_cast<T>(1), -scalar);
+		return *this;
+	}
+	RowPipeline<T>& Mul(T scalar) {
+		_affine(scalar, static_cast<T>(0));
+		return *this;
+	}
+
+	// right product with w (Cols() x k, copied), at most one per pipeline
+	RowPipeline<T>& Multiply(const QMatrix<T>& w) {
+		if (has_weights) {
+			merror("Pipeline already has a weight matrix!", WARN);
+			return *this;
+		}
+		if (w.GetN() != cols) {
+			merror("Weight matrix rows do not match the row width!", E_MAT_INVALID_DIMENSION);
+			return *this;
+		}
+		weights.resize(SAFE_UINT(cols * w.GetM()));
+		Copy<T>(w.View(), QMatrixView<T>::Of(weights.data(), cols, w.GetM(), Layout::RowMajor));
+		weight_cols = w.GetM();
+		has_weights = true;
+		return *this;
+	}
+
+	uint64_t Cols() const noexcept { return cols; }
+	uint64_t OutCols() const noexcept { return has_weights ? weight_cols : cols; }
+	uint64_t BatchRows() const noexcept { return batch_rows; }
+
+	// streams reader through the stages into sink, returns the number of rows, rethrows reader and sink exceptions
+	uint64_t Run(const Reader& reader, const Sink& sink);
+
+private:
+	struct Slot {
+		std::vector<T> buf;
+		uint64_t rows = 0;
+		bool full = false;
+	};
+
+	// x -> x * a + b after the stages so far
+	void _affine(T a, T b) {
+		if (has_weights) {
+			post_a = post_a * a;
+			post_b = post_b * a + b;
+		}
+		else {
+			pre_a = pre_a * a;
+			pre_b = pre_b * a + b;
+		}
+	}
+
+	void _read_loop(const Reader& reader);
+	void _process(const T* in, uint64_t rows, T* out) const;
+
+	uint64_t cols, batch_rows;
+	std::vector<T> weights;
+	uint64_t weight_cols;
+	bool has_weights;
+	T pre_a, pre_b, post_a, post_b;
+
+	// epilogue out(i, j) = scale * (x W)(i, j) + shift[j]
+	T scale;
+	std::vector<T> shift;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	Slot slots[2];
+	bool stop;
+	std::exception_ptr read_error;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+uint64_t RowPipeline<T>::Run(const Reader& reader, const Sink& sink) {
+	uint64_t k = OutCols();
+	if (has_weights) {
+		scale = post_a * pre_a;
+		shift.assign(SAFE_UINT(k), static_cast<T>(0));
+		for (uint64_t i = 0; i < cols; ++i) {
+			_axpy<T>(k, static_cast<T>(1), weights.data() + i * k, shift.data());
+		}
+		for (T& s : shift) {
+			s = post_a * pre_b * s + post_b;
+		}
+	}
+
+	for (Slot& s : slots) {
+		s.buf.resize(SAFE_UINT(batch_rows * cols));
+		s.rows = 0;
+		s.full = false;
+	}
+	std::vector<T> out(has_weights ? SAFE_UINT(batch_rows * k) : 0);
+	stop = false;
+	read_error = nullptr;
+
+	std::thread producer(&RowPipeline<T>::_read_loop, this, std::cref(reader));
+	auto halt = [&] {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		cv.notify_all();
+		producer.join();
+	};
+
+	uint64_t total = 0;
+	try {
+		for (uint64_t b = 0;; ++b) {
+			Slot& s = slots[b % 2];
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [&] { return s.full; });
+			}
+			if (s.rows == 0) {
+				break;
+			}
+
+			T* res = has_weights ? out.data() : s.buf.data();
+			_process(s.buf.data(), s.rows, res);
+			sink(QMatrixView<const T>::Of(res, s.rows, k, Layout::RowMajor), total);
+			total += s.rows;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				s.full = false;
+			}
+			cv.notify_all();
+		}
+	}
+	catch (...) {
+		halt();
+		throw;
+	}
+	halt();
+
+	if (read_error) {
+		std::rethrow_exception(read_error);
+	}
+	return total;
+}
+
+template<typename T>
+void RowPipeline<T>::_read_loop(const Reader& reader) {
+	for (uint64_t b = 0;; ++b) {
+		Slot& s = slots[b % 2];
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [&] { return stop || !s.full; });
+			if (stop) {
+				return;
+			}
+		}
+
+		uint64_t rows = 0;
+		try {
+			rows = reader(s.buf.data(), batch_rows);
+		}
+		catch (...) {
+			read_error = std::current_exception();
+			rows = 0;
+		}
+		if (rows > batch_rows) {
+			merror("Reader returned more rows than asked for!", WARN);
+			rows = batch_rows;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			s.rows = rows;
+			s.full = true;
+		}
+		cv.notify_all();
+		if (rows == 0) {
+			return;
+		}
+	}
+}
+
+template<typename T>
+void RowPipeline<T>::_process(const T* in, uint64_t rows, T* out) const {
+	uint64_t k = OutCols();
+	uint64_t panels = (rows + ROW_PIPELINE_PANEL - 1) / ROW_PIPELINE_PANEL;
+	ThreadPool::Shared().ParallelFor(0, panels, [&](uint64_t p) {
+		uint64_t r0 = p * ROW_PIPELINE_PANEL;
+		uint64_t pr = rows - r0 < ROW_PIPELINE_PANEL ? rows - r0 : ROW_PIPELINE_PANEL;
+		if (!has_weights) {
+			// in place, out is the input buffer
+			T* x = out + r0 * cols;
+			for (uint64_t i = 0; i < pr * cols; ++i) {
+				x[i] = x[i] * pre_a + pre_b;
+			}
+			return;
+		}
+
+		QMatrixView<T> y = QMatrixView<T>::Of(out + r0 * k, pr, k, Layout::RowMajor);
+		Gemm<T>(QMatrixView<const T>::Of(in + r0 * cols, pr, cols, Layout::RowMajor),
+			QMatrixView<const T>::Of(weights.data(), cols, k, Layout::RowMajor), y);
+		for (uint64_t i = 0; i < pr; ++i) {
+			T* yi = &y(i, 0);
+			for (uint64_t j = 0; j < k; ++j) {
+				yi[j] = yi[j] * scale + shift[j];
+			}
+		}
+	});
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// rows of an in-memory view, as a RowPipeline reader
+template<typename T>
+typename RowPipeline<T>::Reader ViewRowReader(QMatrixView<const T> src) {
+	return [src, next = uint64_t(0)](T* dst, uint64_t max_rows) mutable -> uint64_t {
+		uint64_t rows = src.GetN() - next < max_rows ? src.GetN() - next : max_rows;
+		if (rows == 0) {
+			return 0;
+		}
+		Copy<T>(src.Sub(next, 0, rows, src.GetM()), QMatrixView<T>::Of(dst, rows, src.GetM(), Layout::RowMajor));
+		next += rows;
+		return rows;
+	};
+}
+
+// raw row-major rows of cols entries from a binary stream, a partial last row is dropped
+template<typename T>
+typename RowPipeline<T>::Reader StreamRowReader(std::istream& in, uint64_t cols) {
+	return [&in, cols](T* dst, uint64_t max_rows) -> uint64_t {
+		uint64_t row_bytes = cols * sizeof(T);
+		in.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(max_rows * row_bytes));
+		return row_bytes == 0 ? 0 : static_cast<uint64_t>(in.gcount()) / row_bytes;
+	};
+}
+
+// writes each batch to a binary stream as raw row-major rows
+template<typename T>
+typename RowPipeline<T>::Sink StreamRowWriter(std::ostream& out) {
+	return [&out](QMatrixView<const T> batch, uint64_t) {
+		for (uint64_t i = 0; i < batch.GetN(); ++i) {
+			out.write(reinterpret_cast<const char*>(&batch(i, 0)), static_cast<std::streamsize>(batch.GetM() * sizeof(T)));
+		}
+	};
+}
+
+#endif
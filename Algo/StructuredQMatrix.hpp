@@ -0,0 +1,596 @@
+#ifndef _STRUCTURED_QMATRIX_H
+#define _STRUCTURED_QMATRIX_H
+
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include <stdint.h>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+
+/*
+	Structured square matrices with packed storage:
+
+	  DiagonalQMatrix    n entries
+	  TriangularQMatrix  n(n+1)/2 entries, row by row
+	  BandedQMatrix      n(kl+ku+1) entries, kl sub- and ku superdiagonals
+	  SymmetricQMatrix   n(n+1)/2 entries of the lower triangle (Hermitian for complex T)
+
+	Products with a dense QMatrix and solves only touch the stored entries, so a
+	diagonal product is O(nm), a triangular product or solve O(n^2 m) and a
+	banded one O(n(kl+ku)m) instead of a dense O(n^2 m) GEMM or O(n^3) factorization.
+*/
+
+template<typename T>
+QMatrix<T> _zeros(uint64_t n, uint64_t m) {
+	std::vector<T> _tmp_nums(SAFE_UINT(n * m), static_cast<T>(0));
+	return QMatrix<T>(_tmp_nums.data(), n, m);
+}
+
+enum class Triangle {
+	Lower,
+	Upper
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+class DiagonalQMatrix {
+public:
+	DiagonalQMatrix(const T* diag, uint64_t n) : diag(diag, diag + n) {}
+	explicit DiagonalQMatrix(std::vector<T> diag) : diag(std::move(diag)) {}
+
+	static DiagonalQMatrix<T> Identity(uint64_t n) {
+		return DiagonalQMatrix<T>(std::vector<T>(SAFE_UINT(n), static_cast<T>(1)));
+	}
+
+	uint64_t GetN() const noexcept { return diag.size(); }
+	T GetItem(uint64_t i, uint64_t j) const { return i == j ? diag[i] : static_cast<T>(0); }
+	T Diag(uint64_t i) const { return diag[i]; }
+
+	T Det() const {
+		T det = static_cast<T>(1);
+		for (const T& d : diag) {
+			det *= d;
+		}
+		return det;
+	}
+
+	DiagonalQMatrix<T> Inverse() const {
+		std::vector<T> inv(diag.size());
+		for (size_t i = 0; i < diag.size(); ++i) {
+			if (diag[i] == static_cast<T>(0)) {
+				merror("Cannot invert a singular diagonal matrix!", SEVERE);
+				return *this;
+			}
+			inv[i] = static_cast<T>(1) / diag[i];
+		}
+		return DiagonalQMatrix<T>(std::move(inv));
+	}
+
+	// x with D x = b, row i of b divided by d_i
+	QMatrix<T> Solve(const QMatrix<T>& b) const {
+		if (GetN() != b.GetN()) {
+			merror("Cannot solve a diagonal system with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		QMatrix<T> x = b;
+		QMatrixView<T> v = x.View();
+		for (uint64_t i = 0; i < b.GetN(); ++i) {
+			if (diag[i] == static_cast<T>(0)) {
+				merror("Singular diagonal matrix in Solve!", SEVERE);
+				return b;
+			}
+			for (uint64_t j = 0; j < b.GetM(); ++j) {
+				v(i, j) /= diag[i];
+			}
+		}
+		return x;
+	}
+
+	QMatrix<T> ToQMatrix() const {
+		QMatrix<T> res = _zeros<T>(GetN(), GetN());
+		QMatrixView<T> v = res.View();
+		for (uint64_t i = 0; i < GetN(); ++i) {
+			v(i, i) = diag[i];
+		}
+		return res;
+	}
+
+	// D * b scales the rows of b
+	friend QMatrix<T> operator*(const DiagonalQMatrix<T>& d, const QMatrix<T>& b) {
+		if (d.GetN() != b.GetN()) {
+			merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		QMatrix<T> res = b;
+		QMatrixView<T> v = res.View();
+		for (uint64_t i = 0; i < b.GetN(); ++i) {
+			if (d.diag[i] == static_cast<T>(1)) {
+				continue;
+			}
+			for (uint64_t j = 0; j < b.GetM(); ++j) {
+				v(i, j) *= d.diag[i];
+			}
+		}
+		return res;
+	}
+
+	// b * D scales the columns of b
+	friend QMatrix<T> operator*(const QMatrix<T>& b, const DiagonalQMatrix<T>& d) {
+		if (d.GetN() != b.GetM()) {
+			merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		QMatrix<T> res = b;
+		QMatrixView<T> v = res.View();
+		for (uint64_t i = 0; i < b.GetN(); ++i) {
+			for (uint64_t j = 0; j < b.GetM(); ++j) {
+				v(i, j) *= d.diag[j];
+			}
+		}
+		return res;
+	}
+
+	friend DiagonalQMatrix<T> operator*(const DiagonalQMatrix<T>& a, const DiagonalQMatrix<T>& b) {
+		if (a.GetN() != b.GetN()) {
+			merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return a;
+		}
+		std::vector<T> res(a.diag.size());
+		for (size_t i = 0; i < res.size(); ++i) {
+			res[i] = a.diag[i] * b.diag[i];
+		}
+		return DiagonalQMatrix<T>(std::move(res));
+	}
+
+private:
+	std::vector<T> diag;
+};
+
+template<typename T>
+DiagonalQMatrix<T> Identity(uint64_t n) {
+	return DiagonalQMatrix<T>::Identity(n);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+class TriangularQMatrix {
+public:
+	// zero triangle of the given kind, unit means the diagonal is implicitly 1
+	TriangularQMatrix(uint64_t n, Triangle tri, bool unit = false) :
+		n(n), tri(tri), unit(unit), packed(SAFE_UINT(n * (n + 1) / 2), static_cast<T>(0)) {
+		if (unit) {
+			for (uint64_t i = 0; i < n; ++i) {
+				At(i, i) = static_cast<T>(1);
+			}
+		}
+	}
+
+	// packs the given triangle of a dense matrix, the other half is ignored
+	TriangularQMatrix(QMatrixView<const T> a, Triangle tri, bool unit = false) : TriangularQMatrix(a.GetN(), tri, unit) {
+		if (a.GetN() != a.GetM()) {
+			merror("Cannot pack a triangle of a non-square matrix!", E_MAT_INVALID_DIMENSION);
+			return;
+		}
+		for (uint64_t i = 0; i < n; ++i) {
+			uint64_t lo = tri == Triangle::Lower ? 0 : i;
+			uint64_t hi = tri == Triangle::Lower ? i : n - 1;
+			for (uint64_t j = lo; j <= hi; ++j) {
+				if (!(unit && i == j)) {
+					At(i, j) = a(i, j);
+				}
+			}
+		}
+	}
+
+	uint64_t GetN() const noexcept { return n; }
+	Triangle GetTriangle() const noexcept { return tri; }
+	bool IsUnit() const noexcept { return unit; }
+
+	bool InTriangle(uint64_t i, uint64_t j) const noexcept {
+		return tri == Triangle::Lower ? j <= i : j >= i;
+	}
+
+	T GetItem(uint64_t i, uint64_t j) const {
+		return InTriangle(i, j) ? packed[_offset(i, j)] : static_cast<T>(0);
+	}
+
+	// only valid inside the triangle
+	T& At(uint64_t i, uint64_t j) { return packed[_offset(i, j)]; }
+	const T& At(uint64_t i, uint64_t j) const { return packed[_offset(i, j)]; }
+
+	// row i of the triangle as a contiguous run starting at column RowBegin(i)
+	const T* RowData(uint64_t i) const { return packed.data() + _offset(i, RowBegin(i)); }
+	uint64_t RowBegin(uint64_t i) const noexcept { return tri == Triangle::Lower ? 0 : i; }
+	uint64_t RowLength(uint64_t i) const noexcept { return tri == Triangle::Lower ? i + 1 : n - i; }
+
+	T Det() const {
+		T det = static_cast<T>(1);
+		if (unit) {
+			return det;
+		}
+		for (uint64_t i = 0; i < n; ++i) {
+			det *= At(i, i);
+		}
+		return det;
+	}
+
+	QMatrix<T> ToQMatrix() const {
+		QMatrix<T> res = _zeros<T>(n, n);
+		QMatrixView<T> v = res.View();
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t j = RowBegin(i); j < RowBegin(i) + RowLength(i); ++j) {
+				v(i, j) = At(i, j);
+			}
+		}
+		return res;
+	}
+
+	// x with A x = b by forward or back substitution, O(n^2 m)
+	QMatrix<T> Solve(const QMatrix<T>& b) const {
+		if (b.GetN() != n) {
+			merror("Cannot solve a triangular system with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		QMatrix<T> x = b;
+		QMatrixView<T> v = x.View();
+		uint64_t m = b.GetM();
+		for (uint64_t s = 0; s < n; ++s) {
+			uint64_t i = tri == Triangle::Lower ? s : n - 1 - s;
+			const T* row = RowData(i);
+			for (uint64_t j = RowBegin(i); j < RowBegin(i) + RowLength(i); ++j) {
+				if (j != i) {
+					_axpy<T>(m, -row[j - RowBegin(i)], &v(j, 0), &v(i, 0));
+				}
+			}
+			if (!unit) {
+				T d = At(i, i);
+				if (d == static_cast<T>(0)) {
+					merror("Singular triangular matrix in Solve!", SEVERE);
+					return x;
+				}
+				for (uint64_t c = 0; c < m; ++c) {
+					v(i, c) /= d;
+				}
+			}
+		}
+		return x;
+	}
+
+	// A * b in place on a copy of b, O(n^2 m): lower runs bottom-up, upper top-down,
+	// so every row still reads the untouched rows it needs
+	friend QMatrix<T> operator*(const TriangularQMatrix<T>& a, const QMatrix<T>& b) {
+		if (a.n != b.GetN()) {
+			merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		QMatrix<T> res = b;
+		QMatrixView<T> v = res.View();
+		uint64_t n = a.n;
+		uint64_t m = b.GetM();
+		for (uint64_t s = 0; s < n; ++s) {
+			uint64_t i = a.tri == Triangle::Lower ? n - 1 - s : s;
+			if (!a.unit) {
+				T d = a.At(i, i);
+				for (uint64_t c = 0; c < m; ++c) {
+					v(i, c) *= d;
+				}
+			}
+			const T* row = a.RowData(i);
+			for (uint64_t j = a.RowBegin(i); j < a.RowBegin(i) + a.RowLength(i); ++j) {
+				if (j != i) {
+					_axpy<T>(m, row[j - a.RowBegin(i)], &v(j, 0), &v(i, 0));
+				}
+			}
+		}
+		return res;
+	}
+
+private:
+	uint64_t _offset(uint64_t i, uint64_t j) const noexcept {
+		if (tri == Triangle::Lower) {
+			return i * (i + 1) / 2 + j;
+		}
+		return i * n - i * (i - 1) / 2 + (j - i);
+	}
+
+	uint64_t n;
+	Triangle tri;
+	bool unit;
+	std::vector<T> packed;
+};
+
+// Crout LU straight into packed factors: L lower, U unit upper, no dense zero halves.
+// Unpivoted, a zero leading pivot is reported even for a regular a; DecomposeLU pivots.
+template<typename T>
+std::array<TriangularQMatrix<T>, 2> DecomposeLUPacked(const QMatrix<T>& a) {
+	if (!a.IsSquare()) {
+		merror("Cannot apply LU-decomposition to non-square matrix!", E_MAT_INVALID_DIMENSION);
+		return std::array<TriangularQMatrix<T>, 2> {
+			TriangularQMatrix<T>(0, Triangle::Lower),
+			TriangularQMatrix<T>(0, Triangle::Upper, true)
+		};
+	}
+	QMatrix<T> lu = a;
+	if (!_crout_in_place(lu.View())) {
+		merror("Zero pivot in LU-decomposition!", SEVERE);
+	}
+	return std::array<TriangularQMatrix<T>, 2> {
+		TriangularQMatrix<T>(lu.View(), Triangle::Lower),
+		TriangularQMatrix<T>(lu.View(), Triangle::Upper, true)
+	};
+}
+
+// x with L U x = b for packed factors from DecomposeLUPacked, O(n^2 m)
+template<typename T>
+QMatrix<T> SolveLU(const std::array<TriangularQMatrix<T>, 2>& lu, const QMatrix<T>& b) {
+	return lu[1].Solve(lu[0].Solve(b));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+class BandedQMatrix {
+public:
+	BandedQMatrix(uint64_t n, uint64_t kl, uint64_t ku) :
+		n(n), kl(kl), ku(ku), band(SAFE_UINT(n * (kl + ku + 1)), static_cast<T>(0)) {}
+
+	// keeps only the band of a dense matrix
+	BandedQMatrix(QMatrixView<const T> a, uint64_t kl, uint64_t ku) : BandedQMatrix(a.GetN(), kl, ku) {
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t j = _lo(i); j < _hi(i); ++j) {
+				At(i, j) = a(i, j);
+			}
+		}
+	}
+
+	uint64_t GetN() const noexcept { return n; }
+	uint64_t Lower() const noexcept { return kl; }
+	uint64_t Upper() const noexcept { return ku; }
+
+	bool InBand(uint64_t i, uint64_t j) const noexcept {
+		return j + kl >= i && j <= i + ku;
+	}
+
+	T GetItem(uint64_t i, uint64_t j) const {
+		return InBand(i, j) ? band[_offset(i, j)] : static_cast<T>(0);
+	}
+
+	// only valid inside the band
+	T& At(uint64_t i, uint64_t j) { return band[_offset(i, j)]; }
+	const T& At(uint64_t i, uint64_t j) const { return band[_offset(i, j)]; }
+
+	QMatrix<T> ToQMatrix() const {
+		QMatrix<T> res = _zeros<T>(n, n);
+		QMatrixView<T> v = res.View();
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t j = _lo(i); j < _hi(i); ++j) {
+				v(i, j) = At(i, j);
+			}
+		}
+		return res;
+	}
+
+	/*
+		x with A x = b through a banded LU without pivoting, which stays inside
+		the band: O(n kl ku) to factor and O(n (kl + ku) m) to substitute.
+	*/
+	QMatrix<T> Solve(const QMatrix<T>& b) const {
+		if (b.GetN() != n) {
+			merror("Cannot solve a banded system with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+
+		BandedQMatrix<T> lu = *this;
+		for (uint64_t k = 0; k < n; ++k) {
+			T pivot = lu.At(k, k);
+			if (pivot == static_cast<T>(0)) {
+				merror("Zero pivot in banded LU-decomposition!", SEVERE);
+				return b;
+			}
+			uint64_t last = k + kl < n - 1 ? k + kl : n - 1;
+			uint64_t right = k + ku < n - 1 ? k + ku : n - 1;
+			for (uint64_t i = k + 1; i <= last; ++i) {
+				T l = lu.At(i, k) / pivot;
+				lu.At(i, k) = l;
+				for (uint64_t j = k + 1; j <= right; ++j) {
+					lu.At(i, j) -= l * lu.At(k, j);
+				}
+			}
+		}
+
+		QMatrix<T> x = b;
+		QMatrixView<T> v = x.View();
+		uint64_t m = b.GetM();
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t j = _lo(i); j < i; ++j) {
+				_axpy<T>(m, -lu.At(i, j), &v(j, 0), &v(i, 0));
+			}
+		}
+		for (uint64_t s = 0; s < n; ++s) {
+			uint64_t i = n - 1 - s;
+			for (uint64_t j = i + 1; j < _hi(i); ++j) {
+				_axpy<T>(m, -lu.At(i, j), &v(j, 0), &v(i, 0));
+			}
+			T d = lu.At(i, i);
+			for (uint64_t c = 0; c < m; ++c) {
+				v(i, c) /= d;
+			}
+		}
+		return x;
+	}
+
+	friend QMatrix<T> operator*(const BandedQMatrix<T>& a, const QMatrix<T>& b) {
+		if (a.n != b.GetN()) {
+			merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		QMatrix<T> res = _zeros<T>(a.n, b.GetM());
+		QMatrixView<T> v = res.View();
+		QMatrixView<const T> bv = b.View();
+		for (uint64_t i = 0; i < a.n; ++i) {
+			for (uint64_t j = a._lo(i); j < a._hi(i); ++j) {
+				_axpy<T>(b.GetM(), a.At(i, j), &bv(j, 0), &v(i, 0));
+			}
+		}
+		return res;
+	}
+
+private:
+	// columns [_lo(i), _hi(i)) of row i lie in the band
+	uint64_t _lo(uint64_t i) const noexcept { return i > kl ? i - kl : 0; }
+	uint64_t _hi(uint64_t i) const noexcept { return i + ku + 1 < n ? i + ku + 1 : n; }
+
+	uint64_t _offset(uint64_t i, uint64_t j) const noexcept {
+		return i * (kl + ku + 1) + (j + kl - i);
+	}
+
+	uint64_t n, kl, ku;
+	std::vector<T> band;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+class SymmetricQMatrix {
+public:
+	explicit SymmetricQMatrix(uint64_t n) : lower(n, Triangle::Lower) {}
+
+	// takes the lower triangle of a dense matrix, the upper half is implied
+	explicit SymmetricQMatrix(QMatrixView<const T> a) : lower(a, Triangle::Lower) {}
+
+	uint64_t GetN() const noexcept { return lower.GetN(); }
+
+	T GetItem(uint64_t i, uint64_t j) const {
+		return j <= i ? lower.At(i, j) : _conj(lower.At(j, i));
+	}
+
+	// sets (i, j) and, implicitly, (j, i)
+	void SetItem(uint64_t i, uint64_t j, T value) {
+		if (j <= i) {
+			lower.At(i, j) = value;
+		}
+		else {
+			lower.At(j, i) = _conj(value);
+		}
+	}
+
+	QMatrix<T> ToQMatrix() const {
+		QMatrix<T> res = _zeros<T>(GetN(), GetN());
+		QMatrixView<T> v = res.View();
+		for (uint64_t i = 0; i < GetN(); ++i) {
+			for (uint64_t j = 0; j < GetN(); ++j) {
+				v(i, j) = GetItem(i, j);
+			}
+		}
+		return res;
+	}
+
+	/*
+		Cholesky factor L with A = L L^H for a symmetric (Hermitian) positive
+		definite matrix, n^3/3 flops and packed storage. Reports and stops at the
+		first non-positive pivot.
+	*/
+	TriangularQMatrix<T> Cholesky() const {
+		TriangularQMatrix<T> l(GetN(), Triangle::Lower);
+		_cholesky(l);
+		return l;
+	}
+
+	// x with A x = b through the Cholesky factor, b back when A is not positive definite
+	QMatrix<T> CholeskySolve(const QMatrix<T>& b) const {
+		if (GetN() != b.GetN()) {
+			merror("Cannot solve a symmetric system with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		TriangularQMatrix<T> l(GetN(), Triangle::Lower);
+		if (!_cholesky(l)) {
+			return b;
+		}
+		QMatrix<T> y = l.Solve(b);
+
+		// back substitution with L^H, reading L by rows
+		uint64_t n = GetN();
+		uint64_t m = b.GetM();
+		QMatrixView<T> v = y.View();
+		for (uint64_t s = 0; s < n; ++s) {
+			uint64_t i = n - 1 - s;
+			T d = l.At(i, i);
+			for (uint64_t c = 0; c < m; ++c) {
+				v(i, c) /= d;
+			}
+			const T* li = l.RowData(i);
+			for (uint64_t k = 0; k < i; ++k) {
+				_axpy<T>(m, -_conj(li[k]), &v(i, 0), &v(k, 0));
+			}
+		}
+		return y;
+	}
+
+	friend QMatrix<T> operator*(const SymmetricQMatrix<T>& a, const QMatrix<T>& b) {
+		if (a.GetN() != b.GetN()) {
+			merror("Cannot multiply two matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		uint64_t n = a.GetN();
+		uint64_t m = b.GetM();
+		QMatrix<T> res = _zeros<T>(n, m);
+		QMatrixView<T> v = res.View();
+		QMatrixView<const T> bv = b.View();
+
+		// every stored entry is used twice: for (i, j) and for its mirror (j, i)
+		for (uint64_t i = 0; i < n; ++i) {
+			const T* li = a.lower.RowData(i);
+			for (uint64_t j = 0; j < i; ++j) {
+				_axpy<T>(m, li[j], &bv(j, 0), &v(i, 0));
+				_axpy<T>(m, _conj(li[j]), &bv(i, 0), &v(j, 0));
+			}
+			_axpy<T>(m, li[i], &bv(i, 0), &v(i, 0));
+		}
+		return res;
+	}
+
+private:
+	// factors into l, a zeroed n x n lower triangle; false at the first non-positive pivot
+	bool _cholesky(TriangularQMatrix<T>& l) const {
+		uint64_t n = GetN();
+		for (uint64_t j = 0; j < n; ++j) {
+			T s = lower.At(j, j);
+			const T* lj = l.RowData(j);
+			for (uint64_t k = 0; k < j; ++k) {
+				s -= lj[k] * _conj(lj[k]);
+			}
+			if (!(std::real(s) > 0)) {
+				merror("Matrix is not positive definite, Cholesky stopped!", SEVERE);
+				return false;
+			}
+			T d = static_cast<T>(std::sqrt(std::real(s)));
+			l.At(j, j) = d;
+
+			for (uint64_t i = j + 1; i < n; ++i) {
+				const T* li = l.RowData(i);
+				T t = lower.At(i, j);
+				if constexpr (_is_complex<T>::value) {
+					for (uint64_t k = 0; k < j; ++k) {
+						t -= li[k] * _conj(lj[k]);
+					}
+				}
+				else {
+					t -= _dot<T>(j, li, lj);
+				}
+				l.At(i, j) = t / d;
+			}
+		}
+		return true;
+	}
+
+
+	TriangularQMatrix<T> lower;
+};
+
+#endif
@@ -0,0 +1,285 @@
+#ifndef _TASK_GRAPH_H
+#define _TASK_GRAPH_H
+
+#include "QMatrix.hpp"
+#include "ThreadPool.hpp"
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+	Asynchronous dependency graph of matrix operations.
+
+	Add() starts a node right away, Then() starts a node once all of its inputs
+	have finished and hands it their results. Nothing blocks a worker while it
+	waits: a finishing node releases its successors onto the pool, so independent
+	chains run side by side. AddIO() runs a node on a small separate pool meant
+	for blocking loads and stores, letting the next input load while the
+	current one is being computed.
+
+	An exception thrown by a node is stored in it, passed on to every node that
+	depends on it and rethrown from Get().
+*/
+
+struct _TaskBase {
+	std::mutex mutex;
+	bool done = false;
+	std::vector<std::function<void()>> successors;
+
+	// runs fn once this node has finished (immediately if it already has)
+	void OnDone(std::function<void()> fn) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!done) {
+				successors.push_back(std::move(fn));
+				return;
+			}
+		}
+		fn();
+	}
+
+	void Finish() {
+		std::vector<std::function<void()>> _tmp_succ;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+			_tmp_succ.swap(successors);
+		}
+		for (auto& fn : _tmp_succ) {
+			fn();
+		}
+	}
+};
+
+template<typename R>
+struct _TaskState : _TaskBase {
+	std::promise<R> promise;
+	std::shared_future<R> future = promise.get_future().share();
+};
+
+template<typename R>
+class TaskNode {
+	friend class TaskGraph;
+public:
+	TaskNode() = default;
+
+	// blocks until the node has run
+	decltype(auto) Get() const {
+		return state->future.get();
+	}
+
+	bool Ready() const {
+		return state->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	std::shared_future<R> Future() const {
+		return state->future;
+	}
+
+private:
+	explicit TaskNode(std::shared_ptr<_TaskState<R>> state) : state(std::move(state)) {}
+	std::shared_ptr<_TaskState<R>> state;
+};
+
+class TaskGraph {
+public:
+	explicit TaskGraph(ThreadPool& pool = ThreadPool::Shared()) :
+		pool(pool), tracker(std::make_shared<_Tracker>()) {}
+
+	~TaskGraph() {
+		Wait();
+	}
+
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	// node with no inputs, runs on the compute pool
+	template<typename F>
+	auto Add(F f) -> TaskNode<std::invoke_result_t<F>> {
+		return _launch(pool, std::move(f));
+	}
+
+	// node with no inputs, runs on the I/O pool
+	template<typename F>
+	auto AddIO(F f) -> TaskNode<std::invoke_result_t<F>> {
+		return _launch(IoPool(), std::move(f));
+	}
+
+	// node holding an already known value
+	template<typename R>
+	TaskNode<R> Value(R value) {
+		auto state = std::make_shared<_TaskState<R>>();
+		state->promise.set_value(std::move(value));
+		state->Finish();
+		return TaskNode<R>(state);
+	}
+
+	// node running f(deps.Get()...) once every dependency has finished
+	template<typename F, typename... D>
+	auto Then(F f, const TaskNode<D>&... deps) -> TaskNode<std::invoke_result_t<F, const D&...>> {
+		static_assert(sizeof...(D) > 0, "Then() needs at least one dependency, use Add()");
+		static_assert((!std::is_void_v<D> && ...), "void nodes cannot feed a value into Then()");
+
+		using R = std::invoke_result_t<F, const D&...>;
+		auto state = std::make_shared<_TaskState<R>>();
+		auto remaining = std::make_shared<std::atomic<size_t>>(sizeof...(D));
+		_track_start();
+
+		auto run = [tracker = tracker, state, f = std::move(f), deps...]() mutable {
+			_run_into(*state, [&]() -> R { return f(deps.Get()...); });
+			_track_finish(tracker);
+		};
+		auto release = [target = &pool, remaining, run = std::move(run)]() mutable {
+			if (remaining->fetch_sub(1) == 1) {
+				target->Post(std::move(run));
+			}
+		};
+		auto shared_release = std::make_shared<decltype(release)>(std::move(release));
+		(deps.state->OnDone([shared_release] { (*shared_release)(); }), ...);
+
+		return TaskNode<R>(state);
+	}
+
+	// waits for every node added so far
+	void Wait() {
+		std::unique_lock<std::mutex> lock(tracker->mutex);
+		tracker->cv.wait(lock, [this] { return tracker->outstanding == 0; });
+	}
+
+	static ThreadPool& IoPool() {
+		static ThreadPool pool(2);
+		return pool;
+	}
+
+private:
+	struct _Tracker {
+		std::mutex mutex;
+		std::condition_variable cv;
+		uint64_t outstanding = 0;
+	};
+
+	void _track_start() {
+		std::lock_guard<std::mutex> lock(tracker->mutex);
+		tracker->outstanding++;
+	}
+
+	// takes its own reference: the graph may be gone as soon as the count drops
+	static void _track_finish(std::shared_ptr<_Tracker> tracker) {
+		std::lock_guard<std::mutex> lock(tracker->mutex);
+		if (--tracker->outstanding == 0) {
+			tracker->cv.notify_all();
+		}
+	}
+
+	template<typename R, typename F>
+	static void _run_into(_TaskState<R>& state, F&& body) {
+		try {
+			if constexpr (std::is_void_v<R>) {
+				body();
+				state.promise.set_value();
+			}
+			else {
+				state.promise.set_value(body());
+			}
+		}
+		catch (...) {
+			state.promise.set_exception(std::current_exception());
+		}
+		state.Finish();
+	}
+
+	template<typename F>
+	auto _launch(ThreadPool& target, F f) -> TaskNode<std::invoke_result_t<F>> {
+		using R = std::invoke_result_t<F>;
+		auto state = std::make_shared<_TaskState<R>>();
+		_track_start();
+		target.Post([tracker = tracker, state, f = std::move(f)]() mutable {
+			_run_into(*state, f);
+			_track_finish(tracker);
+		});
+		return TaskNode<R>(state);
+	}
+
+	ThreadPool& pool;
+	std::shared_ptr<_Tracker> tracker;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+TaskNode<QMatrix<T>> AsyncProduct(TaskGraph& g, const TaskNode<QMatrix<T>>& a, const TaskNode<QMatrix<T>>& b) {
+	return g.Then([](const QMatrix<T>& x, const QMatrix<T>& y) { return x * y; }, a, b);
+}
+
+template<typename T>
+TaskNode<QMatrix<T>> AsyncSum(TaskGraph& g, const TaskNode<QMatrix<T>>& a, const TaskNode<QMatrix<T>>& b) {
+	return g.Then([](const QMatrix<T>& x, const QMatrix<T>& y) { return x + y; }, a, b);
+}
+
+template<typename T>
+TaskNode<std::array<QMatrix<T>, 2>> AsyncDecomposeLU(TaskGraph& g, const TaskNode<QMatrix<T>>& a) {
+	return g.Then([](const QMatrix<T>& x) { return x.DecomposeLU(); }, a);
+}
+
+template<typename T>
+TaskNode<typename QMatrix<T>::DetType> AsyncDet(TaskGraph& g, const TaskNode<QMatrix<T>>& a) {
+	return g.Then([](const QMatrix<T>& x) { return x.Det(); }, a);
+}
+
+/*
+	Determinant from an LU node that is already (being) computed, without factoring
+	again, O(n^2). DecomposeLU gives A = L U with U unit upper and L = P^T L0, L0
+	lower triangular, so det A = det L. Row r of L is row c(r) of L0, and c(r) is
+	the column of its last nonzero as long as the diagonal of L0 has none: then
+	det A = sign(c) * prod L(r, c(r)). Rows that do not map onto a permutation mean
+	a zero on that diagonal, and det A = 0. Integer matrices come back unfactored
+	as {I, A}, their determinant is taken from U.
+*/
+template<typename T>
+TaskNode<typename QMatrix<T>::DetType> AsyncDet(TaskGraph& g, const TaskNode<std::array<QMatrix<T>, 2>>& lu) {
+	return g.Then([](const std::array<QMatrix<T>, 2>& f) {
+		using D = typename QMatrix<T>::DetType;
+		if constexpr (std::is_integral_v<T>) {
+			return f[1].Det();
+		}
+		else {
+			const QMatrix<T>& l = f[0];
+			uint64_t n = l.GetN();
+			std::vector<uint64_t> col(SAFE_UINT(n));
+			std::vector<bool> taken(SAFE_UINT(n), false);
+			D det = static_cast<D>(1);
+			for (uint64_t r = 0; r < n; ++r) {
+				uint64_t c = n;
+				while (c > 0 && l.GetItem(r, c - 1) == static_cast<T>(0)) {
+					--c;
+				}
+				if (c == 0 || taken[c - 1]) {
+					return static_cast<D>(0);
+				}
+				col[r] = c - 1;
+				taken[c - 1] = true;
+				det *= static_cast<D>(l.GetItem(r, c - 1));
+			}
+
+			// sign of the permutation, one flip per transposition undone
+			for (uint64_t r = 0; r < n; ++r) {
+				while (col[r] != r) {
+					std::swap(col[r], col[col[r]]);
+					det = -det;
+				}
+			}
+			return det;
+		}
+	}, lu);
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+#include "MatrixError.hpp"
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+	Fixed-size worker pool shared by the parallel kernels and the task graph.
+	ThreadPool::Shared() is the process-wide instance sized to the hardware.
+*/
+
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t threads = 0) : ThreadPool(threads, nullptr) {}
+
+	// on_start(i) runs first on worker i, e.g. to pin it to a set of CPUs
+	ThreadPool(size_t threads, std::function<void(size_t)> on_start) : stop(false) {
+		if (threads == 0) {
+			threads = std::thread::hardware_concurrency();
+		}
+		if (threads == 0) {
+			threads = 1;
+		}
+		for (size_t i = 0; i < threads; ++i) {
+			workers.emplace_back([this, i, on_start] {
+				if (on_start) {
+					on_start(i);
+				}
+				_worker_loop();
+			});
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		cv.notify_all();
+		for (std::thread& t : workers) {
+			t.join();
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t Size() const noexcept {
+		return workers.size();
+	}
+
+	void Post(std::function<void()> job) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back(std::move(job));
+		}
+		cv.notify_one();
+	}
+
+	template<typename F>
+	auto Submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+		using R = std::invoke_result_t<std::decay_t<F>>;
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+		std::future<R> res = task->get_future();
+		Post([task] { (*task)(); });
+		return res;
+	}
+
+	/*
+		Runs f(i) for every i in [begin, end) and returns when all are done.
+		The calling thread works on chunks too, so this is safe to call from
+		inside a pool job: it never waits on a helper that has not started.
+		If f throws, the remaining chunks are skipped and the first exception
+		is rethrown here once no thread is inside f any more.
+	*/
+	template<typename F>
+	void ParallelFor(uint64_t begin, uint64_t end, F f, uint64_t grain = 1) {
+		if (end <= begin) {
+			return;
+		}
+		if (grain == 0) {
+			grain = 1;
+		}
+
+		struct State {
+			std::atomic<uint64_t> next;
+			std::atomic<uint64_t> done;
+			std::atomic<bool> failed;
+			std::exception_ptr error;
+			std::mutex mutex;
+			std::condition_variable cv;
+		};
+
+		uint64_t chunks = (end - begin + grain - 1) / grain;
+		if (chunks == 1 || workers.size() == 1) {
+			for (uint64_t i = begin; i < end; ++i) {
+				f(i);
+			}
+			return;
+		}
+
+		auto state = std::make_shared<State>();
+		state->next = 0;
+		state->done = 0;
+		state->failed = false;
+
+		// every claimed chunk counts as done, chunks claimed after a failure are skipped
+		auto run = [state, chunks, begin, end, grain, &f] {
+			uint64_t c;
+			while ((c = state->next.fetch_add(1)) < chunks) {
+				if (!state->failed.load()) {
+					uint64_t lo = begin + c * grain;
+					uint64_t hi = lo + grain < end ? lo + grain : end;
+					try {
+						for (uint64_t i = lo; i < hi; ++i) {
+							f(i);
+						}
+					}
+					catch (...) {
+						std::lock_guard<std::mutex> lock(state->mutex);
+						if (!state->failed.exchange(true)) {
+							state->error = std::current_exception();
+						}
+					}
+				}
+				if (state->done.fetch_add(1) + 1 == chunks) {
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->cv.notify_all();
+				}
+			}
+		};
+
+		// helpers that start after the work is gone only touch the shared state
+		size_t helpers = workers.size() - 1 < chunks - 1 ? workers.size() - 1 : chunks - 1;
+		for (size_t h = 0; h < helpers; ++h) {
+			Post([state, chunks, run] {
+				if (state->next.load() < chunks) {
+					run();
+				}
+			});
+		}
+		run();
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->cv.wait(lock, [&] { return state->done.load() == chunks; });
+		if (state->error) {
+			std::rethrow_exception(state->error);
+		}
+	}
+
+	static ThreadPool& Shared() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+private:
+	void _worker_loop() {
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [this] { return stop || !jobs.empty(); });
+				if (stop && jobs.empty()) {
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			// Submit hands exceptions to its future, anything else has nowhere to go
+			try {
+				job();
+			}
+			catch (const std::exception& ex) {
+				merror(ex.what(), SEVERE);
+			}
+			catch (...) {
+				merror("Unknown exception in a pool job!", SEVERE);
+			}
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool stop;
+};
+
+#endif
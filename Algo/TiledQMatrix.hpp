@@ -0,0 +1,637 @@
+#ifndef _TILED_QMATRIX_H
+#define _TILED_QMATRIX_H
+
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+/*
+	Out-of-core matrix stored as square tiles in a file on local disk.
+
+	Tile (ti, tj) is a tile x tile row-major block at offset
+	(ti * TileCols() + tj) * tile * tile * sizeof(T); edge tiles are padded.
+	At most cache_tiles tiles are held in memory, evicted least recently used
+	(dirty tiles are written back without holding the cache lock). A background
+	thread loads tiles requested through Prefetch() so the next tiles arrive
+	while the current ones are used.
+
+	Size the cache for the access pattern: TiledGemm keeps about one tile row
+	of a plus three tiles hot, TiledLU about two tile rows.
+*/
+
+enum class TileFile {
+	Create,
+	Open
+};
+
+template<typename T> class TiledQMatrix;
+
+// pins a tile in the cache for as long as it lives
+template<typename T>
+class TileHandle {
+public:
+	TileHandle(TiledQMatrix<T>* owner, uint64_t idx, T* data, uint64_t rows, uint64_t cols, uint64_t ld) :
+		owner(owner), idx(idx), data(data), rows(rows), cols(cols), ld(ld) {}
+	~TileHandle() {
+		if (owner != nullptr) {
+			owner->Unpin(idx);
+		}
+	}
+
+	TileHandle(const TileHandle&) = delete;
+	TileHandle& operator=(const TileHandle&) = delete;
+	TileHandle(TileHandle&& other) noexcept :
+		owner(other.owner), idx(other.idx), data(other.data), rows(other.rows), cols(other.cols), ld(other.ld) {
+		other.owner = nullptr;
+	}
+
+	T* Data() const noexcept { return data; }
+	uint64_t Rows() const noexcept { return rows; }
+	uint64_t Cols() const noexcept { return cols; }
+	uint64_t Ld() const noexcept { return ld; }
+
+	QMatrixView<T> View() const noexcept {
+		return QMatrixView<T>(data, rows, cols, SAFE_INT(ld), 1);
+	}
+
+private:
+	TiledQMatrix<T>* owner;
+	uint64_t idx;
+	T* data;
+	uint64_t rows, cols, ld;
+};
+
+template<typename T>
+class TiledQMatrix {
+public:
+	TiledQMatrix(const std::string& path, uint64_t n, uint64_t m, uint64_t tile = 1024,
+		uint64_t cache_tiles = 16, TileFile mode = TileFile::Create);
+	~TiledQMatrix();
+
+	TiledQMatrix(const TiledQMatrix<T>&) = delete;
+	TiledQMatrix<T>& operator=(const TiledQMatrix<T>&) = delete;
+
+	uint64_t GetN() const noexcept { return n; }
+	uint64_t GetM() const noexcept { return m; }
+	uint64_t GetTile() const noexcept { return tile; }
+	const std::string& GetPath() const noexcept { return path; }
+	uint64_t TileRows() const noexcept { return (n + tile - 1) / tile; }
+	uint64_t TileCols() const noexcept { return (m + tile - 1) / tile; }
+	uint64_t TileHeight(uint64_t ti) const noexcept { return ti + 1 < TileRows() ? tile : n - ti * tile; }
+	uint64_t TileWidth(uint64_t tj) const noexcept { return tj + 1 < TileCols() ? tile : m - tj * tile; }
+
+	// write marks the tile dirty so it is stored again on eviction
+	TileHandle<T> Tile(uint64_t ti, uint64_t tj, bool write = false);
+	void Prefetch(uint64_t ti, uint64_t tj);
+	void Flush();
+
+	T GetItem(uint64_t i, uint64_t j);
+	void SetItem(uint64_t i, uint64_t j, T value);
+
+	void Load(QMatrixView<const T> src);
+	QMatrix<T> ToQMatrix();
+
+	void Unpin(uint64_t idx);
+
+private:
+	struct Slot {
+		std::unique_ptr<T[]> buf;
+		bool dirty = false;
+		bool ready = false;
+		uint32_t pins = 0;
+		std::list<uint64_t>::iterator lru;
+	};
+
+	Slot& _insert(uint64_t idx);
+	bool _make_room(std::unique_lock<std::mutex>& lock);
+	void _read_tile(uint64_t idx, T* dst);
+	void _write_tile(uint64_t idx, const T* src);
+	void _prefetch_loop();
+
+	uint64_t n, m, tile, capacity;
+	std::string path;
+
+	std::fstream file;
+	std::mutex io_mutex;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::unordered_map<uint64_t, Slot> slots;
+	// evicted dirty tiles still being written back, not to be read again until done
+	std::unordered_set<uint64_t> writing;
+	std::list<uint64_t> lru;
+	std::deque<uint64_t> pending;
+	bool stop;
+	bool over_capacity_reported;
+	std::thread prefetcher;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+TiledQMatrix<T>::TiledQMatrix(const std::string& path, uint64_t n, uint64_t m, uint64_t tile,
+    uint64_t cache_tiles, TileFile mode) :
+    n(n), m(m), tile(tile == 0 ? 1 : tile), capacity(cache_tiles < 1 ? 1 : cache_tiles), path(path),
+    stop(false), over_capacity_reported(false) {
+
+    std::ios::openmode flags = std::ios::in | std::ios::out | std::ios::binary;
+    if (mode == TileFile::Create) {
+        flags |= std::ios::trunc;
+    }
+    file.open(path, flags);
+    if (!file.is_open()) {
+        merror("Cannot open tile file!", CRITICAL);
+    }
+    else if (mode == TileFile::Create) {
+        // reserve the full size up front, untouched tiles read back as zeros
+        uint64_t bytes = TileRows() * TileCols() * this->tile * this->tile * sizeof(T);
+        if (bytes > 0) {
+            file.seekp(static_cast<std::streamoff>(bytes - 1));
+            file.put('\0');
+            file.flush();
+        }
+    }
+
+    prefetcher = std::thread(&TiledQMatrix<T>::_prefetch_loop, this);
+}
+
+template<typename T>
+TiledQMatrix<T>::~TiledQMatrix() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    prefetcher.join();
+    Flush();
+}
+
+template<typename T>
+void TiledQMatrix<T>::_read_tile(uint64_t idx, T* dst) {
+    std::lock_guard<std::mutex> lock(io_mutex);
+    file.seekg(static_cast<std::streamoff>(idx * tile * tile * sizeof(T)));
+    file.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(tile * tile * sizeof(T)));
+    if (!file) {
+        file.clear();
+        merror("Short read from tile file, filling tile with zeros", WARN);
+        memset(dst, 0, SAFE_UINT(tile * tile * sizeof(T)));
+    }
+}
+
+template<typename T>
+void TiledQMatrix<T>::_write_tile(uint64_t idx, const T* src) {
+    std::lock_guard<std::mutex> lock(io_mutex);
+    file.seekp(static_cast<std::streamoff>(idx * tile * tile * sizeof(T)));
+    file.write(reinterpret_cast<const char*>(src), static_cast<std::streamsize>(tile * tile * sizeof(T)));
+    if (!file) {
+        file.clear();
+        merror("Failed to write tile back to disk!", CRITICAL);
+    }
+}
+
+/*
+    Called with mutex held through lock; evicts unpinned tiles until there is a
+    free slot. Dirty tiles leave the cache first and are written back with the
+    lock released, so the cache may have changed when this returns.
+*/
+template<typename T>
+bool TiledQMatrix<T>::_make_room(std::unique_lock<std::mutex>& lock) {
+    while (slots.size() >= capacity) {
+        auto victim = lru.end();
+        for (auto it = lru.rbegin(); it != lru.rend(); ++it) {
+            Slot& s = slots.at(*it);
+            if (s.pins == 0 && s.ready) {
+                victim = std::next(it).base();
+                break;
+            }
+        }
+        if (victim == lru.end()) {
+            return false;
+        }
+
+        uint64_t idx = *victim;
+        Slot& s = slots.at(idx);
+        std::unique_ptr<T[]> buf = std::move(s.buf);
+        bool dirty = s.dirty;
+        lru.erase(victim);
+        slots.erase(idx);
+
+        if (dirty) {
+            writing.insert(idx);
+            lock.unlock();
+            _write_tile(idx, buf.get());
+            lock.lock();
+            writing.erase(idx);
+            cv.notify_all();
+        }
+    }
+
+    return true;
+}
+
+// called with mutex held; the new slot is pinned and not ready yet
+template<typename T>
+typename TiledQMatrix<T>::Slot& TiledQMatrix<T>::_insert(uint64_t idx) {
+    Slot& s = slots[idx];
+    ALLOC_TRY(s.buf.reset(new T[SAFE_UINT(tile * tile)]));
+    s.pins = 1;
+    lru.push_front(idx);
+    s.lru = lru.begin();
+    return s;
+}
+
+template<typename T>
+TileHandle<T> TiledQMatrix<T>::Tile(uint64_t ti, uint64_t tj, bool write) {
+    uint64_t idx = ti * TileCols() + tj;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    Slot* s = nullptr;
+    while (s == nullptr) {
+        cv.wait(lock, [this, idx] { return writing.count(idx) == 0; });
+        auto it = slots.find(idx);
+        if (it != slots.end()) {
+            s = &it->second;
+            s->pins++;
+            cv.wait(lock, [s] { return s->ready; });
+            lru.splice(lru.begin(), lru, s->lru);
+            break;
+        }
+
+        if (!_make_room(lock) && !over_capacity_reported) {
+            // every cached tile is pinned, go over budget rather than deadlock
+            over_capacity_reported = true;
+            merror("Tile cache too small for the pinned working set, growing it", WARN);
+        }
+        // the lock may have been released for a writeback, look again
+        if (slots.count(idx) != 0 || writing.count(idx) != 0) {
+            continue;
+        }
+        s = &_insert(idx);
+
+        lock.unlock();
+        _read_tile(idx, s->buf.get());
+        lock.lock();
+
+        s->ready = true;
+        cv.notify_all();
+    }
+
+    if (write) {
+        s->dirty = true;
+    }
+
+    return TileHandle<T>(this, idx, s->buf.get(), TileHeight(ti), TileWidth(tj), tile);
+}
+
+template<typename T>
+void TiledQMatrix<T>::Unpin(uint64_t idx) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = slots.find(idx);
+    if (it != slots.end() && it->second.pins > 0) {
+        it->second.pins--;
+    }
+}
+
+template<typename T>
+void TiledQMatrix<T>::Prefetch(uint64_t ti, uint64_t tj) {
+    if (ti >= TileRows() || tj >= TileCols()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(ti * TileCols() + tj);
+    }
+    cv.notify_all();
+}
+
+template<typename T>
+void TiledQMatrix<T>::_prefetch_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] { return stop || !pending.empty(); });
+        if (stop) {
+            return;
+        }
+
+        uint64_t idx = pending.front();
+        pending.pop_front();
+
+        // a prefetch never pushes out pinned work, it is simply dropped
+        if (slots.count(idx) != 0 || writing.count(idx) != 0 || !_make_room(lock)) {
+            continue;
+        }
+        // _make_room may have released the lock for a writeback
+        if (stop || slots.count(idx) != 0 || writing.count(idx) != 0) {
+            continue;
+        }
+
+        Slot& s = _insert(idx);
+
+        lock.unlock();
+        _read_tile(idx, s.buf.get());
+        lock.lock();
+
+        s.ready = true;
+        s.pins--;
+        cv.notify_all();
+    }
+}
+
+template<typename T>
+void TiledQMatrix<T>::Flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return writing.empty(); });
+    for (auto& [idx, s] : slots) {
+        if (s.ready && s.dirty) {
+            _write_tile(idx, s.buf.get());
+            s.dirty = false;
+        }
+    }
+    std::lock_guard<std::mutex> io_lock(io_mutex);
+    file.flush();
+}
+
+template<typename T>
+T TiledQMatrix<T>::GetItem(uint64_t i, uint64_t j) {
+    TileHandle<T> h = Tile(i / tile, j / tile);
+    return h.Data()[(i % tile) * tile + (j % tile)];
+}
+
+template<typename T>
+void TiledQMatrix<T>::SetItem(uint64_t i, uint64_t j, T value) {
+    TileHandle<T> h = Tile(i / tile, j / tile, true);
+    h.Data()[(i % tile) * tile + (j % tile)] = value;
+}
+
+template<typename T>
+void TiledQMatrix<T>::Load(QMatrixView<const T> src) {
+    if (src.GetN() != n || src.GetM() != m) {
+        merror("Cannot load a matrix with different dimensions into a tiled matrix!", E_MAT_INVALID_DIMENSION);
+        return;
+    }
+    for (uint64_t ti = 0; ti < TileRows(); ++ti) {
+        for (uint64_t tj = 0; tj < TileCols(); ++tj) {
+            TileHandle<T> h = Tile(ti, tj, true);
+            Copy<T>(src.Sub(ti * tile, tj * tile, h.Rows(), h.Cols()), h.View());
+        }
+    }
+}
+
+template<typename T>
+QMatrix<T> TiledQMatrix<T>::ToQMatrix() {
+    std::unique_ptr<T[]> _tmp_nums;
+    ALLOC_TRY(_tmp_nums.reset(new T[SAFE_UINT(n * m)]));
+    QMatrixView<T> dst = QMatrixView<T>::Of(_tmp_nums.get(), n, m, Layout::RowMajor);
+    for (uint64_t ti = 0; ti < TileRows(); ++ti) {
+        for (uint64_t tj = 0; tj < TileCols(); ++tj) {
+            Prefetch(ti, tj + 1);
+            TileHandle<T> h = Tile(ti, tj);
+            Copy<T>(h.View(), dst.Sub(ti * tile, tj * tile, h.Rows(), h.Cols()));
+        }
+    }
+    return QMatrix<T>(_tmp_nums.get(), n, m);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+bool _same_tiling(const TiledQMatrix<T>& a, const TiledQMatrix<T>& b) {
+    return a.GetTile() == b.GetTile();
+}
+
+// c = a * b, streaming one tile row of a against one tile column of b; c must not share storage with a or b
+template<typename T>
+void TiledGemm(TiledQMatrix<T>& a, TiledQMatrix<T>& b, TiledQMatrix<T>& c) {
+    if (a.GetM() != b.GetN() || c.GetN() != a.GetN() || c.GetM() != b.GetM()) {
+        merror("Cannot multiply tiled matrices with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+        return;
+    }
+    // c tiles are zeroed before accumulating, which would destroy tiles of a or b still needed
+    if (&c == &a || &c == &b || c.GetPath() == a.GetPath() || c.GetPath() == b.GetPath()) {
+        merror("Tiled product cannot be written into one of its operands!", E_MAT_INVALID_DIMENSION);
+        return;
+    }
+    if (!_same_tiling(a, b) || !_same_tiling(a, c)) {
+        merror("Tiled matrices must share the tile size!", E_MAT_INVALID_DIMENSION);
+        return;
+    }
+
+    uint64_t tile = a.GetTile();
+    uint64_t tk_count = a.TileCols();
+
+    std::unique_ptr<T[]> _tmp;
+    ALLOC_TRY(_tmp.reset(new T[SAFE_UINT(tile * tile)]));
+
+    for (uint64_t ti = 0; ti < c.TileRows(); ++ti) {
+        for (uint64_t tj = 0; tj < c.TileCols(); ++tj) {
+            TileHandle<T> hc = c.Tile(ti, tj, true);
+            QMatrixView<T> cv = hc.View();
+            for (uint64_t i = 0; i < hc.Rows(); ++i) {
+                for (uint64_t j = 0; j < hc.Cols(); ++j) {
+                    cv(i, j) = static_cast<T>(0);
+                }
+            }
+
+            for (uint64_t tk = 0; tk < tk_count; ++tk) {
+                if (tk + 1 < tk_count) {
+                    a.Prefetch(ti, tk + 1);
+                    b.Prefetch(tk + 1, tj);
+                }
+                else {
+                    a.Prefetch(ti + (tj + 1 == c.TileCols() ? 1 : 0), 0);
+                    b.Prefetch(0, tj + 1 == c.TileCols() ? 0 : tj + 1);
+                }
+
+                TileHandle<T> ha = a.Tile(ti, tk);
+                TileHandle<T> hb = b.Tile(tk, tj);
+                QMatrixView<T> tv(_tmp.get(), hc.Rows(), hc.Cols(), SAFE_INT(tile), 1);
+                Gemm<T>(ha.View(), hb.View(), tv);
+                for (uint64_t i = 0; i < hc.Rows(); ++i) {
+                    _axpy<T>(hc.Cols(), static_cast<T>(1), &tv(i, 0), &cv(i, 0));
+                }
+            }
+        }
+    }
+}
+
+// in-place LU without pivoting of a single in-memory tile: unit L below the diagonal, U on and above
+template<typename T>
+void _lu_tile(QMatrixView<T> a) {
+    uint64_t n = a.GetN();
+    for (uint64_t k = 0; k < n; ++k) {
+        T pivot = a(k, k);
+        if (pivot == static_cast<T>(0)) {
+            merror("Zero pivot in tiled LU-decomposition!", SEVERE);
+            return;
+        }
+        for (uint64_t i = k + 1; i < n; ++i) {
+            T l = a(i, k) / pivot;
+            a(i, k) = l;
+            _axpy<T>(n - k - 1, -l, &a(k, k + 1), &a(i, k + 1));
+        }
+    }
+}
+
+// b = L^-1 * b with L unit lower triangular
+template<typename T>
+void _trsm_lower_unit(QMatrixView<const T> l, QMatrixView<T> b) {
+    for (uint64_t i = 0; i < b.GetN(); ++i) {
+        for (uint64_t k = 0; k < i; ++k) {
+            _axpy<T>(b.GetM(), -l(i, k), &b(k, 0), &b(i, 0));
+        }
+    }
+}
+
+// b = b * U^-1 with U upper triangular
+template<typename T>
+void _trsm_upper_right(QMatrixView<const T> u, QMatrixView<T> b) {
+    uint64_t n = u.GetN();
+    for (uint64_t r = 0; r < b.GetN(); ++r) {
+        for (uint64_t j = 0; j < n; ++j) {
+            b(r, j) /= u(j, j);
+            if (j + 1 < n) {
+                _axpy<T>(n - j - 1, -b(r, j), &u(j, j + 1), &b(r, j + 1));
+            }
+        }
+    }
+}
+
+/*
+	Right-looking blocked LU without pivoting, in place: afterwards every tile holds
+	the unit lower L below the diagonal and U on and above it, like the tiles of
+	a single packed factor. There is no pivoting, which is fine for the
+	diagonally dominant and SPD matrices this is meant for.
+*/
+template<typename T>
+void TiledLU(TiledQMatrix<T>& a) {
+    if (a.GetN() != a.GetM()) {
+        merror("Cannot apply LU-decomposition to non-square matrix!", E_MAT_INVALID_DIMENSION);
+        return;
+    }
+
+    uint64_t tile = a.GetTile();
+    uint64_t tn = a.TileRows();
+
+    std::unique_ptr<T[]> _tmp;
+    ALLOC_TRY(_tmp.reset(new T[SAFE_UINT(tile * tile)]));
+
+    for (uint64_t k = 0; k < tn; ++k) {
+        TileHandle<T> hkk = a.Tile(k, k, true);
+        _lu_tile<T>(hkk.View());
+
+        for (uint64_t j = k + 1; j < tn; ++j) {
+            a.Prefetch(k, j + 1);
+            TileHandle<T> hkj = a.Tile(k, j, true);
+            _trsm_lower_unit<T>(hkk.View(), hkj.View());
+        }
+        for (uint64_t i = k + 1; i < tn; ++i) {
+            a.Prefetch(i + 1, k);
+            TileHandle<T> hik = a.Tile(i, k, true);
+            _trsm_upper_right<T>(hkk.View(), hik.View());
+        }
+
+        // trailing update a_ij -= a_ik * a_kj
+        for (uint64_t i = k + 1; i < tn; ++i) {
+            TileHandle<T> hik = a.Tile(i, k);
+            for (uint64_t j = k + 1; j < tn; ++j) {
+                a.Prefetch(i, j + 1);
+                TileHandle<T> hkj = a.Tile(k, j);
+                TileHandle<T> hij = a.Tile(i, j, true);
+                QMatrixView<T> tv(_tmp.get(), hij.Rows(), hij.Cols(), SAFE_INT(tile), 1);
+                Gemm<T>(hik.View(), hkj.View(), tv);
+                QMatrixView<T> dst = hij.View();
+                for (uint64_t r = 0; r < hij.Rows(); ++r) {
+                    _axpy<T>(hij.Cols(), static_cast<T>(-1), &tv(r, 0), &dst(r, 0));
+                }
+            }
+        }
+    }
+}
+
+// determinant of a matrix already factored in place by TiledLU
+template<typename T>
+typename QMatrix<T>::DetType TiledLUDet(TiledQMatrix<T>& lu) {
+    using D = typename QMatrix<T>::DetType;
+    D det = static_cast<D>(1);
+    for (uint64_t k = 0; k < lu.TileRows(); ++k) {
+        lu.Prefetch(k + 1, k + 1);
+        TileHandle<T> h = lu.Tile(k, k);
+        QMatrixView<T> v = h.View();
+        for (uint64_t i = 0; i < h.Rows(); ++i) {
+            det *= static_cast<D>(v(i, i));
+        }
+    }
+    return det;
+}
+
+// c(i, j) = f(a(i, j)); c may be a itself
+template<typename T, typename F>
+void TiledMap(TiledQMatrix<T>& a, TiledQMatrix<T>& c, F f) {
+    if (a.GetN() != c.GetN() || a.GetM() != c.GetM() || !_same_tiling(a, c)) {
+        merror("Cannot map between tiled matrices with different shapes!", E_MAT_INVALID_DIMENSION);
+        return;
+    }
+    for (uint64_t ti = 0; ti < a.TileRows(); ++ti) {
+        for (uint64_t tj = 0; tj < a.TileCols(); ++tj) {
+            uint64_t ni = tj + 1 == a.TileCols() ? ti + 1 : ti;
+            uint64_t nj = tj + 1 == a.TileCols() ? 0 : tj + 1;
+            a.Prefetch(ni, nj);
+            if (&c != &a) {
+                c.Prefetch(ni, nj);
+            }
+
+            TileHandle<T> ha = a.Tile(ti, tj);
+            TileHandle<T> hc = c.Tile(ti, tj, true);
+            QMatrixView<T> av = ha.View();
+            QMatrixView<T> cv = hc.View();
+            for (uint64_t i = 0; i < ha.Rows(); ++i) {
+                for (uint64_t j = 0; j < ha.Cols(); ++j) {
+                    cv(i, j) = f(av(i, j));
+                }
+            }
+        }
+    }
+}
+
+// c(i, j) = f(a(i, j), b(i, j)); c may alias a or b
+template<typename T, typename F>
+void TiledZip(TiledQMatrix<T>& a, TiledQMatrix<T>& b, TiledQMatrix<T>& c, F f) {
+    if (a.GetN() != b.GetN() || a.GetM() != b.GetM() || a.GetN() != c.GetN() || a.GetM() != c.GetM()
+        || !_same_tiling(a, b) || !_same_tiling(a, c)) {
+        merror("Cannot combine tiled matrices with different shapes!", E_MAT_INVALID_DIMENSION);
+        return;
+    }
+    for (uint64_t ti = 0; ti < a.TileRows(); ++ti) {
+        for (uint64_t tj = 0; tj < a.TileCols(); ++tj) {
+            uint64_t ni = tj + 1 == a.TileCols() ? ti + 1 : ti;
+            uint64_t nj = tj + 1 == a.TileCols() ? 0 : tj + 1;
+            a.Prefetch(ni, nj);
+            b.Prefetch(ni, nj);
+
+            TileHandle<T> ha = a.Tile(ti, tj);
+            TileHandle<T> hb = b.Tile(ti, tj);
+            TileHandle<T> hc = c.Tile(ti, tj, true);
+            QMatrixView<T> av = ha.View();
+            QMatrixView<T> bv = hb.View();
+            QMatrixView<T> cv = hc.View();
+            for (uint64_t i = 0; i < ha.Rows(); ++i) {
+                for (uint64_t j = 0; j < ha.Cols(); ++j) {
+                    cv(i, j) = f(av(i, j), bv(i, j));
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,315 @@
+#ifndef _UPDATABLE_LU_H
+#define _UPDATABLE_LU_H
+
+#include "MatrixError.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include <stdint.h>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+/*
+	LU factorization that follows low-rank changes of its matrix.
+
+	The O(n^3) factorization P A = L U is done once; afterwards
+
+	  Update(u, v)          A += u v^T, factors updated in place in O(n^2) (Bennett)
+	  ReplaceRow/ReplaceCol one row or column of A swapped, as a rank-1 update
+	  DetRatio(u, v)        det(A + u v^T) / det A = 1 + v^T A^-1 u (determinant lemma)
+	  SolveWoodbury(U, V)   (A + U V^T) x = b against the current factors without
+	                        touching them (Sherman-Morrison-Woodbury), O(k n^2 + k^3)
+
+	L is kept transposed so both the column of L and the row of U touched by each
+	Bennett step are contiguous and go through the dispatched axpy kernel. Bennett's
+	update does not pivot, so the factors are rebuilt from the (always exact) copy of A
+	when a pivot cancels, and optionally every refactor_every updates to bound drift.
+*/
+
+template<typename T>
+class UpdatableLU {
+	static_assert(std::is_floating_point_v<T> || _is_complex<T>::value,
+		"UpdatableLU needs a floating point or complex element type");
+
+public:
+	using DetType = typename QMatrix<T>::DetType;
+
+	explicit UpdatableLU(const QMatrix<T>& a, uint64_t refactor_every = 0)
+		: a(a), u(a), lt(a), n(a.GetN()), refactor_every(refactor_every), updates(0) {
+		if (!a.IsSquare()) {
+			merror("Cannot apply LU-decomposition to non-square matrix!", E_MAT_INVALID_DIMENSION);
+		}
+		_factor();
+	}
+
+	uint64_t GetN() const noexcept { return n; }
+	const QMatrix<T>& Matrix() const noexcept { return a; }
+	uint64_t Updates() const noexcept { return updates; }
+
+	DetType Det() const {
+		DetType det = static_cast<DetType>(sign);
+		for (uint64_t k = 0; k < n; ++k) {
+			det *= static_cast<DetType>(_u(k, k));
+		}
+		return det;
+	}
+
+	// log |det A|, for sizes where the determinant itself over- or underflows
+	double LogAbsDet() const {
+		double res = 0;
+		for (uint64_t k = 0; k < n; ++k) {
+			res += std::log(static_cast<double>(std::abs(_u(k, k))));
+		}
+		return res;
+	}
+
+	// x with A x = b, b is n x r
+	QMatrix<T> Solve(const QMatrix<T>& b) const {
+		if (b.GetN() != n) {
+			merror("Cannot solve with a right-hand side of invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		QMatrix<T> x = b;
+		QMatrixView<T> xv = x.View();
+		std::vector<T> col(SAFE_UINT(n));
+		for (uint64_t j = 0; j < b.GetM(); ++j) {
+			for (uint64_t i = 0; i < n; ++i) {
+				col[i] = xv(i, j);
+			}
+			_solve_in_place(col.data());
+			for (uint64_t i = 0; i < n; ++i) {
+				xv(i, j) = col[i];
+			}
+		}
+		return x;
+	}
+
+	// 1 + v^T A^-1 u
+	DetType DetRatio(const T* du, const T* dv) const {
+		std::vector<T> w(du, du + n);
+		_solve_in_place(w.data());
+		return static_cast<DetType>(static_cast<T>(1) + _dot<T>(n, dv, w.data()));
+	}
+
+	// det(I + V^T A^-1 U) for n x k U, V
+	DetType DetRatio(const QMatrix<T>& du, const QMatrix<T>& dv) const {
+		QMatrix<T> cap = _capacitance(du, dv);
+		std::vector<uint32_t> piv(SAFE_UINT(cap.GetN()));
+		return _lu_pivot_in_place(cap.View(), piv.data());
+	}
+
+	/*
+		A += u v^T. Returns false if A became numerically singular, the factors
+		still describe the updated A then but Solve is meaningless.
+	*/
+	bool Update(const T* du, const T* dv) {
+		QMatrixView<T> av = a.View();
+		for (uint64_t i = 0; i < n; ++i) {
+			if (du[i] != static_cast<T>(0)) {
+				_axpy<T>(n, du[i], dv, &av(i, 0));
+			}
+		}
+
+		++updates;
+		if (refactor_every != 0 && updates % refactor_every == 0) {
+			return _factor();
+		}
+
+		// Bennett on L U + x y^T with x = P u
+		std::vector<T> x(SAFE_UINT(n));
+		std::vector<T> y(dv, dv + n);
+		for (uint64_t i = 0; i < n; ++i) {
+			x[i] = du[perm[i]];
+		}
+
+		QMatrixView<T> uv = u.View();
+		QMatrixView<T> lv = lt.View();
+		const double eps = std::numeric_limits<double>::epsilon();
+		for (uint64_t k = 0; k < n; ++k) {
+			T* _u_row = &uv(k, 0);
+			T* _l_col = &lv(k, 0);
+			T xk = x[k];
+			T ukk = _u_row[k] + xk * y[k];
+
+			// cancellation in the pivot, Bennett would amplify it through the rest of the factors
+			double scale = std::abs(_u_row[k]) + std::abs(xk * y[k]);
+			if (std::abs(ukk) <= 64 * eps * scale || ukk == static_cast<T>(0)) {
+				return _factor();
+			}
+
+			T beta = y[k] / ukk;
+			_u_row[k] = ukk;
+			uint64_t rest = n - k - 1;
+			if (xk != static_cast<T>(0)) {
+				_axpy<T>(rest, xk, y.data() + k + 1, _u_row + k + 1);
+				_axpy<T>(rest, -xk, _l_col + k + 1, x.data() + k + 1);
+			}
+			if (beta != static_cast<T>(0)) {
+				_axpy<T>(rest, -beta, _u_row + k + 1, y.data() + k + 1);
+				_axpy<T>(rest, beta, x.data() + k + 1, _l_col + k + 1);
+			}
+		}
+		return true;
+	}
+
+	// A += U V^T for n x k U, V, as k rank-1 updates
+	bool Update(const QMatrix<T>& du, const QMatrix<T>& dv) {
+		if (du.GetN() != n || dv.GetN() != n || du.GetM() != dv.GetM()) {
+			merror("Low-rank update factors have invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return false;
+		}
+		std::vector<T> uc(SAFE_UINT(n)), vc(SAFE_UINT(n));
+		bool ok = true;
+		for (uint64_t j = 0; j < du.GetM(); ++j) {
+			for (uint64_t i = 0; i < n; ++i) {
+				uc[i] = du.GetItem(i, j);
+				vc[i] = dv.GetItem(i, j);
+			}
+			ok = Update(uc.data(), vc.data()) && ok;
+		}
+		return ok;
+	}
+
+	bool ReplaceRow(uint64_t i, const T* row) {
+		std::vector<T> e(SAFE_UINT(n), static_cast<T>(0));
+		std::vector<T> d(SAFE_UINT(n));
+		QMatrixView<const T> av = a.View();
+		for (uint64_t j = 0; j < n; ++j) {
+			d[j] = row[j] - av(i, j);
+		}
+		e[i] = static_cast<T>(1);
+		return Update(e.data(), d.data());
+	}
+
+	bool ReplaceCol(uint64_t j, const T* col) {
+		std::vector<T> e(SAFE_UINT(n), static_cast<T>(0));
+		std::vector<T> d(SAFE_UINT(n));
+		QMatrixView<const T> av = a.View();
+		for (uint64_t i = 0; i < n; ++i) {
+			d[i] = col[i] - av(i, j);
+		}
+		e[j] = static_cast<T>(1);
+		return Update(d.data(), e.data());
+	}
+
+	// x with (A + U V^T) x = b, the factors of A stay as they are
+	QMatrix<T> SolveWoodbury(const QMatrix<T>& du, const QMatrix<T>& dv, const QMatrix<T>& b) const {
+		if (du.GetN() != n || dv.GetN() != n || du.GetM() != dv.GetM() || b.GetN() != n) {
+			merror("Woodbury solve with invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return b;
+		}
+		uint64_t k = du.GetM();
+
+		// x = A^-1 b - A^-1 U (I + V^T A^-1 U)^-1 V^T A^-1 b
+		QMatrix<T> z = Solve(du);
+		QMatrix<T> x = Solve(b);
+		QMatrix<T> cap = _capacitance_from(z, dv);
+		std::vector<uint32_t> piv(SAFE_UINT(k));
+		_lu_pivot_in_place(cap.View(), piv.data());
+
+		QMatrixView<T> xv = x.View();
+		QMatrixView<const T> zv = z.View();
+		QMatrixView<const T> dvv = dv.View();
+		QMatrixView<const T> cv = cap.View();
+		std::vector<T> s(SAFE_UINT(k));
+		for (uint64_t c = 0; c < b.GetM(); ++c) {
+			for (uint64_t j = 0; j < k; ++j) {
+				T acc = static_cast<T>(0);
+				for (uint64_t i = 0; i < n; ++i) {
+					acc += dvv(i, j) * xv(i, c);
+				}
+				s[j] = acc;
+			}
+			_lu_pivot_solve(cv, piv.data(), s.data());
+			for (uint64_t i = 0; i < n; ++i) {
+				T acc = static_cast<T>(0);
+				for (uint64_t j = 0; j < k; ++j) {
+					acc += zv(i, j) * s[j];
+				}
+				xv(i, c) -= acc;
+			}
+		}
+		return x;
+	}
+
+private:
+	QMatrix<T> a;   // current matrix, updated exactly
+	QMatrix<T> u;   // U in the upper triangle
+	QMatrix<T> lt;  // L^T in the strict upper triangle, row k is column k of L
+	std::vector<uint64_t> perm;  // row i of P A is row perm[i] of A
+	int sign;
+	uint64_t n;
+	uint64_t refactor_every;
+	uint64_t updates;
+
+	T _u(uint64_t i, uint64_t j) const { return u.View()(i, j); }
+
+	bool _factor() {
+		QMatrix<T> lu = a;
+		std::vector<uint32_t> piv(SAFE_UINT(n));
+		DetType det = _lu_pivot_in_place(lu.View(), piv.data());
+
+		perm.resize(SAFE_UINT(n));
+		for (uint64_t i = 0; i < n; ++i) {
+			perm[i] = i;
+		}
+		sign = 1;
+		for (uint64_t i = 0; i < n; ++i) {
+			if (piv[i] != i) {
+				std::swap(perm[i], perm[piv[i]]);
+				sign = -sign;
+			}
+		}
+
+		QMatrixView<const T> luv = lu.View();
+		QMatrixView<T> uv = u.View();
+		QMatrixView<T> lv = lt.View();
+		for (uint64_t i = 0; i < n; ++i) {
+			for (uint64_t j = 0; j < n; ++j) {
+				uv(i, j) = j >= i ? luv(i, j) : static_cast<T>(0);
+				lv(i, j) = j > i ? luv(j, i) : static_cast<T>(0);
+			}
+		}
+		return det != static_cast<DetType>(0);
+	}
+
+	// A^-1 w in place
+	void _solve_in_place(T* w) const {
+		std::vector<T> y(SAFE_UINT(n));
+		for (uint64_t i = 0; i < n; ++i) {
+			y[i] = w[perm[i]];
+		}
+		QMatrixView<const T> lv = lt.View();
+		QMatrixView<const T> uv = u.View();
+		// L is unit lower, column k of L is row k of lt
+		for (uint64_t k = 0; k + 1 < n; ++k) {
+			if (y[k] != static_cast<T>(0)) {
+				_axpy<T>(n - k - 1, -y[k], &lv(k, k + 1), y.data() + k + 1);
+			}
+		}
+		for (uint64_t k = n; k-- > 0;) {
+			T s = y[k] - _dot<T>(n - k - 1, &uv(k, k + 1), y.data() + k + 1);
+			y[k] = s / uv(k, k);
+		}
+		for (uint64_t i = 0; i < n; ++i) {
+			w[i] = y[i];
+		}
+	}
+
+	QMatrix<T> _capacitance(const QMatrix<T>& du, const QMatrix<T>& dv) const {
+		if (du.GetN() != n || dv.GetN() != n || du.GetM() != dv.GetM()) {
+			merror("Low-rank update factors have invalid dimensions!", E_MAT_INVALID_DIMENSION);
+			return I<T>(du.GetM());
+		}
+		return _capacitance_from(Solve(du), dv);
+	}
+
+	// I + V^T Z with Z = A^-1 U
+	static QMatrix<T> _capacitance_from(const QMatrix<T>& z, const QMatrix<T>& dv) {
+		return dv.Transpose() * z + I<T>(z.GetM());
+	}
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef _CHECK_H
+#define _CHECK_H
+
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include <stdint.h>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+/*
+	Minimal check harness for kalgebra_tests.
+
+	CHECK_SUITE(name) defines a suite that registers itself under name, ctest runs
+	every suite as its own test (kalgebra_tests name). A failed CHECK prints the
+	expression and keeps going, the suite fails if any check did.
+*/
+
+using CheckFn = void (*)();
+
+bool RegisterSuite(const char* name, CheckFn fn);
+void CheckFailed(const char* file, int line, const char* expr);
+
+#define CHECK_SUITE(NAME) \
+	static void _suite_##NAME(); \
+	static const bool _registered_##NAME = RegisterSuite(#NAME, _suite_##NAME); \
+	static void _suite_##NAME()
+
+#define CHECK(X) do { \
+		if (!(X)) { \
+			CheckFailed(__FILE__, __LINE__, #X); \
+		} \
+	} while (0)
+
+// |got - want| <= tol, complex values by modulus
+#define CHECK_NEAR(GOT, WANT, TOL) do { \
+		double _d = static_cast<double>(std::abs((GOT) - (WANT))); \
+		if (!(_d <= (TOL))) { \
+			CheckFailed(__FILE__, __LINE__, #GOT " ~ " #WANT); \
+			fprintf(stderr, "  off by %.3g, allowed %.3g\n", _d, static_cast<double>(TOL)); \
+		} \
+	} while (0)
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// uniform entries in [-1, 1), the same for the same seed on every run
+template<typename T>
+std::vector<T> RandomValues(uint64_t count, uint64_t seed) {
+	std::mt19937_64 rng(seed);
+	std::uniform_real_distribution<double> dist(-1.0, 1.0);
+	std::vector<T> res(SAFE_UINT(count));
+	for (T& x : res) {
+		if constexpr (_is_complex<T>::value) {
+			double re = dist(rng);
+			x = T(static_cast<typename T::value_type>(re), static_cast<typename T::value_type>(dist(rng)));
+		}
+		else {
+			x = static_cast<T>(dist(rng));
+		}
+	}
+	return res;
+}
+
+template<typename T>
+QMatrix<T> RandomQMatrix(uint64_t n, uint64_t m, uint64_t seed) {
+	std::vector<T> v = RandomValues<T>(n * m, seed);
+	return QMatrix<T>(v.data(), n, m);
+}
+
+// random plus n on the diagonal, far from singular
+template<typename T>
+QMatrix<T> RegularQMatrix(uint64_t n, uint64_t seed) {
+	std::vector<T> v = RandomValues<T>(n * n, seed);
+	for (uint64_t i = 0; i < n; ++i) {
+		v[i * n + i] += static_cast<T>(n);
+	}
+	return QMatrix<T>(v.data(), n, n);
+}
+
+template<typename T>
+QMatrix<T> DenseIdentity(uint64_t n) {
+	std::vector<T> v(SAFE_UINT(n * n), static_cast<T>(0));
+	for (uint64_t i = 0; i < n; ++i) {
+		v[i * n + i] = static_cast<T>(1);
+	}
+	return QMatrix<T>(v.data(), n, n);
+}
+
+// largest |a(i, j) - b(i, j)|, infinity on a shape mismatch
+template<typename T>
+double MaxDiff(QMatrixView<const T> a, QMatrixView<const T> b) {
+	if (a.GetN() != b.GetN() || a.GetM() != b.GetM()) {
+		return INFINITY;
+	}
+	double res = 0.0;
+	for (uint64_t i = 0; i < a.GetN(); ++i) {
+		for (uint64_t j = 0; j < a.GetM(); ++j) {
+			double d = static_cast<double>(std::abs(a(i, j) - b(i, j)));
+			res = d > res ? d : res;
+		}
+	}
+	return res;
+}
+
+template<typename T>
+double MaxDiff(const QMatrix<T>& a, const QMatrix<T>& b) {
+	return MaxDiff<T>(a.View(), b.View());
+}
+
+#endif
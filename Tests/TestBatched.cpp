@@ -0,0 +1,48 @@
+#include "BatchedQMatrix.hpp"
+#include "Check.hpp"
+#include "QMatrix.hpp"
+#include <complex>
+#include <vector>
+
+// BatchDet against Det of each matrix, over a count that leaves a partial lane group
+template<typename T>
+static void _batch_det(uint64_t n, double tol) {
+	uint64_t count = 3 * BATCH_LANES + 5;
+	QMatrixBatch<T> batch(count, n, n);
+	for (uint64_t k = 0; k < count; ++k) {
+		batch.Set(k, RandomQMatrix<T>(n, n, 60 + k));
+	}
+	std::vector<typename QMatrix<T>::DetType> det = BatchDet(batch);
+	CHECK(det.size() == count);
+	for (uint64_t k = 0; k < count && k < det.size(); ++k) {
+		typename QMatrix<T>::DetType want = batch.Get(k).Det();
+		CHECK_NEAR(det[k], want, tol * std::abs(want));
+	}
+}
+
+CHECK_SUITE(batched) {
+	_batch_det<float>(16, 1e-3);
+	_batch_det<double>(16, 1e-12);
+	_batch_det<double>(3, 1e-12);
+	_batch_det<std::complex<double>>(12, 1e-12);
+
+	// P A = L U for every matrix of an external batch with padded rows and gaps between matrices
+	uint64_t count = 11, n = 9, ld = 12, stride = 120;
+	std::vector<double> buf = RandomValues<double>(count * stride, 70);
+	QMatrixBatch<double> ext(buf.data(), count, n, n, stride, ld);
+	std::vector<QMatrix<double>> orig;
+	for (uint64_t k = 0; k < count; ++k) {
+		orig.push_back(ext.Get(k));
+	}
+	std::vector<uint32_t> piv;
+	std::vector<double> det = BatchDecomposeLU(ext, piv);
+	for (uint64_t k = 0; k < count; ++k) {
+		auto plu = BatchUnpackLU(ext, piv, k);
+		CHECK(MaxDiff(plu[0] * orig[k], plu[1] * plu[2]) <= 1e-12);
+		CHECK_NEAR(det[k], orig[k].Det(), 1e-12 * std::abs(det[k]));
+	}
+
+	// an empty external batch is valid and factors to nothing
+	QMatrixBatch<double> empty(nullptr, 0, 0, 0);
+	CHECK(BatchDecomposeLU(empty, piv).empty());
+}
@@ -0,0 +1,56 @@
+#include "Check.hpp"
+#include "ComplexQMatrix.hpp"
+#include "QMatrix.hpp"
+#include <cmath>
+#include <complex>
+#include <vector>
+
+// triple loop summed in complex<double>
+template<typename T>
+static QMatrix<std::complex<T>> _reference_product(const QMatrix<std::complex<T>>& a, const QMatrix<std::complex<T>>& b) {
+	std::vector<std::complex<T>> c(a.GetN() * b.GetM());
+	for (uint64_t i = 0; i < a.GetN(); ++i) {
+		for (uint64_t j = 0; j < b.GetM(); ++j) {
+			std::complex<double> s = 0.0;
+			for (uint64_t k = 0; k < a.GetM(); ++k) {
+				s += std::complex<double>(a.GetItem(i, k)) * std::complex<double>(b.GetItem(k, j));
+			}
+			c[i * b.GetM() + j] = std::complex<T>(s);
+		}
+	}
+	return QMatrix<std::complex<T>>(c.data(), a.GetN(), b.GetM());
+}
+
+template<typename T>
+static void _complex_products(double tol) {
+	using C = std::complex<T>;
+	QMatrix<C> a = RandomQMatrix<C>(33, 47, 51);
+	QMatrix<C> b = RandomQMatrix<C>(47, 29, 52);
+	QMatrix<C> ref = _reference_product(a, b);
+
+	// 4M on interleaved storage and 3M on split storage
+	CHECK(MaxDiff(a * b, ref) <= tol);
+	SplitComplexQMatrix<T> sa(a), sb(b);
+	CHECK(MaxDiff((sa * sb).ToQMatrix(), ref) <= tol);
+	CHECK(MaxDiff(sa.Adjoint().ToQMatrix(), a.Adjoint()) == 0.0);
+	CHECK(MaxDiff(SplitComplexQMatrix<T>(sa.Re(), sa.Im()).ToQMatrix(), a) == 0.0);
+}
+
+CHECK_SUITE(complex) {
+	_complex_products<float>(1e-4);
+	_complex_products<double>(1e-12);
+
+	// det of a rotation by theta scaled by i is i^2 = -1, and diag(i, 2) gives 2i
+	using Z = std::complex<double>;
+	double t = 0.7;
+	Z rot[] = { Z(0, std::cos(t)), Z(0, -std::sin(t)), Z(0, std::sin(t)), Z(0, std::cos(t)) };
+	CHECK_NEAR(QMatrix<Z>(rot, 2, 2).Det(), Z(-1, 0), 1e-15);
+	Z diag[] = { Z(0, 1), Z(0), Z(0), Z(2) };
+	CHECK_NEAR(QMatrix<Z>(diag, 2, 2).Det(), Z(0, 2), 0.0);
+
+	// pivoted complex LU multiplies back, det(A^H) = conj(det A)
+	QMatrix<Z> a = RandomQMatrix<Z>(20, 20, 53);
+	auto lu = a.DecomposeLU();
+	CHECK(MaxDiff(lu[0] * lu[1], a) <= 1e-12);
+	CHECK_NEAR(a.Adjoint().Det(), std::conj(a.Det()), 1e-12 * std::abs(a.Det()));
+}
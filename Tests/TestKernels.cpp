@@ -0,0 +1,57 @@
+#include "Check.hpp"
+#include "Kernels.hpp"
+#include <complex>
+#include <vector>
+
+// the dispatched table against the portable one, ctest runs this once per KALGEBRA_ISA cap
+CHECK_SUITE(kernels) {
+	const KernelTable& k = Kernels();
+	const KernelTable& g = GetKernelsGeneric();
+	printf("isa %s\n", IsaName(k.isa));
+
+	// odd lengths exercise the vector bodies and the scalar tails
+	for (uint64_t n : { 1ull, 7ull, 33ull, 1000ull }) {
+		std::vector<double> x = RandomValues<double>(n, 1), y = RandomValues<double>(n, 2);
+		std::vector<float> xf(x.begin(), x.end()), yf(y.begin(), y.end());
+		CHECK_NEAR(k.ddot(n, x.data(), y.data()), g.ddot(n, x.data(), y.data()), 1e-12 * n);
+		CHECK_NEAR(k.sdot(n, xf.data(), yf.data()), g.sdot(n, xf.data(), yf.data()), 1e-5 * n);
+
+		std::vector<double> yk = y, yg = y;
+		k.daxpy(n, 0.75, x.data(), yk.data());
+		g.daxpy(n, 0.75, x.data(), yg.data());
+		for (uint64_t i = 0; i < n; ++i) {
+			CHECK_NEAR(yk[i], yg[i], 1e-15);
+		}
+
+		std::vector<std::complex<double>> zx = RandomValues<std::complex<double>>(n, 3);
+		std::vector<std::complex<double>> zy = RandomValues<std::complex<double>>(n, 4);
+		std::complex<double> rk, rg;
+		k.zdot(n, reinterpret_cast<const double*>(zx.data()), reinterpret_cast<const double*>(zy.data()), true,
+			reinterpret_cast<double*>(&rk));
+		g.zdot(n, reinterpret_cast<const double*>(zx.data()), reinterpret_cast<const double*>(zy.data()), true,
+			reinterpret_cast<double*>(&rg));
+		CHECK_NEAR(rk, rg, 1e-12 * n);
+
+		CHECK(k.hash64(x.data(), n * sizeof(double), 5) == g.hash64(x.data(), n * sizeof(double), 5));
+	}
+
+	// ragged shapes with leading dimensions wider than the rows
+	uint64_t n = 37, m = 29, p = 45;
+	std::vector<double> a = RandomValues<double>(n * (p + 3), 6), b = RandomValues<double>(p * (m + 1), 7);
+	std::vector<double> ck(n * (m + 2), 0.0), cg(n * (m + 2), 0.0);
+	k.dgemm(n, m, p, a.data(), p + 3, b.data(), m + 1, ck.data(), m + 2);
+	g.dgemm(n, m, p, a.data(), p + 3, b.data(), m + 1, cg.data(), m + 2);
+	for (uint64_t i = 0; i < n; ++i) {
+		for (uint64_t j = 0; j < m; ++j) {
+			CHECK_NEAR(ck[i * (m + 2) + j], cg[i * (m + 2) + j], 1e-12);
+		}
+	}
+
+	std::vector<float> af(a.begin(), a.end()), bf(b.begin(), b.end());
+	std::vector<float> cfk(n * m, 0.0f), cfg(n * m, 0.0f);
+	k.sgemm(n, m, p, af.data(), p + 3, bf.data(), m + 1, cfk.data(), m);
+	g.sgemm(n, m, p, af.data(), p + 3, bf.data(), m + 1, cfg.data(), m);
+	for (uint64_t i = 0; i < n * m; ++i) {
+		CHECK_NEAR(cfk[i], cfg[i], 1e-4);
+	}
+}
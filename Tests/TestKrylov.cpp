@@ -0,0 +1,96 @@
+#include "Check.hpp"
+#include "CsrQMatrix.hpp"
+#include "Krylov.hpp"
+#include "QMatrix.hpp"
+#include <cmath>
+#include <vector>
+
+// 5 point Laplacian on a g x g grid, plus c times a first difference in x (non-symmetric for c != 0)
+static CsrQMatrix<double> _grid_operator(uint64_t g, double c) {
+	std::vector<uint64_t> rows, cols;
+	std::vector<double> v;
+	auto add = [&](uint64_t i, uint64_t j, double x) {
+		rows.push_back(i);
+		cols.push_back(j);
+		v.push_back(x);
+	};
+	for (uint64_t y = 0; y < g; ++y) {
+		for (uint64_t x = 0; x < g; ++x) {
+			uint64_t i = y * g + x;
+			add(i, i, 4.0);
+			if (x > 0) add(i, i - 1, -1.0 - c);
+			if (x + 1 < g) add(i, i + 1, -1.0 + c);
+			if (y > 0) add(i, i - g, -1.0);
+			if (y + 1 < g) add(i, i + g, -1.0);
+		}
+	}
+	return CsrQMatrix<double>::FromTriplets(g * g, g * g, rows, cols, v);
+}
+
+static double _rel_error(const std::vector<double>& x, const std::vector<double>& want) {
+	double d = 0, w = 0;
+	for (size_t i = 0; i < x.size(); ++i) {
+		d += (x[i] - want[i]) * (x[i] - want[i]);
+		w += want[i] * want[i];
+	}
+	return std::sqrt(d / w);
+}
+
+// b = A x_true for a known x_true, every solver has to find it again
+CHECK_SUITE(krylov) {
+	uint64_t g = 30, n = g * g;
+	std::vector<double> want = RandomValues<double>(n, 121);
+	KrylovOptions opt;
+	opt.tol = 1e-10;
+
+	CsrQMatrix<double> spd = _grid_operator(g, 0.0);
+	std::vector<double> b(n);
+	spd.Multiply(want.data(), b.data());
+
+	// the CSR product against the dense one
+	std::vector<double> d(n * n, 0.0);
+	for (uint64_t i = 0; i < n; ++i) {
+		for (uint64_t p = spd.RowPtr()[i]; p < spd.RowPtr()[i + 1]; ++p) {
+			d[i * n + spd.ColIdx()[p]] = spd.Values()[p];
+		}
+	}
+	QMatrix<double> dense(d.data(), n, n);
+	CHECK(MaxDiff(dense * QMatrix<double>(want.data(), n, 1), QMatrix<double>(b.data(), n, 1)) <= 1e-12);
+
+	std::vector<double> x;
+	KrylovResult r = CG(spd, b, x, opt);
+	CHECK(r.converged);
+	CHECK(_rel_error(x, want) <= 1e-8);
+
+	x.clear();
+	KrylovResult rj = CG(spd, b, x, opt, JacobiPreconditioner<double>(spd));
+	CHECK(rj.converged);
+	CHECK(_rel_error(x, want) <= 1e-8);
+
+	x.clear();
+	KrylovResult ri = CG(spd, b, x, opt, Ilu0Preconditioner<double>(spd));
+	CHECK(ri.converged && ri.iters < r.iters);
+	CHECK(_rel_error(x, want) <= 1e-8);
+
+	// convection-diffusion, non-symmetric
+	CsrQMatrix<double> ns = _grid_operator(g, 0.4);
+	ns.Multiply(want.data(), b.data());
+	x.clear();
+	KrylovResult rb = BiCGSTAB(ns, b, x, opt, Ilu0Preconditioner<double>(ns));
+	CHECK(rb.converged);
+	CHECK(_rel_error(x, want) <= 1e-8);
+
+	x.clear();
+	opt.restart = 20;
+	KrylovResult rg = GMRES(ns, b, x, opt, BlockJacobiPreconditioner<double>(ns, 30));
+	CHECK(rg.converged);
+	CHECK(_rel_error(x, want) <= 1e-8);
+
+	// dense operator with a small known system
+	QMatrix<double> a = RegularQMatrix<double>(40, 122);
+	std::vector<double> want2 = RandomValues<double>(40, 123), b2(40);
+	LinearOperator<double>(a).Apply(want2.data(), b2.data());
+	x.clear();
+	CHECK(GMRES(a, b2, x, opt).converged);
+	CHECK(_rel_error(x, want2) <= 1e-8);
+}
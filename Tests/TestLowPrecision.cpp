@@ -0,0 +1,70 @@
+#include "Check.hpp"
+#include "Kernels.hpp"
+#include "LowPrecision.hpp"
+#include "QMatrix.hpp"
+#include "QuantizedQMatrix.hpp"
+#include <stdint.h>
+#include <vector>
+
+// exact x . y taken modulo 2^32, what dot_i8 / dot_i16 return on every kernel set
+template<typename Q>
+static int32_t _wrapped_dot(const std::vector<Q>& x, const std::vector<Q>& y) {
+	int64_t s = 0;
+	for (size_t i = 0; i < x.size(); ++i) {
+		s += static_cast<int64_t>(x[i]) * static_cast<int64_t>(y[i]);
+	}
+	return static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint64_t>(s)));
+}
+
+// ctest runs this once per KALGEBRA_ISA cap, like the kernel suite
+CHECK_SUITE(lowprec) {
+	const KernelTable& k = Kernels();
+
+	// in range and far past it: all -128 (or -32768) products, plus a ragged tail
+	for (uint64_t n : { 5ull, 1000ull, 131071ull, 300001ull }) {
+		std::vector<int8_t> x8(n, -128), y8(n, -128);
+		for (uint64_t i = 0; i < n; i += 7) {
+			y8[i] = 127;
+		}
+		CHECK(k.dot_i8(n, x8.data(), y8.data()) == _wrapped_dot(x8, y8));
+		CHECK(GetKernelsGeneric().dot_i8(n, x8.data(), y8.data()) == _wrapped_dot(x8, y8));
+
+		std::vector<int16_t> x16(n, -32768), y16(n, -32768);
+		for (uint64_t i = 0; i < n; i += 5) {
+			x16[i] = 32767;
+		}
+		CHECK(k.dot_i16(n, x16.data(), y16.data()) == _wrapped_dot(x16, y16));
+		CHECK(GetKernelsGeneric().dot_i16(n, x16.data(), y16.data()) == _wrapped_dot(x16, y16));
+	}
+
+	// fp16 / bf16 conversions at their edges
+	CHECK(FloatToHalf(1.0f) == 0x3C00);
+	CHECK(HalfToFloat(0x7BFF) == 65504.0f);
+	CHECK(FloatToHalf(1e6f) == 0x7C00);
+	CHECK(HalfToFloat(0x0001) == 5.9604644775390625e-8f);
+	CHECK(FloatToBFloat16(1.0f) == 0x3F80);
+	CHECK(BFloat16ToFloat(FloatToBFloat16(3.0f)) == 3.0f);
+
+	// fp16 / bf16 products accumulate in float
+	QMatrix<float> a = RandomQMatrix<float>(19, 70, 91);
+	QMatrix<float> b = RandomQMatrix<float>(70, 13, 92);
+	QMatrix<float> ab = a * b;
+	CHECK(MaxDiff(ConvertQMatrix<float>(ConvertQMatrix<Half>(a) * ConvertQMatrix<Half>(b)), ab) <= 0.05);
+	CHECK(MaxDiff(ConvertQMatrix<float>(ConvertQMatrix<BFloat16>(a) * ConvertQMatrix<BFloat16>(b)), ab) <= 0.3);
+
+	// quantized product against the float one, within the rounding of both operands
+	QMatrix<float> bt = b.Transpose();
+	CHECK(MaxDiff(QuantizedGemm(Quantize<int8_t>(a), Quantize<int8_t>(bt)), ab) <= 0.1);
+	CHECK(MaxDiff(QuantizedGemm(Quantize<int16_t>(a), Quantize<int16_t>(bt)), ab) <= 0.01);
+	CHECK(MaxDiff(Dequantize(Quantize<int8_t>(a)), a) <= 0.5f / 127.0f + 1e-6);
+
+	// an int8 product past the range saturates instead of wrapping
+	int8_t big[] = { 100, 100, 100, 100 };
+	QMatrix<int8_t> sq(big, 2, 2);
+	QMatrix<int8_t> prod = sq * sq;
+	CHECK(prod.GetItem(0, 0) == 127);
+	int8_t neg[] = { -100, -100 };
+	CHECK((QMatrix<int8_t>(neg, 1, 2) * sq).GetItem(0, 1) == -128);
+	int8_t mixed[] = { -100, 100 };
+	CHECK((QMatrix<int8_t>(mixed, 1, 2) * sq).GetItem(0, 0) == 0);
+}
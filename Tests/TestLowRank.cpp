@@ -0,0 +1,69 @@
+#include "Check.hpp"
+#include "LowRank.hpp"
+#include "QMatrix.hpp"
+#include "TiledQMatrix.hpp"
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static QMatrix<double> _pick(const QMatrix<double>& a, const std::vector<uint64_t>& rows, const std::vector<uint64_t>& cols) {
+	std::vector<double> v(rows.size() * cols.size());
+	for (size_t i = 0; i < rows.size(); ++i) {
+		for (size_t j = 0; j < cols.size(); ++j) {
+			v[i * cols.size() + j] = a.GetItem(rows[i], cols[j]);
+		}
+	}
+	return QMatrix<double>(v.data(), rows.size(), cols.size());
+}
+
+static std::vector<uint64_t> _all(uint64_t n) {
+	std::vector<uint64_t> res(n);
+	for (uint64_t i = 0; i < n; ++i) {
+		res[i] = i;
+	}
+	return res;
+}
+
+// exactly rank 5, so every method recovers A up to rounding
+CHECK_SUITE(lowrank) {
+	uint64_t n = 120, m = 80, r = 5;
+	QMatrix<double> a = RandomQMatrix<double>(n, r, 111) * RandomQMatrix<double>(r, m, 112);
+
+	// one-sided Jacobi on a small dense factor
+	QMatrix<double> s = RandomQMatrix<double>(9, 6, 113);
+	auto svd = JacobiSVD<double>(s.View());
+	CHECK(MaxDiff(svd[0] * svd[1] * svd[2].Transpose(), s) <= 1e-12);
+	CHECK(MaxDiff(svd[0].Transpose() * svd[0], DenseIdentity<double>(6)) <= 1e-12);
+	CHECK(svd[1].GetItem(0, 0) >= svd[1].GetItem(5, 5));
+
+	for (SketchKind kind : { SketchKind::Gaussian, SketchKind::SparseSign }) {
+		SketchOptions opt;
+		opt.kind = kind;
+		auto usv = RandomizedSVD(a, r, opt);
+		CHECK(MaxDiff(usv[0] * usv[1] * usv[2].Transpose(), a) <= 1e-10);
+		CHECK_NEAR(usv[1].GetItem(0, 0), a.OpNorm(), 1e-8);
+	}
+
+	auto cid = ColumnID(a, r);
+	CHECK(MaxDiff(_pick(a, _all(n), cid.idx) * cid.x, a) <= 1e-10);
+	auto rid = RowID(a, r);
+	CHECK(MaxDiff(rid.x * _pick(a, rid.idx, _all(m)), a) <= 1e-10);
+	auto cur = CUR(a, r);
+	CHECK(MaxDiff(cur.c * cur.u * cur.r, a) <= 1e-9);
+
+	// positive semidefinite of rank 5
+	QMatrix<double> g = RandomQMatrix<double>(n, r, 114);
+	QMatrix<double> psd = g * g.Transpose();
+	auto ul = Nystrom(psd, r);
+	CHECK(MaxDiff(ul[0] * ul[1] * ul[0].Transpose(), psd) <= 1e-9);
+
+	// the same sketch streamed from a tiled file
+	std::string path = (std::filesystem::temp_directory_path() / "kalgebra_lowrank.bin").string();
+	{
+		TiledQMatrix<double> ta(path, n, m, 32, 4);
+		ta.Load(a.View());
+		auto tusv = RandomizedSVD(ta, r);
+		CHECK(MaxDiff(tusv[0] * tusv[1] * tusv[2].Transpose(), a) <= 1e-10);
+	}
+	std::filesystem::remove(path);
+}
@@ -0,0 +1,45 @@
+#include "Check.hpp"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+static std::map<std::string, CheckFn>& _suites() {
+	static std::map<std::string, CheckFn> suites;
+	return suites;
+}
+
+static int _failures = 0;
+
+bool RegisterSuite(const char* name, CheckFn fn) {
+	_suites()[name] = fn;
+	return true;
+}
+
+void CheckFailed(const char* file, int line, const char* expr) {
+	fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+	++_failures;
+}
+
+// kalgebra_tests [suite...], no argument runs every suite
+int main(int argc, char** argv) {
+	int missing = 0;
+	if (argc < 2) {
+		for (const auto& s : _suites()) {
+			printf("[%s]\n", s.first.c_str());
+			s.second();
+		}
+	}
+	for (int i = 1; i < argc; ++i) {
+		auto it = _suites().find(argv[i]);
+		if (it == _suites().end()) {
+			fprintf(stderr, "no suite named %s\n", argv[i]);
+			++missing;
+			continue;
+		}
+		printf("[%s]\n", argv[i]);
+		it->second();
+	}
+	printf("%d failed check(s)\n", _failures);
+	return _failures == 0 && missing == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#include "Check.hpp"
+#include "MatrixFunctions.hpp"
+#include "QMatrix.hpp"
+#include <cmath>
+#include <complex>
+#include <vector>
+
+CHECK_SUITE(matrix_functions) {
+	// Inverse of a matrix past one block, against the identity on both sides
+	uint64_t n = 150;
+	QMatrix<double> a = RegularQMatrix<double>(n, 141);
+	QMatrix<double> inv = Inverse(a);
+	CHECK(MaxDiff(inv * a, DenseIdentity<double>(n)) <= 1e-12);
+	CHECK(MaxDiff(a * inv, DenseIdentity<double>(n)) <= 1e-12);
+
+	QMatrix<std::complex<double>> za = RegularQMatrix<std::complex<double>>(20, 142);
+	CHECK(MaxDiff(Inverse(za) * za, DenseIdentity<std::complex<double>>(20)) <= 1e-12);
+
+	// PseudoInverse of a rectangular matrix: A A+ A = A and A+ A A+ = A+
+	QMatrix<double> r = RandomQMatrix<double>(12, 7, 143);
+	QMatrix<double> pinv = PseudoInverse(r);
+	CHECK(pinv.GetN() == 7 && pinv.GetM() == 12);
+	CHECK(MaxDiff(r * pinv * r, r) <= 1e-12);
+	CHECK(MaxDiff(pinv * r * pinv, pinv) <= 1e-12);
+
+	// Expm of a generator of rotations is the rotation
+	double t = 1.3;
+	std::vector<double> gen = { 0.0, -t, t, 0.0 };
+	std::vector<double> rot = { std::cos(t), -std::sin(t), std::sin(t), std::cos(t) };
+	QMatrix<double> g(gen.data(), 2, 2);
+	QMatrix<double> e = Expm(g);
+	CHECK(MaxDiff(e, QMatrix<double>(rot.data(), 2, 2)) <= 1e-14);
+
+	// a large norm takes the squaring path, exp(A) = exp(A / 2)^2
+	QMatrix<double> big = RandomQMatrix<double>(40, 40, 144) * 3.0;
+	QMatrix<double> eb = Expm(big);
+	QMatrix<double> half = Expm(big * 0.5);
+	CHECK(MaxDiff(half * half, eb) <= 1e-11 * MaxDiff(eb, eb * 0.0));
+
+	// the vector overload matches one by one
+	std::vector<QMatrix<double>> as = { g, big, RandomQMatrix<double>(40, 40, 145) };
+	std::vector<QMatrix<double>> es = Expm(as);
+	CHECK(es.size() == 3);
+	for (size_t i = 0; i < as.size() && i < es.size(); ++i) {
+		CHECK(MaxDiff(es[i], Expm(as[i])) == 0.0);
+	}
+
+	// Sqrtm of an SPD matrix squares back
+	QMatrix<double> x = RandomQMatrix<double>(30, 30, 146);
+	QMatrix<double> spd = x * x.Transpose() + DenseIdentity<double>(30) * 30.0;
+	QMatrix<double> s = Sqrtm(spd);
+	CHECK(MaxDiff(s * s, spd) <= 1e-10);
+
+	// Logm inverts Expm for a small argument
+	QMatrix<double> small = RandomQMatrix<double>(30, 30, 147) * 0.05;
+	CHECK(MaxDiff(Logm(Expm(small)), small) <= 1e-12);
+	CHECK(MaxDiff(Logm(DenseIdentity<double>(30)), DenseIdentity<double>(30) * 0.0) <= 1e-15);
+}
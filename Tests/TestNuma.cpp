@@ -0,0 +1,39 @@
+#include "Check.hpp"
+#include "Numa.hpp"
+#include "NumaQMatrix.hpp"
+#include "QMatrix.hpp"
+#include <atomic>
+#include <vector>
+
+// results do not depend on placement; on a single-node machine this runs the same code paths with one node
+CHECK_SUITE(numa) {
+	const NumaTopology& topo = NumaTopology::Get();
+	CHECK(topo.NodeCount() >= 1);
+	NumaPool pool(2);
+	printf("%u node(s)\n", pool.NodeCount());
+
+	// Split covers [0, count) in order
+	std::vector<uint64_t> split = pool.Split(1001);
+	CHECK(split.front() == 0 && split.back() == 1001);
+	std::atomic<uint64_t> covered{ 0 };
+	pool.ParallelFor(0, 1001, [&](uint64_t i) { covered += i; });
+	CHECK(covered.load() == 1001ull * 1000 / 2);
+
+	QMatrix<double> a = RandomQMatrix<double>(97, 61, 101);
+	QMatrix<double> b = RandomQMatrix<double>(61, 45, 102);
+	QMatrix<double> ab = a * b;
+	for (NumaPlacement p : { NumaPlacement::FirstTouch, NumaPlacement::Interleave, NumaPlacement::Partitioned }) {
+		NumaQMatrix<double> na(a.View(), p, pool);
+		NumaQMatrix<double> nb(b.View(), NumaPlacement::Interleave, pool);
+		NumaQMatrix<double> nc(97, 45, p, pool);
+		CHECK(MaxDiff(na.ToQMatrix(), a) == 0.0);
+		NumaGemm(na, nb, nc);
+		CHECK(MaxDiff(nc.ToQMatrix(), ab) <= 1e-12);
+
+		// y = 2 a + a, then every entry halved
+		NumaQMatrix<double> ny(a.View(), p, pool);
+		NumaAxpy(2.0, na, ny);
+		NumaTransform(ny, [](double x) { return x / 2; });
+		CHECK(MaxDiff(ny.ToQMatrix(), a * 1.5) <= 1e-15);
+	}
+}
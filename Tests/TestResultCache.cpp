@@ -0,0 +1,74 @@
+#include "Check.hpp"
+#include "QMatrix.hpp"
+#include "ResultCache.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+CHECK_SUITE(cache) {
+	ResultCache cache;
+	QMatrix<double> a = RegularQMatrix<double>(30, 131);
+	QMatrix<double> same = a;
+	QMatrix<double> other = RegularQMatrix<double>(30, 132);
+
+	// equal content hashes and compares equal, a different matrix does not
+	CHECK(a.Hash() == same.Hash());
+	CHECK(a == same);
+	CHECK(!(a == other));
+
+	// the second request, also through an equal copy, is a hit with the same value
+	CHECK_NEAR(CachedDet(a, cache), a.Det(), 0.0);
+	CHECK_NEAR(CachedDet(same, cache), a.Det(), 0.0);
+	CHECK(cache.Hits() == 1 && cache.Misses() == 1);
+	CHECK_NEAR(CachedDet(other, cache), other.Det(), 0.0);
+	CHECK(cache.Misses() == 2);
+
+	CHECK(MaxDiff(CachedProduct(a, other, cache), a * other) == 0.0);
+	CHECK(MaxDiff(CachedProduct(a, other, cache), a * other) == 0.0);
+	CHECK(cache.Hits() == 2 && cache.Size() == 3);
+
+	// a write through a view taken before Hash() leaves the hash stale, the byte compare still misses
+	QMatrix<double> b = a;
+	QMatrixView<double> v = b.View();
+	CHECK_NEAR(CachedDet(b, cache), a.Det(), 0.0);
+	v(0, 0) += 1.0;
+	double fresh = b.Det();
+	CHECK(fresh != a.Det());
+	CHECK_NEAR(CachedDet(b, cache), fresh, 0.0);
+
+	// a throwing computation caches nothing
+	bool thrown = false;
+	try {
+		cache.GetOrCompute<double>(CacheOp::User, { &a }, []() -> double { throw std::runtime_error("compute"); });
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	CHECK(thrown);
+	CHECK(cache.GetOrCompute<double>(CacheOp::User, { &a }, [] { return 7.0; }) == 7.0);
+
+	// concurrent requests for one key share a single computation
+	ResultCache shared;
+	std::atomic<int> computed{ 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 8; ++t) {
+		threads.emplace_back([&] {
+			shared.GetOrCompute<double>(CacheOp::User, { &other }, [&] {
+				computed++;
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				return 1.0;
+			});
+		});
+	}
+	for (std::thread& t : threads) {
+		t.join();
+	}
+	CHECK(computed.load() == 1);
+	CHECK(shared.Hits() == 7);
+
+	// past the capacity the least recently used entries go
+	cache.SetCapacity(_result_bytes(a) * 2 + 64);
+	CHECK(cache.Bytes() <= cache.Capacity());
+	CHECK(cache.Size() >= 1);
+}
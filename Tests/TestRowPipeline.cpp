@@ -0,0 +1,73 @@
+#include "Check.hpp"
+#include "QMatrix.hpp"
+#include "RowPipeline.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+	// collects the sink batches into one row-major matrix, checking they arrive in order
+	struct Collector {
+		std::vector<double> data;
+		uint64_t rows = 0;
+		bool ordered = true;
+
+		RowPipeline<double>::Sink Sink() {
+			return [this](QMatrixView<const double> batch, uint64_t first_row) {
+				ordered = ordered && first_row == rows;
+				for (uint64_t i = 0; i < batch.GetN(); ++i) {
+					for (uint64_t j = 0; j < batch.GetM(); ++j) {
+						data.push_back(batch(i, j));
+					}
+				}
+				rows += batch.GetN();
+			};
+		}
+	};
+
+}
+
+CHECK_SUITE(row_pipeline) {
+	uint64_t n = 1000, cols = 24, k = 9;
+	QMatrix<double> x = RandomQMatrix<double>(n, cols, 151);
+	QMatrix<double> w = RandomQMatrix<double>(cols, k, 152);
+	QMatrix<double> ones(std::vector<double>(SAFE_UINT(n * k), 1.0).data(), n, k);
+
+	// scalar stages folded into the GEMM, batches that do not divide the rows
+	RowPipeline<double> folded(cols, 300);
+	folded.Add(0.5).Mul(2.0).Multiply(w).Sub(1.5).Mul(0.25);
+	CHECK(folded.OutCols() == k);
+	Collector out;
+	CHECK(folded.Run(ViewRowReader<double>(x.View()), out.Sink()) == n);
+	CHECK(out.ordered && out.rows == n);
+	QMatrix<double> want = ((x + 0.5) * 2.0 * w - ones * 1.5) * 0.25;
+	CHECK(MaxDiff(QMatrix<double>(out.data.data(), n, k), want) <= 1e-12);
+
+	// scalar stages only, in place
+	RowPipeline<double> scalar(cols, 64);
+	scalar.Mul(3.0).Sub(1.0).Add(0.25);
+	Collector plain;
+	CHECK(scalar.Run(ViewRowReader<double>(x.View()), plain.Sink()) == n);
+	CHECK(MaxDiff(QMatrix<double>(plain.data.data(), n, cols), x * 3.0 - 1.0 + 0.25) <= 1e-14);
+
+	// binary stream round trip, a partial last row is dropped
+	std::stringstream in, res;
+	in.write(reinterpret_cast<const char*>(out.data.data()), 10 * k * sizeof(double) + 3);
+	RowPipeline<double> copy(k, 4);
+	CHECK(copy.Run(StreamRowReader<double>(in, k), StreamRowWriter<double>(res)) == 10);
+	CHECK(res.str().size() == 10 * k * sizeof(double));
+	CHECK(res.str().compare(0, res.str().size(), reinterpret_cast<const char*>(out.data.data()), 10 * k * sizeof(double)) == 0);
+
+	// an empty input and a throwing reader
+	Collector none;
+	CHECK(folded.Run([](double*, uint64_t) -> uint64_t { return 0; }, none.Sink()) == 0 && none.rows == 0);
+	bool thrown = false;
+	try {
+		folded.Run([](double*, uint64_t) -> uint64_t { throw std::runtime_error("read"); }, none.Sink());
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	CHECK(thrown);
+}
@@ -0,0 +1,67 @@
+#include "Check.hpp"
+#include "QMatrix.hpp"
+#include "StructuredQMatrix.hpp"
+#include <complex>
+#include <vector>
+
+template<typename T>
+static void _structured_solves(double tol) {
+	uint64_t n = 24, m = 3;
+	QMatrix<T> b = RandomQMatrix<T>(n, m, 41);
+
+	// diagonal: row i of x is row i of b over d_i
+	std::vector<T> d = RandomValues<T>(n, 42);
+	for (T& x : d) {
+		x += static_cast<T>(2);
+	}
+	DiagonalQMatrix<T> dm(d);
+	CHECK(MaxDiff(dm * dm.Solve(b), b) <= tol);
+
+	// triangular, packed from a dense matrix
+	QMatrix<T> dense = RegularQMatrix<T>(n, 43);
+	TriangularQMatrix<T> lo(dense.View(), Triangle::Lower);
+	TriangularQMatrix<T> up(dense.View(), Triangle::Upper, true);
+	CHECK(MaxDiff(lo.ToQMatrix() * lo.Solve(b), b) <= tol);
+	CHECK(MaxDiff(up.ToQMatrix() * up.Solve(b), b) <= tol);
+
+	// Crout factors straight into packed storage
+	auto lu = DecomposeLUPacked(dense);
+	CHECK(MaxDiff(lu[0].ToQMatrix() * lu[1].ToQMatrix(), dense) <= tol);
+	CHECK(MaxDiff(dense * SolveLU(lu, b), b) <= tol);
+
+	// banded keeps only the band, products and solves agree with its dense form
+	BandedQMatrix<T> band(dense.View(), 2, 3);
+	QMatrix<T> band_dense = band.ToQMatrix();
+	CHECK(MaxDiff(band * b, band_dense * b) <= tol);
+	CHECK(MaxDiff(band_dense * band.Solve(b), b) <= tol);
+
+	// symmetric (Hermitian) positive definite: c c^H + n I
+	QMatrix<T> c = RandomQMatrix<T>(n, n, 44);
+	QMatrix<T> spd = c * c.Adjoint();
+	for (uint64_t i = 0; i < n; ++i) {
+		spd.View()(i, i) += static_cast<T>(n);
+	}
+	SymmetricQMatrix<T> sym(spd.View());
+	CHECK(MaxDiff(sym.ToQMatrix(), spd) <= tol);
+	CHECK(MaxDiff(sym * b, spd * b) <= tol);
+	QMatrix<T> l = sym.Cholesky().ToQMatrix();
+	CHECK(MaxDiff(l * l.Adjoint(), spd) <= tol * n);
+	CHECK(MaxDiff(spd * sym.CholeskySolve(b), b) <= tol * n);
+}
+
+CHECK_SUITE(structured) {
+	_structured_solves<double>(1e-11);
+	_structured_solves<std::complex<double>>(1e-11);
+
+	// failures come back as b or as empty factors, with one diagnostic each
+	double d[] = { 1, 0, 2 };
+	QMatrix<double> b = RandomQMatrix<double>(3, 2, 46);
+	CHECK(MaxDiff(DiagonalQMatrix<double>(d, 3).Solve(b), b) == 0.0);
+
+	double indefinite[] = { 1, 2, 2, 1 };
+	QMatrix<double> b2 = RandomQMatrix<double>(2, 1, 47);
+	CHECK(MaxDiff(SymmetricQMatrix<double>(QMatrix<double>(indefinite, 2, 2).View()).CholeskySolve(b2), b2) == 0.0);
+
+	auto lu = DecomposeLUPacked(RandomQMatrix<double>(3, 4, 48));
+	CHECK(lu[0].GetN() == 0 && lu[1].GetN() == 0);
+}
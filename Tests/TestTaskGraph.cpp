@@ -0,0 +1,78 @@
+#include "Check.hpp"
+#include "QMatrix.hpp"
+#include "TaskGraph.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+
+CHECK_SUITE(taskgraph) {
+	ThreadPool pool(4);
+
+	// every index exactly once, also from inside a job of the same pool
+	std::vector<std::atomic<int>> hits(1000);
+	pool.Submit([&] {
+		pool.ParallelFor(0, hits.size(), [&](uint64_t i) { hits[i]++; }, 7);
+	}).get();
+	int wrong = 0;
+	for (auto& h : hits) {
+		wrong += h.load() != 1;
+	}
+	CHECK(wrong == 0);
+
+	// the first exception of a body comes back on the caller
+	bool thrown = false;
+	try {
+		pool.ParallelFor(0, 100, [](uint64_t i) {
+			if (i == 42) {
+				throw std::runtime_error("body");
+			}
+		});
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	CHECK(thrown);
+
+	// (a b + c) and det a as a graph, against the same operations run directly
+	QMatrix<double> a = RegularQMatrix<double>(40, 31);
+	QMatrix<double> b = RandomQMatrix<double>(40, 40, 32);
+	QMatrix<double> c = RandomQMatrix<double>(40, 40, 33);
+	TaskGraph g(pool);
+	auto na = g.Value(a);
+	auto nab = AsyncProduct(g, na, g.Add([&] { return b; }));
+	auto sum = AsyncSum(g, nab, g.Value(c));
+	auto det = AsyncDet(g, na);
+	CHECK(MaxDiff(sum.Get(), a * b + c) <= 1e-12);
+	CHECK_NEAR(det.Get() / a.Det(), 1.0, 1e-12);
+
+	// det from the pivoted L U factors: permuted rows, a zero leading pivot, singular and integer input
+	double swap[] = { 0, 1, 1, 0 };
+	double small[] = { 1, 2, 3, 4, 5, 6, 7, 8, 10 };
+	double singular[] = { 1, 2, 3, 2, 4, 6, 1, 0, 1 };
+	for (const QMatrix<double>& x : { QMatrix<double>(swap, 2, 2), QMatrix<double>(small, 3, 3),
+		QMatrix<double>(singular, 3, 3), a }) {
+		CHECK_NEAR(AsyncDet(g, AsyncDecomposeLU(g, g.Value(x))).Get(), x.Det(), 1e-12 * std::abs(x.Det()) + 1e-12);
+	}
+	std::complex<double> zs[] = { { 0, 1 }, { 2, 0 }, { 1, 1 }, { 0, -1 } };
+	QMatrix<std::complex<double>> z(zs, 2, 2);
+	CHECK_NEAR(AsyncDet(g, AsyncDecomposeLU(g, g.Value(z))).Get(), z.Det(), 1e-12);
+	int is[] = { 0, 2, 1, 3 };
+	QMatrix<int> iz(is, 2, 2);
+	CHECK_NEAR(AsyncDet(g, AsyncDecomposeLU(g, g.Value(iz))).Get(), -2.0, 0.0);
+
+	// a failed node fails everything after it
+	auto bad = g.Add([]() -> QMatrix<double> { throw std::runtime_error("node"); });
+	auto after = AsyncSum(g, bad, g.Value(c));
+	thrown = false;
+	try {
+		after.Get();
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	CHECK(thrown);
+	g.Wait();
+}
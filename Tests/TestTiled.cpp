@@ -0,0 +1,49 @@
+#include "Check.hpp"
+#include "QMatrix.hpp"
+#include "TiledQMatrix.hpp"
+#include <filesystem>
+#include <string>
+
+static std::string _tile_path(const char* name) {
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// small tiles and caches well below the matrix size, so tiles are evicted, written back and read again
+CHECK_SUITE(tiled) {
+	std::string pa = _tile_path("kalgebra_tiled_a.bin");
+	std::string pb = _tile_path("kalgebra_tiled_b.bin");
+	std::string pc = _tile_path("kalgebra_tiled_c.bin");
+
+	QMatrix<double> a = RandomQMatrix<double>(70, 50, 21);
+	QMatrix<double> b = RandomQMatrix<double>(50, 40, 22);
+	{
+		TiledQMatrix<double> ta(pa, 70, 50, 16, 3);
+		TiledQMatrix<double> tb(pb, 50, 40, 16, 3);
+		TiledQMatrix<double> tc(pc, 70, 40, 16, 3);
+		ta.Load(a.View());
+		tb.Load(b.View());
+		TiledGemm(ta, tb, tc);
+		CHECK(MaxDiff(tc.ToQMatrix(), a * b) <= 1e-12);
+		CHECK_NEAR(ta.GetItem(69, 49), a.GetItem(69, 49), 0.0);
+	}
+
+	// everything was flushed by the destructor, the file reopens with the same content
+	{
+		TiledQMatrix<double> ta(pa, 70, 50, 16, 2, TileFile::Open);
+		CHECK(MaxDiff(ta.ToQMatrix(), a) == 0.0);
+	}
+
+	// blocked LU over tile rows, determinant against the in-memory one
+	QMatrix<double> s = RegularQMatrix<double>(60, 23);
+	{
+		TiledQMatrix<double> ts(pa, 60, 60, 16, 10);
+		ts.Load(s.View());
+		TiledLU(ts);
+		double det = TiledLUDet(ts);
+		CHECK_NEAR(det / s.Det(), 1.0, 1e-10);
+	}
+
+	std::filesystem::remove(pa);
+	std::filesystem::remove(pb);
+	std::filesystem::remove(pc);
+}
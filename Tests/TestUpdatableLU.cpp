@@ -0,0 +1,46 @@
+#include "Check.hpp"
+#include "QMatrix.hpp"
+#include "UpdatableLU.hpp"
+#include <cmath>
+#include <vector>
+
+CHECK_SUITE(updatable_lu) {
+	uint64_t n = 30;
+	QMatrix<double> a = RegularQMatrix<double>(n, 81);
+	QMatrix<double> b = RandomQMatrix<double>(n, 2, 82);
+	QMatrix<double> u = RandomQMatrix<double>(n, 1, 83);
+	QMatrix<double> v = RandomQMatrix<double>(n, 1, 84);
+	QMatrix<double> updated = a + u * v.Transpose();
+
+	UpdatableLU<double> lu(a);
+	CHECK_NEAR(lu.Det() / a.Det(), 1.0, 1e-12);
+	CHECK(MaxDiff(a * lu.Solve(b), b) <= 1e-12);
+
+	// determinant lemma before the update, then the rank-1 update itself
+	CHECK_NEAR(lu.DetRatio(u, v) * a.Det() / updated.Det(), 1.0, 1e-10);
+	CHECK_NEAR(lu.LogAbsDet(), std::log(std::abs(a.Det())), 1e-10);
+	CHECK(lu.Update(u, v));
+	CHECK(MaxDiff(lu.Matrix(), updated) <= 1e-14);
+	CHECK_NEAR(lu.Det() / updated.Det(), 1.0, 1e-10);
+	CHECK(MaxDiff(updated * lu.Solve(b), b) <= 1e-10);
+
+	// row and column replacement
+	std::vector<double> row = RandomValues<double>(n, 85);
+	row[4] += n;
+	CHECK(lu.ReplaceRow(4, row.data()));
+	std::vector<double> col = RandomValues<double>(n, 86);
+	col[9] += n;
+	CHECK(lu.ReplaceCol(9, col.data()));
+	QMatrix<double> cur = lu.Matrix();
+	CHECK_NEAR(cur.GetItem(4, 0), row[0], 0.0);
+	CHECK_NEAR(cur.GetItem(0, 9), col[0], 0.0);
+	CHECK(MaxDiff(cur * lu.Solve(b), b) <= 1e-10);
+	CHECK_NEAR(lu.Det() / cur.Det(), 1.0, 1e-10);
+
+	// rank-3 Woodbury solve against the factors of the current matrix
+	QMatrix<double> uk = RandomQMatrix<double>(n, 3, 87);
+	QMatrix<double> vk = RandomQMatrix<double>(n, 3, 88);
+	QMatrix<double> x = lu.SolveWoodbury(uk, vk, b);
+	CHECK(MaxDiff((cur + uk * vk.Transpose()) * x, b) <= 1e-10);
+	CHECK_NEAR(lu.DetRatio(uk, vk) * cur.Det() / (cur + uk * vk.Transpose()).Det(), 1.0, 1e-10);
+}
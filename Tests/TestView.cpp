@@ -0,0 +1,90 @@
+#include "Check.hpp"
+#include "QMatrix.hpp"
+#include "QMatrixView.hpp"
+#include <complex>
+#include <vector>
+
+template<typename T>
+static std::vector<T> _reference_gemm(const std::vector<T>& a, const std::vector<T>& b, uint64_t n, uint64_t m, uint64_t p) {
+	std::vector<T> c(n * m, static_cast<T>(0));
+	for (uint64_t i = 0; i < n; ++i) {
+		for (uint64_t k = 0; k < p; ++k) {
+			for (uint64_t j = 0; j < m; ++j) {
+				c[i * m + j] += a[i * p + k] * b[k * m + j];
+			}
+		}
+	}
+	return c;
+}
+
+// every layout combination Gemm matches to a kernel gives the plain triple loop result
+template<typename T>
+static void _gemm_layouts(double tol) {
+	uint64_t n = 45, m = 38, p = 67;
+	std::vector<T> a = RandomValues<T>(n * p, 11), b = RandomValues<T>(p * m, 12);
+	std::vector<T> ref = _reference_gemm(a, b, n, m, p);
+	QMatrixView<const T> want = QMatrixView<const T>::Of(ref.data(), n, m, Layout::RowMajor);
+
+	// the same operands stored column-major
+	std::vector<T> a_cm(n * p), b_cm(p * m);
+	Copy<T>(QMatrixView<const T>::Of(a.data(), n, p, Layout::RowMajor), QMatrixView<T>::Of(a_cm.data(), n, p, Layout::ColMajor));
+	Copy<T>(QMatrixView<const T>::Of(b.data(), p, m, Layout::RowMajor), QMatrixView<T>::Of(b_cm.data(), p, m, Layout::ColMajor));
+
+	for (Layout la : { Layout::RowMajor, Layout::ColMajor }) {
+		for (Layout lb : { Layout::RowMajor, Layout::ColMajor }) {
+			for (Layout lc : { Layout::RowMajor, Layout::ColMajor }) {
+				std::vector<T> c(n * m);
+				QMatrixView<T> cv = QMatrixView<T>::Of(c.data(), n, m, lc);
+				Gemm<T>(QMatrixView<const T>::Of(la == Layout::RowMajor ? a.data() : a_cm.data(), n, p, la),
+					QMatrixView<const T>::Of(lb == Layout::RowMajor ? b.data() : b_cm.data(), p, m, lb), cv);
+				CHECK(MaxDiff<T>(cv, want) <= tol);
+			}
+		}
+	}
+
+	// a^T b through a transposed view of the column-major copy of a^T, which is a itself
+	std::vector<T> at(p * n);
+	Transpose<T>(QMatrixView<const T>::Of(a.data(), n, p, Layout::RowMajor), QMatrixView<T>::Of(at.data(), p, n, Layout::RowMajor));
+	std::vector<T> c(n * m);
+	Gemm<T>(QMatrixView<const T>::Of(at.data(), p, n, Layout::RowMajor).Transposed(),
+		QMatrixView<const T>::Of(b.data(), p, m, Layout::RowMajor), QMatrixView<T>::Of(c.data(), n, m, Layout::RowMajor));
+	CHECK(MaxDiff<T>(QMatrixView<const T>::Of(c.data(), n, m, Layout::RowMajor), want) <= tol);
+
+	// a submatrix view with a leading dimension wider than its rows
+	std::vector<T> sub(n * m);
+	Gemm<T>(QMatrixView<const T>::Of(a.data(), n, p, Layout::RowMajor).Sub(5, 3, 20, 30),
+		QMatrixView<const T>::Of(b.data(), p, m, Layout::RowMajor).Sub(3, 0, 30, m),
+		QMatrixView<T>::Of(sub.data(), 20, m, Layout::RowMajor));
+	T s = static_cast<T>(0);
+	for (uint64_t k = 0; k < 30; ++k) {
+		s += a[(5 + 7) * p + 3 + k] * b[(3 + k) * m + 11];
+	}
+	CHECK_NEAR(sub[7 * m + 11], s, tol);
+}
+
+CHECK_SUITE(view) {
+	_gemm_layouts<float>(1e-4);
+	_gemm_layouts<double>(1e-12);
+	_gemm_layouts<std::complex<double>>(1e-12);
+
+	// a blocked transpose larger than one leaf, then back
+	uint64_t n = 131, m = 77;
+	std::vector<double> x = RandomValues<double>(n * m, 13), xt(m * n), back(n * m);
+	Transpose<double>(QMatrixView<const double>::Of(x.data(), n, m, Layout::RowMajor), QMatrixView<double>::Of(xt.data(), m, n, Layout::RowMajor));
+	CHECK(xt[5 * n + 100] == x[100 * m + 5]);
+	Transpose<double>(QMatrixView<const double>::Of(xt.data(), m, n, Layout::RowMajor), QMatrixView<double>::Of(back.data(), n, m, Layout::RowMajor));
+	CHECK(back == x);
+
+	// a^H b as conj_a on a transposed view
+	uint64_t k = 9;
+	std::vector<std::complex<double>> za = RandomValues<std::complex<double>>(k * 4, 14), zb = RandomValues<std::complex<double>>(k * 3, 15);
+	std::vector<std::complex<double>> zc(4 * 3);
+	Gemm<std::complex<double>>(QMatrixView<const std::complex<double>>::Of(za.data(), k, 4, Layout::RowMajor).Transposed(),
+		QMatrixView<const std::complex<double>>::Of(zb.data(), k, 3, Layout::RowMajor),
+		QMatrixView<std::complex<double>>::Of(zc.data(), 4, 3, Layout::RowMajor), true);
+	std::complex<double> s = 0.0;
+	for (uint64_t i = 0; i < k; ++i) {
+		s += std::conj(za[i * 4 + 2]) * zb[i * 3 + 1];
+	}
+	CHECK_NEAR(zc[2 * 3 + 1], s, 1e-12);
+}